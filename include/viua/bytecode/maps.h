@@ -25,6 +25,15 @@ const std::map<std::string, unsigned> OP_SIZES = {
     { "igt",    sizeof(byte) + 3*sizeof(bool) + 3*sizeof(int) },
     { "igte",   sizeof(byte) + 3*sizeof(bool) + 3*sizeof(int) },
     { "ieq",    sizeof(byte) + 3*sizeof(bool) + 3*sizeof(int) },
+    { "tiadd", sizeof(byte) + 3*sizeof(bool) + 3*sizeof(int) },
+    { "tisub", sizeof(byte) + 3*sizeof(bool) + 3*sizeof(int) },
+    { "timul", sizeof(byte) + 3*sizeof(bool) + 3*sizeof(int) },
+    { "tidiv", sizeof(byte) + 3*sizeof(bool) + 3*sizeof(int) },
+    { "tilt",  sizeof(byte) + 3*sizeof(bool) + 3*sizeof(int) },
+    { "tilte", sizeof(byte) + 3*sizeof(bool) + 3*sizeof(int) },
+    { "tigt",  sizeof(byte) + 3*sizeof(bool) + 3*sizeof(int) },
+    { "tigte", sizeof(byte) + 3*sizeof(bool) + 3*sizeof(int) },
+    { "tieq",  sizeof(byte) + 3*sizeof(bool) + 3*sizeof(int) },
 
     { "fstore", sizeof(byte) + sizeof(bool) + sizeof(int) + sizeof(float) },
     { "fadd",   sizeof(byte) + 3*sizeof(bool) + 3*sizeof(int) },
@@ -92,6 +101,12 @@ const std::map<std::string, unsigned> OP_SIZES = {
     { "param",  sizeof(byte) + 2*sizeof(bool) + 2*sizeof(int) },
     { "paref",  sizeof(byte) + 2*sizeof(bool) + 2*sizeof(int) },
     { "call",   sizeof(byte) + sizeof(bool) + sizeof(int) },
+    { "tailcall", sizeof(byte) },
+    { "spawn", sizeof(byte) },
+    { "coroutine", sizeof(byte) + sizeof(bool) + sizeof(int) },
+    { "resume", sizeof(byte) + 2*sizeof(bool) + 2*sizeof(int) },
+    { "yield", sizeof(byte) + sizeof(bool) + sizeof(int) },
+    { "wait", sizeof(byte) + 2*sizeof(bool) + 2*sizeof(int) },
     { "arg",    sizeof(byte) + 2*sizeof(bool) + 2*sizeof(int) },
     { "argc",   sizeof(byte) + sizeof(bool) + sizeof(int) },
 
@@ -138,6 +153,15 @@ const std::map<enum OPCODE, std::string> OP_NAMES = {
     { IGT,      "igt" },
     { IGTE,     "igte" },
     { IEQ,      "ieq" },
+    { TIADD,    "tiadd" },
+    { TISUB,    "tisub" },
+    { TIMUL,    "timul" },
+    { TIDIV,    "tidiv" },
+    { TILT,     "tilt" },
+    { TILTE,    "tilte" },
+    { TIGT,     "tigt" },
+    { TIGTE,    "tigte" },
+    { TIEQ,     "tieq" },
 
     { FSTORE,   "fstore" },
     { FADD,     "fadd" },
@@ -205,6 +229,12 @@ const std::map<enum OPCODE, std::string> OP_NAMES = {
     { PARAM,    "param" },
     { PAREF,    "paref" },
     { CALL,     "call" },
+    { TAILCALL, "tailcall" },
+    { SPAWN, "spawn" },
+    { COROUTINE, "coroutine" },
+    { RESUME, "resume" },
+    { YIELD, "yield" },
+    { WAIT, "wait" },
     { ARG,      "arg" },
     { ARGC,     "argc" },
 
@@ -240,6 +270,9 @@ const std::vector<enum OPCODE> OP_VARIABLE_LENGTH = {
     CLOSURE,
     FUNCTION,
     CALL,
+    TAILCALL,
+    SPAWN,
+    COROUTINE,
     CATCH,
     ENTER,
     IMPORT,
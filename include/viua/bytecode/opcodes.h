@@ -23,6 +23,17 @@ enum OPCODE : byte {
     IGTE,
     IEQ,
 
+    // integer instructions with operands proven to be Integers by the assembler (see src/front/asm/typeinference.cpp)
+    TIADD,
+    TISUB,
+    TIMUL,
+    TIDIV,
+    TILT,
+    TILTE,
+    TIGT,
+    TIGTE,
+    TIEQ,
+
     // float instructions
     FSTORE,
     FADD,
@@ -99,6 +110,12 @@ enum OPCODE : byte {
     PARAM,  // copy object from a register to parameter register (pass-by-value),
     PAREF,  // create a reference to an object in a parameter register (pass-by-reference),
     CALL,   // call given function with parameters set in parameter register,
+    TAILCALL,   // call given function in place of the current one (it returns directly to the caller of current function)
+    SPAWN,      // start given function as a new process
+    COROUTINE,  // start given function as a coroutine (it is suspended until resumed)
+    RESUME,     // resume a coroutine until it yields a value or returns
+    YIELD,      // suspend current coroutine and pass a value to the function that resumed it
+    WAIT,       // wait until a future (returned by a blocking foreign function) is resolved and take its value
     ARG,    // move an object from argument register to a normal register (inside a function call),
     ARGC,   // store number of supplied parameters in a register
 
@@ -33,6 +33,15 @@ namespace cg {
         byte* igt(byte*, int_op, int_op, int_op);
         byte* igte(byte*, int_op, int_op, int_op);
         byte* ieq(byte*, int_op, int_op, int_op);
+        byte* tiadd(byte*, int_op, int_op, int_op);
+        byte* tisub(byte*, int_op, int_op, int_op);
+        byte* timul(byte*, int_op, int_op, int_op);
+        byte* tidiv(byte*, int_op, int_op, int_op);
+        byte* tilt(byte*, int_op, int_op, int_op);
+        byte* tilte(byte*, int_op, int_op, int_op);
+        byte* tigt(byte*, int_op, int_op, int_op);
+        byte* tigte(byte*, int_op, int_op, int_op);
+        byte* tieq(byte*, int_op, int_op, int_op);
 
         byte* fstore(byte*, int_op, float);
         byte* fadd(byte*, int_op, int_op, int_op);
@@ -90,6 +99,12 @@ namespace cg {
         byte* arg(byte*, int_op, int_op);
         byte* argc(byte*, int_op);
         byte* call(byte*, int_op, const std::string&);
+        byte* tailcall(byte*, const std::string&);
+        byte* spawn(byte*, const std::string&);
+        byte* coroutine(byte*, int_op, const std::string&);
+        byte* resume(byte*, int_op, int_op);
+        byte* yield(byte*, int_op);
+        byte* wait(byte*, int_op, int_op);
 
         byte* jump(byte*, int);
         byte* branch(byte*, int_op, int, int);
@@ -3,15 +3,17 @@
 
 #pragma once
 
-#include <dlfcn.h>
 #include <cstdint>
+#include <memory>
 #include <string>
 #include <vector>
 #include <map>
+#include <unordered_map>
 #include <tuple>
 #include <unordered_set>
 #include <utility>
 #include <algorithm>
+#include <functional>
 #include <stdexcept>
 #include <viua/bytecode/bytetypedef.h>
 #include <viua/types/type.h>
@@ -19,6 +21,10 @@
 #include <viua/cpu/registerset.h>
 #include <viua/cpu/frame.h>
 #include <viua/cpu/tryframe.h>
+#include <viua/cpu/scheduler.h>
+#include <viua/cpu/image.h>
+#include <viua/cpu/pool.h>
+#include <viua/types/coroutine.h>
 #include <viua/include/module.h>
 
 
@@ -32,16 +38,149 @@ class HaltException : public std::runtime_error {
 };
 
 
+/*  Execution profile of a function or a block.
+ */
+struct ProfileEntry {
+    std::string name;
+    bool is_block;
+
+    // extent of the function or block in bytecode
+    uint32_t begin;
+    uint32_t end;
+
+    // number of times its first instruction was executed, and
+    // number of its instructions that were executed
+    uint64_t entries;
+    uint64_t instructions;
+};
+
+
+class Function;
+
+
+/*  State of a program shared by all its processes:
+ *  loaded bytecode, linked modules, typesystem and foreign libraries.
+ *  It is freed when the last process running the program is destroyed.
+ */
+class Kernel {
+    public:
+        /*  Bytecode pointer is a pointer to program's code.
+         *  Size and executable offset are metadata exported from bytecode dump.
+         */
+        byte* bytecode;
+        uint32_t bytecode_size;
+        uint32_t executable_offset;
+
+        /*  Image the bytecode belongs to (if the program was loaded from a shared image).
+         *  Bytecode given to the CPU as a plain pointer is owned by the kernel.
+         */
+        std::shared_ptr<const ModuleImage> image;
+
+        // Map of the typesystem currently existing inside the VM.
+        std::map<std::string, Prototype*> typesystem;
+
+        /*  Function and block names mapped to bytecode addresses.
+         */
+        std::unordered_map<std::string, unsigned> function_addresses;
+        std::unordered_map<std::string, unsigned> block_addresses;
+
+        /*  Sizes of local register sets required by functions (recorded by the assembler).
+         *  Frames of functions listed here are allocated with exactly this number of registers.
+         */
+        std::unordered_map<std::string, unsigned> function_registers;
+
+        /*  Linked modules point into images of libraries, which are shared with
+         *  other programs linking the same modules.
+         */
+        std::unordered_map<std::string, std::pair<std::string, byte*>> linked_functions;
+        std::unordered_map<std::string, std::pair<std::string, byte*>> linked_blocks;
+        std::map<std::string, std::pair<unsigned, byte*> > linked_modules;
+        std::map<std::string, std::shared_ptr<const ModuleImage>> linked_images;
+
+        /*  This is the interface between programs compiled to VM bytecode and
+         *  extension libraries written in C++.
+         */
+        std::map<std::string, ExternalFunction*> foreign_functions;
+
+        /** This is the mapping Viua uses to dispatch methods on pure-C++ classes.
+         */
+        std::map<std::string, ForeignMethod> foreign_methods;
+
+        // foreign libraries imported by the program (closed when the last program using them is gone)
+        std::vector<std::shared_ptr<const ForeignLibrary>> foreign_libraries;
+
+        /*  Foreign functions which may block, and threads on which calls to them are run.
+         *  Pool is destroyed (waiting for calls that are still running) before foreign libraries are closed.
+         */
+        std::unordered_set<std::string> blocking_functions;
+        BlockingCallPool blocking_calls;
+
+        // scheduler running processes of the program (set only while the program runs)
+        Scheduler* scheduler;
+
+        Kernel():
+            bytecode(nullptr), bytecode_size(0), executable_offset(0),
+            scheduler(nullptr)
+        {}
+
+        ~Kernel() {
+            /*  Destructor frees memory at bytecode pointer (unless it belongs to an image) so
+             *  make sure you passed a copy of the bytecode to the CPU if you want to keep it around after the CPU is finished.
+             */
+            if (bytecode and not image) { delete[] bytecode; }
+
+            std::map<std::string, Prototype*>::iterator pr = typesystem.begin();
+            while (pr != typesystem.end()) {
+                std::string proto_name = pr->first;
+                Prototype* proto_ptr = pr->second;
+
+                ++pr;
+
+                typesystem.erase(proto_name);
+                delete proto_ptr;
+            }
+        }
+};
+
+
+/*  State of a program after it was run for a budget of instructions.
+ */
+enum RUN_STATUS {
+    RUN_FINISHED,   // all processes of the program have finished, and its exit condition is set
+    RUN_PREEMPTED,  // budget was used up
+    RUN_WAITING,    // processes that have not finished are waiting for I/O
+};
+
+
 class CPU {
 #ifdef AS_DEBUG_HEADER
     public:
 #endif
-    /*  Bytecode pointer is a pointer to program's code.
-     *  Size and executable offset are metadata exported from bytecode dump.
+    /*  Program run by this CPU.
+     *  Every CPU is a process, and processes spawned by a program share its kernel.
+     *  Members below refer to parts of the kernel.
      */
-    byte* bytecode;
-    uint16_t bytecode_size;
-    uint16_t executable_offset;
+    std::shared_ptr<Kernel> kernel;
+
+    byte*& bytecode;
+    uint32_t& bytecode_size;
+    uint32_t& executable_offset;
+
+    std::map<std::string, Prototype*>& typesystem;
+
+    std::unordered_map<std::string, unsigned>& function_addresses;
+    std::unordered_map<std::string, unsigned>& block_addresses;
+    std::unordered_map<std::string, unsigned>& function_registers;
+
+    std::unordered_map<std::string, std::pair<std::string, byte*>>& linked_functions;
+    std::unordered_map<std::string, std::pair<std::string, byte*>>& linked_blocks;
+    std::map<std::string, std::pair<unsigned, byte*> >& linked_modules;
+    std::map<std::string, std::shared_ptr<const ModuleImage>>& linked_images;
+
+    std::map<std::string, ExternalFunction*>& foreign_functions;
+    std::unordered_set<std::string>& blocking_functions;
+    std::map<std::string, ForeignMethod>& foreign_methods;
+    std::vector<std::shared_ptr<const ForeignLibrary>>& foreign_libraries;
 
     // Global register set
     RegisterSet* regset;
@@ -54,28 +193,29 @@ class CPU {
     // Static registers
     std::map<std::string, RegisterSet*> static_registers;
 
-    // Map of the typesystem currently existing inside the VM.
-    std::map<std::string, Prototype*> typesystem;
+    /*  String literals decoded by strstore instructions, and
+     *  sizes of their encoded forms, keyed by address of the literal in bytecode.
+     *  Escape sequences are decoded on first execution only.
+     */
+    std::unordered_map<byte*, std::pair<std::string, unsigned> > string_literals;
 
     /*  Call stack.
      */
     std::vector<Frame*> frames;
     Frame* frame_new;
 
+    /*  Coroutines that are running (the most recently resumed one is the last).
+     *  Their frames are on the call stack above frames of functions that resumed them.
+     */
+    std::vector<std::shared_ptr<Coroutine::State>> coroutines;
+
     /*  Block stack.
      */
     std::vector<TryFrame*> tryframes;
     TryFrame* try_frame_new;
 
-    /*  Function and block names mapped to bytecode addresses.
-     */
+    // Base address for jumps of currently executed function or block
     byte* jump_base;
-    std::map<std::string, unsigned> function_addresses;
-    std::map<std::string, unsigned> block_addresses;
-
-    std::map<std::string, std::pair<std::string, byte*>> linked_functions;
-    std::map<std::string, std::pair<std::string, byte*>> linked_blocks;
-    std::map<std::string, std::pair<unsigned, byte*> > linked_modules;
 
     /*  Slot for thrown objects (typically exceptions).
      *  Can be set by user code and the CPU.
@@ -93,14 +233,44 @@ class CPU {
     unsigned instruction_counter;
     byte* instruction_pointer;
 
-    /*  This is the interface between programs compiled to VM bytecode and
-     *  extension libraries written in C++.
+    /*  Set when the last instruction was a call to a foreign function that would block, and
+     *  what the function waits for.
+     *  The call is run again by the next tick.
+     */
+    bool waiting;
+    WouldBlock waiting_for;
+
+    /*  Set when loaded bytecode (and every module linked later) passed verification.
+     *  Control flow of verified bytecode is proven to stay inside functions so
+     *  per-instruction sanity checks can be skipped.
      */
-    std::map<std::string, ExternalFunction*> foreign_functions;
+    bool verified;
 
-    /** This is the mapping Viua uses to dispatch methods on pure-C++ classes.
+    /*  Execution profile (collected only when profiling is enabled).
+     *  Only functions and blocks placed in loaded bytecode are profiled;
+     *  code of dynamically linked modules is not.
+     */
+    bool profiling;
+    std::vector<ProfileEntry> profile_entries;
+    // index of the entry containing most recently executed instruction
+    unsigned profile_current;
+    void prepareProfile();
+    void profileInstruction(byte*);
+
+    /*  Number of worker threads running processes of the program, and
+     *  spawned processes that stopped because of an uncaught exception (function, exception, message).
      */
-    std::map<std::string, ForeignMethod> foreign_methods;
+    unsigned worker_threads;
+    std::vector<std::tuple<std::string, std::string, std::string>> process_failures;
+    void ensureSingleProcess(const std::string&);
+
+    /*  Scheduler of a program run for budgets of instructions (set by the first call to runFor()).
+     *  It is kept between the calls so the program can be resumed.
+     */
+    std::unique_ptr<Scheduler> budgeted_scheduler;
+
+    void startProgram();
+    void finishProgram(Scheduler&);
 
     /*  Methods to deal with registers.
      */
@@ -117,16 +287,34 @@ class CPU {
     TryFrame* requestNewTryFrame();
     void pushFrame();
     void dropFrame();
+    void unwind(TryFrame*);
     // call native (i.e. written in Viua) function
     byte* callNative(byte*, const std::string&, const bool&, const int&, const std::string&);
     // call foreign (i.e. from a C++ extension) function
     byte* callForeign(byte*, const std::string&, const bool&, const int&, const std::string&);
+    // call blocking foreign function on a background thread (caller receives a future)
+    byte* callBlocking(byte*, const std::string&, const bool&, const int&);
     // call foreign method (i.e. method of a pure-C++ class loaded into machine's typesystem)
     byte* callForeignMethod(byte*, Type*, const std::string&, const bool&, const int&, const std::string&);
 
+    /*  Functions provided by the machine itself.
+     *  They are called like foreign functions but, unlike foreign functions, can run code of the program.
+     */
+    typedef void (CPU::*BuiltinFunction)(Frame*);
+    static const std::map<std::string, BuiltinFunction> builtin_functions;
+
+    /*  Parallel functional primitives (std::functional::pmap, pfilter and preduce).
+     *  Vector is split into chunks, and each chunk is processed on its own thread by
+     *  a separate context sharing the kernel of this CPU.
+     */
+    Type* applyFunction(Function*, const std::vector<Type*>&);
+    bool processChunks(Function*, unsigned, const std::function<void(CPU*, Function*, unsigned, unsigned, std::vector<Type*>&)>&, std::vector<std::vector<Type*>>&);
+    void pmap(Frame*);
+    void pfilter(Frame*);
+    void preduce(Frame*);
+
     /*  Methods dealing with dynamic library loading.
      */
-    std::vector<void*> cxx_dynamic_lib_handles;
     void loadNativeLibrary(const std::string&);
     void loadForeignLibrary(const std::string&);
 
@@ -149,6 +337,19 @@ class CPU {
     byte* igte(byte*);
     byte* ieq(byte*);
 
+    /*  Integer instructions with operands proven to be Integers.
+     */
+    byte* typedIntegerOperands(byte*, int&, int&, int&);
+    byte* tiadd(byte*);
+    byte* tisub(byte*);
+    byte* timul(byte*);
+    byte* tidiv(byte*);
+    byte* tilt(byte*);
+    byte* tilte(byte*);
+    byte* tigt(byte*);
+    byte* tigte(byte*);
+    byte* tieq(byte*);
+
     byte* iinc(byte*);
     byte* idec(byte*);
 
@@ -197,6 +398,7 @@ class CPU {
     byte* tmpri(byte*);
     byte* tmpro(byte*);
 
+    byte* echo(byte*, const std::string&);
     byte* print(byte*);
     byte* echo(byte*);
 
@@ -213,8 +415,15 @@ class CPU {
     byte* argc(byte*);
 
     byte* call(byte*);
+    byte* tailcall(byte*);
+    byte* spawn(byte*);
     byte* end(byte*);
 
+    byte* coroutine(byte*);
+    byte* resume(byte*);
+    byte* yield(byte*);
+    byte* wait(byte*);
+
     byte* jump(byte*);
     byte* branch(byte*);
 
@@ -251,14 +460,16 @@ class CPU {
          *      * kick the CPU so it starts running,
          */
         CPU& load(byte*);
-        CPU& bytes(uint16_t);
-        CPU& eoffset(uint16_t);
+        CPU& load(std::shared_ptr<const ModuleImage>);
+        CPU& bytes(uint32_t);
+        CPU& eoffset(uint32_t);
         CPU& preload();
 
         CPU& mapfunction(const std::string&, unsigned);
         CPU& mapblock(const std::string&, unsigned);
+        CPU& mapregisters(const std::string&, unsigned);
 
-        CPU& registerExternalFunction(const std::string&, ExternalFunction*);
+        CPU& registerExternalFunction(const std::string&, ExternalFunction*, bool = false);
         CPU& removeExternalFunction(std::string);
 
         /// These two methods are used to inject pure-C++ classes into machine's typesystem.
@@ -273,16 +484,34 @@ class CPU {
         byte* dispatch(byte*);
         byte* tick();
 
+        std::string verify();
+        CPU& enableProfiling();
+        inline const std::vector<ProfileEntry>& profile() const { return profile_entries; }
         int run();
+        RUN_STATUS runFor(unsigned);
         inline unsigned counter() { return instruction_counter; }
+        inline bool waits() const { return waiting; }
+        inline const WouldBlock& waitsFor() const { return waiting_for; }
 
         inline std::tuple<int, std::string, std::string> exitcondition() {
             return std::tuple<int, std::string, std::string>(return_code, return_exception, return_message);
         }
         inline std::vector<Frame*> trace() { return frames; }
-
-        CPU():
-            bytecode(nullptr), bytecode_size(0), executable_offset(0),
+        inline const std::vector<std::tuple<std::string, std::string, std::string>>& failures() const { return process_failures; }
+
+        CPU& threads(unsigned);
+
+        CPU(): CPU(std::make_shared<Kernel>()) {}
+        explicit CPU(std::shared_ptr<Kernel> k):
+            kernel(k),
+            bytecode(kernel->bytecode), bytecode_size(kernel->bytecode_size), executable_offset(kernel->executable_offset),
+            typesystem(kernel->typesystem),
+            function_addresses(kernel->function_addresses), block_addresses(kernel->block_addresses),
+            function_registers(kernel->function_registers),
+            linked_functions(kernel->linked_functions), linked_blocks(kernel->linked_blocks),
+            linked_modules(kernel->linked_modules), linked_images(kernel->linked_images),
+            foreign_functions(kernel->foreign_functions), blocking_functions(kernel->blocking_functions), foreign_methods(kernel->foreign_methods),
+            foreign_libraries(kernel->foreign_libraries),
             regset(nullptr), uregset(nullptr),
             tmp(nullptr),
             static_registers({}),
@@ -292,15 +521,17 @@ class CPU {
             thrown(nullptr), caught(nullptr),
             return_code(0), return_exception(""), return_message(""),
             instruction_counter(0), instruction_pointer(nullptr),
+            waiting(false), waiting_for(),
+            verified(false),
+            profiling(false), profile_entries({}), profile_current(0),
+            worker_threads(1),
             debug(false), errors(false)
         {}
 
         ~CPU() {
-            /*  Destructor frees memory at bytecode pointer so make sure you passed a copy of the bytecode to the constructor
-             *  if you want to keep it around after the CPU is finished.
+            /*  Bytecode, linked modules, typesystem and foreign libraries are owned by the kernel, and
+             *  are freed when the last process of the program is destroyed.
              */
-            if (bytecode) { delete[] bytecode; }
-
             std::map<std::string, RegisterSet*>::iterator sr = static_registers.begin();
             while (sr != static_registers.end()) {
                 std::string  rkey = sr->first;
@@ -312,30 +543,9 @@ class CPU {
                 delete rset;
             }
 
-            std::map<std::string, std::pair<unsigned, byte*> >::iterator lm = linked_modules.begin();
-            while (lm != linked_modules.end()) {
-                std::string lkey = lm->first;
-                byte *ptr = lm->second.second;
-
-                ++lm;
-
-                linked_modules.erase(lkey);
-                delete[] ptr;
-            }
-
-            std::map<std::string, Prototype*>::iterator pr = typesystem.begin();
-            while (pr != typesystem.end()) {
-                std::string proto_name = pr->first;
-                Prototype* proto_ptr = pr->second;
-
-                ++pr;
-
-                typesystem.erase(proto_name);
-                delete proto_ptr;
-            }
-
-            for (unsigned i = 0; i < cxx_dynamic_lib_handles.size(); ++i) {
-                dlclose(cxx_dynamic_lib_handles[i]);
+            // register sets of frames are left alone if execution stopped because of an exception
+            if (frames.size() == 0) {
+                delete regset;
             }
         }
 };
@@ -18,12 +18,17 @@ class Frame {
 
         std::string function_name;
 
+        // set for frames of tail calls and spawned processes: their arguments are copies owned by the frame
+        // instead of pointers to objects in registers of the caller
+        bool owns_arguments;
+
         inline byte* ret_address() { return return_address; }
 
         Frame(byte* ra, int argsize, int regsize = 16):
             return_address(ra),
             args(nullptr), regset(nullptr),
-            place_return_value_in(0), resolve_return_value_register(false)
+            place_return_value_in(0), resolve_return_value_register(false),
+            owns_arguments(false)
         {
             args = new RegisterSet(argsize);
             regset = new RegisterSet(regsize);
@@ -37,7 +42,9 @@ class Frame {
         ~Frame() {
             // drop all pointers in arguments registers set
             // to precent double deallocation
-            args->drop();
+            if (not owns_arguments) {
+                args->drop();
+            }
 
             delete args;
             delete regset;
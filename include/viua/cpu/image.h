@@ -0,0 +1,67 @@
+#ifndef VIUA_CPU_IMAGE_H
+#define VIUA_CPU_IMAGE_H
+
+#pragma once
+
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <string>
+#include <tuple>
+#include <utility>
+#include <vector>
+#include <viua/bytecode/bytetypedef.h>
+#include <viua/include/module.h>
+
+
+/*  Loaded bytecode module: its code, and addresses of its functions and blocks.
+ *
+ *  Images are never modified after they are loaded so any number of CPUs, running on any threads, can
+ *  share one image.
+ *  They are reference counted, and freed when the last CPU using them is destroyed.
+ */
+class ModuleImage {
+    public:
+        const std::string path;
+
+        byte* const bytecode;
+        const uint32_t size;
+
+        const std::map<std::string, uint32_t> function_addresses;
+        const std::map<std::string, uint32_t> block_addresses;
+        const std::map<std::string, uint32_t> function_registers;
+
+        // set for libraries only: whether bytecode of the library passed verification
+        const bool verified;
+
+        static std::shared_ptr<const ModuleImage> executable(const std::string&);
+        static std::shared_ptr<const ModuleImage> library(const std::string&);
+
+        ModuleImage(const std::string&, byte*, uint32_t, const std::map<std::string, uint32_t>&, const std::map<std::string, uint32_t>&, const std::map<std::string, uint32_t>&, bool);
+        ModuleImage(const ModuleImage&) = delete;
+        ModuleImage& operator=(const ModuleImage&) = delete;
+        ~ModuleImage();
+};
+
+
+/*  Foreign library opened with dlopen(), and functions it exports.
+ *  Libraries are shared by CPUs the same way module images are.
+ */
+class ForeignLibrary {
+        void* handle;
+
+    public:
+        const std::string path;
+        // name, function, and whether the function is blocking
+        const std::vector<std::tuple<std::string, ExternalFunction*, bool>> functions;
+
+        static std::shared_ptr<const ForeignLibrary> open(const std::string&);
+
+        ForeignLibrary(const std::string&, void*, const std::vector<std::tuple<std::string, ExternalFunction*, bool>>&);
+        ForeignLibrary(const ForeignLibrary&) = delete;
+        ForeignLibrary& operator=(const ForeignLibrary&) = delete;
+        ~ForeignLibrary();
+};
+
+
+#endif
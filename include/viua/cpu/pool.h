@@ -0,0 +1,44 @@
+#ifndef VIUA_CPU_POOL_H
+#define VIUA_CPU_POOL_H
+
+#pragma once
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+
+// maximum number of threads running calls to blocking foreign functions of a program
+const unsigned BLOCKING_CALL_THREADS = 4;
+
+
+/*  Pool of background threads on which calls to blocking foreign functions are run.
+ *
+ *  Threads are started when calls are submitted (up to the limit), so programs that
+ *  do not call blocking functions do not pay for the pool.
+ *  Destroying the pool waits for calls that were already submitted.
+ */
+class BlockingCallPool {
+    const unsigned limit;
+
+    std::mutex lock;
+    std::condition_variable submitted;
+    std::deque<std::function<void()>> calls;
+    std::vector<std::thread> threads;
+    unsigned idle;
+    bool stopping;
+
+    void work();
+
+    public:
+        void submit(std::function<void()>);
+
+        BlockingCallPool(unsigned n = BLOCKING_CALL_THREADS): limit(n ? n : 1), idle(0), stopping(false) {}
+        ~BlockingCallPool();
+};
+
+
+#endif
@@ -0,0 +1,42 @@
+#ifndef VIUA_REACTOR_H
+#define VIUA_REACTOR_H
+
+#pragma once
+
+#include <atomic>
+#include <mutex>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+
+class CPU;
+
+
+/*  Event loop (based on epoll) in which processes wait for their file descriptors.
+ *
+ *  Process whose foreign call would block on a file descriptor is parked in the reactor instead of
+ *  being put back on a run queue, and is given back to the scheduler when the descriptor becomes ready.
+ *  This way a single VM multiplexes many pipes, sockets and terminals without
+ *  an OS thread per blocked operation.
+ */
+class Reactor {
+    int epoll_fd;
+
+    std::mutex lock;
+    // processes waiting for each file descriptor (with the events they wait for)
+    std::unordered_map<int, std::vector<std::pair<CPU*, unsigned>>> waiters;
+    std::atomic<unsigned> parked;
+
+    public:
+        bool park(CPU*, int, unsigned);
+        std::vector<CPU*> poll(int);
+        unsigned waiting() const;
+        std::vector<CPU*> release();
+
+        Reactor();
+        ~Reactor();
+};
+
+
+#endif
@@ -0,0 +1,29 @@
+#ifndef VIUA_ROUNDROBIN_H
+#define VIUA_ROUNDROBIN_H
+
+#pragma once
+
+#include <deque>
+#include <viua/cpu/cpu.h>
+
+
+/*  Runs programs loaded into several CPUs on calling thread.
+ *
+ *  Programs take turns, each running for the same budget of instructions, so an expensive program
+ *  delays the others by at most one budget per turn.
+ *  CPUs are not owned by the round robin.
+ */
+class RoundRobin {
+    unsigned budget;
+    std::deque<CPU*> programs;
+
+    public:
+        RoundRobin& add(CPU*);
+        CPU* step();
+        inline unsigned running() const { return static_cast<unsigned>(programs.size()); }
+
+        RoundRobin(unsigned b = PROCESS_TIME_SLICE): budget(b ? b : 1) {}
+};
+
+
+#endif
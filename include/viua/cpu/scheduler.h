@@ -0,0 +1,78 @@
+#ifndef VIUA_SCHEDULER_H
+#define VIUA_SCHEDULER_H
+
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <tuple>
+#include <vector>
+#include <viua/cpu/reactor.h>
+
+
+class CPU;
+
+
+// number of instructions a process executes before it is put back on a run queue
+const unsigned PROCESS_TIME_SLICE = 512;
+
+
+/*  Scheduler running processes of a program on a pool of worker threads (N:M scheduling).
+ *
+ *  Each worker has its own run queue and takes processes from its front.
+ *  Processes spawned by a process are put on the queue of the worker that runs it, and
+ *  a worker that has nothing to run steals processes from the back of other workers' queues.
+ */
+class Scheduler {
+    struct RunQueue {
+        std::mutex lock;
+        std::deque<CPU*> processes;
+    };
+
+    std::vector<std::unique_ptr<RunQueue>> queues;
+
+    // process that started the program (it is not deleted by the scheduler)
+    CPU* main_process;
+
+    // number of processes that have not finished yet
+    std::atomic<unsigned> alive;
+
+    std::mutex idle_lock;
+    std::condition_variable idle;
+
+    // processes waiting for I/O, polled by one worker at a time
+    Reactor reactor;
+    std::mutex poll_lock;
+
+    /*  Spawned processes that stopped because of an uncaught exception:
+     *  function the process was started with, exception type, and exception message.
+     */
+    std::mutex failures_lock;
+    std::vector<std::tuple<std::string, std::string, std::string>> failed;
+
+    void enqueue(unsigned, CPU*);
+    CPU* next(unsigned);
+    void finish(CPU*);
+    unsigned slice(unsigned, CPU*, unsigned);
+    void work(unsigned);
+
+    public:
+        Scheduler& spawn(CPU*);
+        Scheduler& start(CPU*);
+        unsigned processes() const;
+        inline unsigned workers() const { return static_cast<unsigned>(queues.size()); }
+        void run(CPU*);
+        unsigned runFor(unsigned);
+
+        inline const std::vector<std::tuple<std::string, std::string, std::string>>& failures() const { return failed; }
+
+        Scheduler(unsigned);
+        ~Scheduler();
+};
+
+
+#endif
@@ -0,0 +1,18 @@
+#ifndef VIUA_CPU_VERIFIER_H
+#define VIUA_CPU_VERIFIER_H
+
+#pragma once
+
+#include <unordered_map>
+#include <string>
+#include <viua/bytecode/bytetypedef.h>
+#include <viua/bytecode/opcodes.h>
+
+
+namespace verifier {
+    std::string operandkinds(OPCODE);
+    std::string verify(byte*, unsigned, const std::unordered_map<std::string, unsigned>&, const std::unordered_map<std::string, unsigned>&);
+}
+
+
+#endif
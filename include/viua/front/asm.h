@@ -3,9 +3,11 @@
 
 #pragma once
 
+#include <cstdint>
 #include <string>
 #include <vector>
 #include <map>
+#include <viua/bytecode/bytetypedef.h>
 
 
 struct invocables_t {
@@ -20,6 +22,41 @@ struct compilationflags_t {
     bool verbose;
     bool debug;
     bool scream;
+
+    // directory of compilation cache (empty if caching is disabled)
+    std::string cache;
+    // whether bytecode of individual functions and blocks should be cached
+    bool cache_functions;
+
+    // number of threads generating bytecode of functions and blocks
+    unsigned jobs;
+
+    // optimization level (0 disables optimizations)
+    unsigned optimize;
+    // functions and blocks which must not be removed even if they are not reachable
+    std::vector<std::string> keep;
+
+    // maximum number of instructions of inlined functions, and
+    // maximum number of instructions inlining may add to a single function
+    unsigned inline_limit;
+    unsigned inline_growth;
+
+    // profile used to lay out functions and blocks (empty if they are laid out in source order)
+    std::string profile_use;
+};
+
+struct linkedmodule_t {
+    std::string path;
+
+    uint32_t size;
+    byte* bytecode;
+
+    std::vector<unsigned> jumps;
+
+    std::vector<std::string> functions;
+    std::map<std::string, uint32_t> function_addresses;
+    std::map<std::string, uint32_t> function_registers;
+    std::map<std::string, uint32_t> block_addresses;
 };
 
 struct srcline_t {
@@ -38,6 +75,58 @@ std::vector<std::vector<std::string>> decode_line(const std::string&);
 int gatherFunctions(invocables_t*, const std::vector<std::string>&, const std::vector<std::string>&);
 int gatherBlocks(invocables_t*, const std::vector<std::string>&, const std::vector<std::string>&);
 
+namespace cache {
+    std::string key(const std::vector<std::string>&);
+    std::string directory(const std::string&);
+    bool fetch(const std::string&, const std::string&, std::string&);
+    bool store(const std::string&, const std::string&, const std::string&);
+}
+
+namespace peephole {
+    const std::vector<std::string>& rules();
+    std::map<std::string, unsigned> optimize(invocables_t&, invocables_t&, bool);
+}
+
+namespace liveness {
+    unsigned renumber(invocables_t&, bool);
+    std::map<std::string, unsigned> registers(const invocables_t&, const invocables_t&);
+    unsigned frames(invocables_t&, invocables_t&, const std::map<std::string, unsigned>&);
+}
+
+namespace inliner {
+    unsigned expand(invocables_t&, const invocables_t&, const std::vector<std::string>&, unsigned, unsigned);
+}
+
+namespace typeinference {
+    unsigned specialize(invocables_t&, bool);
+}
+
+namespace reachability {
+    struct report_t {
+        std::vector<std::string> functions;
+        std::vector<std::string> blocks;
+        uint64_t bytes_before;
+        uint64_t bytes_after;
+    };
+    report_t eliminate(invocables_t&, invocables_t&, const std::vector<std::string>&, const std::string&, const std::vector<std::string>&, std::vector<linkedmodule_t>&);
+}
+
+namespace layout {
+    struct profile_t {
+        // number of instructions executed in each function and block
+        std::map<std::string, uint64_t> functions;
+        std::map<std::string, uint64_t> blocks;
+    };
+    struct report_t {
+        bool arranged;
+        std::string reason;
+        unsigned hot_functions;
+        unsigned hot_blocks;
+    };
+    bool load(const std::string&, profile_t&);
+    report_t arrange(invocables_t&, invocables_t&, const profile_t&);
+}
+
 int generate(const std::vector<std::string>&, const std::map<unsigned, unsigned>&, std::vector<std::string>&, invocables_t&, invocables_t&, std::string&, std::string&, const std::vector<std::string>&, const compilationflags_t&);
 
 
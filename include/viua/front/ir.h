@@ -0,0 +1,95 @@
+#ifndef VIUA_FRONT_IR_H
+#define VIUA_FRONT_IR_H
+
+#pragma once
+
+#include <map>
+#include <set>
+#include <string>
+#include <utility>
+#include <vector>
+#include <viua/front/asm.h>
+
+
+namespace ir {
+    // register and its SSA version (version 0 is the empty register function is entered with)
+    typedef std::pair<unsigned, unsigned> value_t;
+
+    struct access_t {
+        // index of the operand, or -1 for implicit accesses (e.g. end reads register 0)
+        int operand;
+        unsigned reg;
+        unsigned version;
+    };
+
+    struct instruction_t {
+        std::string mnemonic;
+        // operands up to the first string operand (register operands are resolved to indexes)
+        std::vector<std::string> operands;
+        // the rest of the instruction, copied verbatim
+        std::string tail;
+
+        // role of each operand, see ir::roles()
+        std::string roles;
+        std::vector<access_t> uses;
+        std::vector<access_t> defs;
+
+        // jump targets (indexes of blocks), for jump and branch instructions
+        std::vector<unsigned> targets;
+    };
+
+    struct phi_t {
+        unsigned reg;
+        unsigned version;
+        // versions coming from predecessors (in order of block_t::predecessors)
+        std::vector<unsigned> operands;
+    };
+
+    struct block_t {
+        std::vector<std::string> marks;
+        std::vector<phi_t> phis;
+        std::vector<instruction_t> instructions;
+
+        std::vector<unsigned> successors;
+        std::vector<unsigned> predecessors;
+        // immediate dominator (entry block is its own dominator)
+        unsigned idom;
+        bool reachable;
+    };
+
+    struct function_t {
+        // .name: directives
+        std::vector<std::string> directives;
+        std::vector<block_t> blocks;
+
+        // registers which may hold references (written by arg, call, or moved to and from such registers)
+        std::set<unsigned> untracked;
+        // where each SSA value is defined: (block, instruction), instruction is -1 for phis
+        std::map<value_t, std::pair<unsigned, int>> definitions;
+    };
+
+    std::string roles(const std::string&, unsigned);
+    bool build(const std::vector<std::string>&, function_t&);
+    void link(function_t&);
+    void prune(function_t&);
+    void ssa(function_t&);
+    unsigned reaching(const function_t&, unsigned, unsigned, unsigned);
+    const instruction_t* definition(const function_t&, const value_t&);
+    std::vector<std::string> lower(const function_t&);
+    std::set<std::string> closures(const invocables_t&);
+
+    unsigned propagateConstants(function_t&);
+    unsigned propagateCopies(function_t&);
+    unsigned eliminateDeadCode(function_t&);
+
+    struct report_t {
+        unsigned functions;
+        unsigned folded;
+        unsigned propagated;
+        unsigned eliminated;
+    };
+    report_t optimize(invocables_t&, bool);
+}
+
+
+#endif
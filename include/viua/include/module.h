@@ -29,6 +29,27 @@ const std::vector<std::string> VIUAPATH = {
 // External functions must have this signature
 typedef void (ExternalFunction)(Frame*, RegisterSet*, RegisterSet*);
 
+/** External functions throw this when they cannot finish without blocking (e.g. when receiving from an empty channel).
+ *  CPU then suspends the calling process and runs the call again later, after other processes had a chance to run,
+ *  so waiting does not take a worker thread away from them.
+ *  Function must not modify its frame before throwing.
+ *
+ *  Functions doing I/O give the file descriptor they wait for, and the calling process is suspended until
+ *  the descriptor becomes ready (see Reactor).
+ */
+class WouldBlock {
+    public:
+        static const unsigned READABLE = (1 << 0);
+        static const unsigned WRITABLE = (1 << 1);
+
+        // file descriptor the call waits for (negative if it only waits for other processes), and
+        // events it waits for
+        int fd;
+        unsigned events;
+
+        WouldBlock(int f = -1, unsigned e = 0): fd(f), events(e) {}
+};
+
 /** Custom types for Viua VM can be written in C++ and loaded into the typesystem with minimal amount of bookkeeping.
  *  The only thing Viua needs to use a pure-C++ class is a string-name-to-member-function-pointer mapping as
  *  the machine must be able to somehow dispatch the methods.
@@ -43,10 +64,15 @@ typedef std::function<void(Type*, Frame*, RegisterSet*, RegisterSet*)> ForeignMe
  *  Should a module fail to provide this function, it is deemed invalid and is rejected by the VM.
  *
  *  The "exports()" function returns an array of below structures.
+ *
+ *  Functions marked as blocking (e.g. waiting for child processes or slow devices) are run on a pool of
+ *  background threads: the call returns a Future immediately, and its result is retrieved with the wait instruction.
+ *  Blocking functions receive copies of their parameters, and are not given global registers.
  */
 struct ExternalFunctionSpec {
     const char* name;
     ExternalFunction* fpointer;
+    bool blocking;
 };
 
 
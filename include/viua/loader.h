@@ -5,52 +5,56 @@
 
 
 #include <cstdint>
-#include <fstream>
+#include <istream>
 #include <tuple>
 #include <string>
 #include <vector>
 #include <map>
 #include <viua/bytecode/bytetypedef.h>
 
-typedef std::tuple<std::vector<std::string>, std::map<std::string, uint16_t> > IdToAddressMapping;
-
 class Loader {
     std::string path;
 
-    uint16_t size;
+    uint32_t size;
     byte* bytecode;
 
     std::vector<unsigned> jumps;
 
-    std::map<std::string, uint16_t> function_addresses;
+    std::map<std::string, uint32_t> function_addresses;
     std::map<std::string, unsigned> function_sizes;
     std::vector<std::string> functions;
-    std::map<std::string, uint16_t> block_addresses;
+    std::map<std::string, uint32_t> block_addresses;
     std::vector<std::string> blocks;
 
-    IdToAddressMapping loadmap(char*, const uint16_t&);
+    std::map<std::string, uint32_t> function_registers;
+
+    void loadmap(char*, const uint32_t&, std::vector<std::string>&, std::map<std::string, uint32_t>&);
     void calculateFunctionSizes();
 
-    void loadJumpTable(std::ifstream&);
-    void loadFunctionsMap(std::ifstream&);
-    void loadBlocksMap(std::ifstream&);
-    void loadBytecode(std::ifstream&);
+    std::string read(const std::string&);
+
+    void loadJumpTable(std::istream&);
+    void loadFunctionsMap(std::istream&);
+    void loadBlocksMap(std::istream&);
+    void loadRegistersMap(std::istream&);
+    void loadBytecode(std::istream&);
 
     public:
     Loader& load();
     Loader& executable();
 
-    uint16_t getBytecodeSize();
+    uint32_t getBytecodeSize();
     byte* getBytecode();
 
-    std::vector<unsigned> getJumps();
+    const std::vector<unsigned>& getJumps();
 
-    std::map<std::string, uint16_t> getFunctionAddresses();
-    std::map<std::string, unsigned> getFunctionSizes();
-    std::vector<std::string> getFunctions();
+    const std::map<std::string, uint32_t>& getFunctionAddresses();
+    const std::map<std::string, unsigned>& getFunctionSizes();
+    const std::vector<std::string>& getFunctions();
+    const std::map<std::string, uint32_t>& getFunctionRegisters();
 
-    std::map<std::string, uint16_t> getBlockAddresses();
-    std::vector<std::string> getBlocks();
+    const std::map<std::string, uint32_t>& getBlockAddresses();
+    const std::vector<std::string>& getBlocks();
 
     Loader(std::string pth): path(pth), size(0), bytecode(nullptr) {}
     ~Loader() {
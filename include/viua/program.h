@@ -16,6 +16,27 @@ enum JUMPTYPE {
 };
 
 
+/** Description of an assembly instruction.
+ *
+ *  Schema is found by instruction mnemonic, and
+ *  is used by both bytecode size calculation and bytecode generation.
+ */
+struct InstructionSchema {
+    OPCODE opcode;
+    // size of the opcode and its fixed-size operands
+    unsigned size;
+    /*  Kinds of source operands required to calculate size of operands encoded as
+     *  null-terminated strings:
+     *
+     *      r   - register index (does not affect size)
+     *      o   - optional register index; if it is the last operand it is a name
+     *      n   - name (of a function, block, class, module, etc.)
+     *      q   - quoted string
+     */
+    std::string strings;
+};
+
+
 class Program {
     // byte array containing bytecode
     byte* program;
@@ -61,6 +82,15 @@ class Program {
     Program& igt        (int_op, int_op, int_op);
     Program& igte       (int_op, int_op, int_op);
     Program& ieq        (int_op, int_op, int_op);
+    Program& tiadd      (int_op, int_op, int_op);
+    Program& tisub      (int_op, int_op, int_op);
+    Program& timul      (int_op, int_op, int_op);
+    Program& tidiv      (int_op, int_op, int_op);
+    Program& tilt       (int_op, int_op, int_op);
+    Program& tilte      (int_op, int_op, int_op);
+    Program& tigt       (int_op, int_op, int_op);
+    Program& tigte      (int_op, int_op, int_op);
+    Program& tieq       (int_op, int_op, int_op);
 
     Program& fstore     (int_op, float);
     Program& fadd       (int_op, int_op, int_op);
@@ -121,6 +151,12 @@ class Program {
     Program& argc       (int_op);
 
     Program& call       (int_op, const std::string&);
+    Program& tailcall   (const std::string&);
+    Program& spawn      (const std::string&);
+    Program& coroutine  (int_op, const std::string&);
+    Program& resume     (int_op, int_op);
+    Program& yield      (int_op);
+    Program& wait       (int_op, int_op);
     Program& jump       (int, enum JUMPTYPE);
     Program& branch     (int_op, int, enum JUMPTYPE, int, enum JUMPTYPE);
 
@@ -163,7 +199,8 @@ class Program {
     int size();
     int instructionCount();
 
-    static uint16_t countBytes(const std::vector<std::string>&);
+    static const InstructionSchema& schema(const std::string&);
+    static uint32_t countBytes(const std::vector<std::string>&);
 
     Program(int bts = 2): bytes(bts), debug(false), scream(false) {
         program = new byte[bytes];
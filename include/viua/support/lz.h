@@ -0,0 +1,16 @@
+#ifndef SUPPORT_LZ_H
+#define SUPPORT_LZ_H
+
+#pragma once
+
+#include <string>
+
+namespace support {
+    namespace lz {
+        bool iscompressed(const std::string&);
+        std::string compress(const std::string&);
+        std::string decompress(const std::string&);
+    }
+}
+
+#endif
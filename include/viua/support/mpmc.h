@@ -0,0 +1,108 @@
+#ifndef SUPPORT_MPMC_H
+#define SUPPORT_MPMC_H
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+
+
+namespace support {
+    template<class T> class BoundedMPMCQueue {
+        /** Lock-free bounded queue for many producers and many consumers.
+         *
+         *  Each cell carries a sequence number telling whether it is ready to be written or read
+         *  in the current lap around the buffer, so producers and consumers only contend on
+         *  the two position counters (which are kept on separate cache lines).
+         *  Capacity is rounded up to a power of two.
+         */
+        struct Cell {
+            std::atomic<std::size_t> sequence;
+            T data;
+        };
+
+        static const std::size_t CACHE_LINE = 64;
+
+        std::unique_ptr<Cell[]> buffer;
+        std::size_t mask;
+
+        char pad_0[CACHE_LINE];
+        std::atomic<std::size_t> enqueue_position;
+        char pad_1[CACHE_LINE - sizeof(std::atomic<std::size_t>)];
+        std::atomic<std::size_t> dequeue_position;
+        char pad_2[CACHE_LINE - sizeof(std::atomic<std::size_t>)];
+
+        public:
+            bool push(const T& value) {
+                /** Put value at the back of the queue.
+                 *  Returns false if the queue is full.
+                 */
+                Cell* cell = nullptr;
+                std::size_t position = enqueue_position.load(std::memory_order_relaxed);
+                while (true) {
+                    cell = &buffer[position & mask];
+                    std::size_t sequence = cell->sequence.load(std::memory_order_acquire);
+                    std::ptrdiff_t difference = std::ptrdiff_t(sequence) - std::ptrdiff_t(position);
+                    if (difference == 0) {
+                        if (enqueue_position.compare_exchange_weak(position, position+1, std::memory_order_relaxed)) {
+                            break;
+                        }
+                    } else if (difference < 0) {
+                        return false;
+                    } else {
+                        position = enqueue_position.load(std::memory_order_relaxed);
+                    }
+                }
+                cell->data = value;
+                cell->sequence.store(position+1, std::memory_order_release);
+                return true;
+            }
+
+            bool pop(T& value) {
+                /** Take value from the front of the queue.
+                 *  Returns false if the queue is empty.
+                 */
+                Cell* cell = nullptr;
+                std::size_t position = dequeue_position.load(std::memory_order_relaxed);
+                while (true) {
+                    cell = &buffer[position & mask];
+                    std::size_t sequence = cell->sequence.load(std::memory_order_acquire);
+                    std::ptrdiff_t difference = std::ptrdiff_t(sequence) - std::ptrdiff_t(position+1);
+                    if (difference == 0) {
+                        if (dequeue_position.compare_exchange_weak(position, position+1, std::memory_order_relaxed)) {
+                            break;
+                        }
+                    } else if (difference < 0) {
+                        return false;
+                    } else {
+                        position = dequeue_position.load(std::memory_order_relaxed);
+                    }
+                }
+                value = cell->data;
+                cell->sequence.store(position+mask+1, std::memory_order_release);
+                return true;
+            }
+
+            std::size_t capacity() const {
+                return (mask+1);
+            }
+
+            BoundedMPMCQueue(std::size_t requested_capacity): buffer(nullptr), mask(0), enqueue_position(0), dequeue_position(0) {
+                std::size_t size = 2;
+                while (size < requested_capacity) {
+                    size <<= 1;
+                }
+                buffer.reset(new Cell[size]);
+                mask = (size-1);
+                for (std::size_t i = 0; i < size; ++i) {
+                    buffer[i].sequence.store(i, std::memory_order_relaxed);
+                }
+            }
+            BoundedMPMCQueue(const BoundedMPMCQueue&) = delete;
+            BoundedMPMCQueue& operator=(const BoundedMPMCQueue&) = delete;
+    };
+}
+
+
+#endif
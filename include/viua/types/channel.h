@@ -0,0 +1,72 @@
+#ifndef VIUA_TYPES_CHANNEL_H
+#define VIUA_TYPES_CHANNEL_H
+
+#pragma once
+
+#include <memory>
+#include <string>
+#include <vector>
+#include <viua/support/mpmc.h>
+#include "type.h"
+
+
+class Channel : public Type {
+    /** Channel type.
+     *
+     *  Passes values between CPUs (or processes) running on different threads through
+     *  a lock-free bounded queue.
+     *  Channel object is a handle: its copies refer to the same queue, so a channel can be
+     *  given to other CPUs simply by copying it.
+     *
+     *  Values are moved into the channel, i.e. the channel takes ownership of sent objects and
+     *  receiver becomes owner of received ones; send `value->copy()` to keep the original.
+     *  Values left in the channel are deleted with its last handle.
+     */
+    class Queue {
+        public:
+            support::BoundedMPMCQueue<Type*> values;
+
+            Queue(unsigned capacity): values(capacity) {}
+            ~Queue();
+    };
+
+    std::shared_ptr<Queue> queue;
+
+    Channel(std::shared_ptr<Queue> q): queue(q) {}
+
+    public:
+        std::string type() const {
+            return "Channel";
+        }
+        std::string str() const;
+        bool boolean() const {
+            return true;
+        }
+
+        std::vector<std::string> bases() const {
+            return std::vector<std::string>{"Type"};
+        }
+        std::vector<std::string> inheritancechain() const {
+            return std::vector<std::string>{"Type"};
+        }
+
+        // copies share the queue
+        Type* copy() const {
+            return new Channel(queue);
+        }
+
+        unsigned capacity() const;
+
+        // nonblocking calls: return false (or null pointer) if the channel is full (or empty)
+        bool trySend(Type*);
+        Type* tryReceive();
+
+        // blocking calls: wait until there is room in (or a value to take from) the channel
+        void send(Type*);
+        Type* receive();
+
+        Channel(unsigned capacity);
+};
+
+
+#endif
@@ -0,0 +1,91 @@
+#ifndef VIUA_TYPES_COROUTINE_H
+#define VIUA_TYPES_COROUTINE_H
+
+#pragma once
+
+#include <memory>
+#include <string>
+#include <vector>
+#include <viua/bytecode/bytetypedef.h>
+#include <viua/cpu/frame.h>
+#include <viua/cpu/tryframe.h>
+#include "type.h"
+
+
+class Coroutine : public Type {
+    /** Coroutine type.
+     *
+     *  Function started as a coroutine runs only when it is resumed, and
+     *  runs until it yields a value or returns.
+     *  Its frames (and frames of functions it called) are kept in the coroutine while it is suspended, so
+     *  a coroutine may yield from any depth of calls.
+     *
+     *  Coroutine object is a handle: its copies refer to the same suspended execution.
+     */
+    public:
+        class State {
+            public:
+                std::string function_name;
+
+                // suspended call stack (the function started as the coroutine is at the bottom), and
+                // try frames created by it
+                std::vector<Frame*> frames;
+                std::vector<TryFrame*> tryframes;
+
+                // register set, base address for jumps and instruction with which execution is resumed
+                RegisterSet* registers;
+                byte* jump_base;
+                byte* resume_address;
+
+                bool running;
+                bool finished;
+
+                /*  Set while the coroutine is running: position of its frames on the call stack of the CPU, and
+                 *  state of the function which resumed it.
+                 */
+                unsigned frames_base;
+                unsigned tryframes_base;
+                RegisterSet* caller_registers;
+                byte* caller_jump_base;
+                byte* return_address;
+                unsigned return_register;
+
+                State():
+                    registers(nullptr), jump_base(nullptr), resume_address(nullptr),
+                    running(false), finished(false),
+                    frames_base(0), tryframes_base(0),
+                    caller_registers(nullptr), caller_jump_base(nullptr), return_address(nullptr), return_register(0)
+                {}
+                ~State();
+        };
+
+        std::shared_ptr<State> state;
+
+        std::string type() const {
+            return "Coroutine";
+        }
+        std::string str() const;
+        std::string repr() const;
+
+        // coroutine is true as long as it can be resumed
+        bool boolean() const {
+            return not state->finished;
+        }
+
+        std::vector<std::string> bases() const {
+            return std::vector<std::string>{"Type"};
+        }
+        std::vector<std::string> inheritancechain() const {
+            return std::vector<std::string>{"Type"};
+        }
+
+        // copies share the suspended execution
+        Type* copy() const {
+            return new Coroutine(state);
+        }
+
+        Coroutine(std::shared_ptr<State> s = std::make_shared<State>()): state(s) {}
+};
+
+
+#endif
@@ -0,0 +1,65 @@
+#ifndef VIUA_TYPES_FUTURE_H
+#define VIUA_TYPES_FUTURE_H
+
+#pragma once
+
+#include <atomic>
+#include <memory>
+#include <string>
+#include <vector>
+#include "type.h"
+
+
+class Future : public Type {
+    /** Future type.
+     *
+     *  Result of a call to a blocking foreign function which runs on a background thread.
+     *  Future is resolved when the function returns (or throws), and
+     *  its value is taken with the wait instruction.
+     *
+     *  Future object is a handle: its copies refer to the same call.
+     */
+    public:
+        class State {
+            public:
+                // set by the thread running the call (value or thrown object first, then the flag)
+                Type* value;
+                Type* thrown;
+                std::atomic<bool> resolved;
+
+                std::string function_name;
+
+                State(const std::string& fn): value(nullptr), thrown(nullptr), resolved(false), function_name(fn) {}
+                ~State();
+        };
+
+        std::shared_ptr<State> state;
+
+        std::string type() const {
+            return "Future";
+        }
+        std::string str() const;
+        std::string repr() const;
+
+        // future is true once it is resolved
+        bool boolean() const {
+            return state->resolved.load();
+        }
+
+        std::vector<std::string> bases() const {
+            return std::vector<std::string>{"Type"};
+        }
+        std::vector<std::string> inheritancechain() const {
+            return std::vector<std::string>{"Type"};
+        }
+
+        // copies share the call
+        Type* copy() const {
+            return new Future(state);
+        }
+
+        Future(std::shared_ptr<State> s): state(s) {}
+};
+
+
+#endif
@@ -0,0 +1,35 @@
+; Object thrown by a coroutine is caught by the function that resumed it, and
+; the coroutine cannot be resumed after that.
+
+.function: failing
+    yield (istore 1 1)
+    throw (istore 1 42)
+    end
+.end
+
+.block: handle_integer
+    pull 3
+    print 3
+    leave
+.end
+
+.block: resume_twice
+    resume 2 1
+    print 2
+    resume 2 1
+    print 2
+    leave
+.end
+
+.function: main
+    frame 0
+    coroutine 1 failing
+
+    try
+    catch "Integer" handle_integer
+    enter resume_twice
+
+    print (not (copy 4 1))
+    izero 0
+    end
+.end
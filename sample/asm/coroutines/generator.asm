@@ -0,0 +1,41 @@
+; Generator yields integers from 1 to a limit one by one so
+; they are never stored in a vector.
+; Coroutine is false after it returned, which ends the loop in main function.
+
+.function: count_to
+    .name: 1 counter
+    .name: 2 limit
+    istore counter 1
+    arg limit 0
+
+    .mark: loop
+    branch (igt 3 counter limit) done
+    yield counter
+    iinc counter
+    jump loop
+
+    .mark: done
+    end
+.end
+
+.function: main
+    .name: 1 numbers
+    .name: 2 number
+    .name: 3 sum
+
+    frame ^[(param 0 (istore 4 5))]
+    coroutine numbers count_to
+
+    izero sum
+    .mark: loop
+    resume number numbers
+    branch numbers +1 done
+    print number
+    iadd sum sum number
+    jump loop
+
+    .mark: done
+    print sum
+    izero 0
+    end
+.end
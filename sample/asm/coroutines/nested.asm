@@ -0,0 +1,31 @@
+; Coroutines are stackful: values are yielded from functions called by the coroutine, and
+; the value the coroutine returns is given to the last resume.
+
+.function: yield_twice
+    arg 1 0
+    yield 1
+    yield (iinc 1)
+    end
+.end
+
+.function: pairs
+    frame ^[(param 0 (istore 1 10))]
+    call yield_twice
+    frame ^[(param 0 (istore 1 20))]
+    call yield_twice
+    strstore 0 "done"
+    end
+.end
+
+.function: main
+    frame 0
+    coroutine 1 pairs
+
+    .mark: loop
+    resume 2 1
+    print 2
+    branch 1 loop +1
+
+    izero 0
+    end
+.end
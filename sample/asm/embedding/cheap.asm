@@ -0,0 +1,7 @@
+; This program finishes after a few instructions.
+
+.function: main
+    print (strstore 1 "cheap")
+    izero 0
+    end
+.end
@@ -0,0 +1,30 @@
+; This program runs for a long time (it sums integers up to 20000 in a spawned process and
+; up to 40000 in the main function).
+; When it is run next to cheap programs by a round robin host, they finish before it does.
+
+.function: sum_up_to
+    .name: 1 limit
+    .name: 2 accumulator
+    arg limit 0
+    izero accumulator
+
+    .mark: loop
+    branch (ieq 3 limit (izero 4)) done
+    iadd accumulator accumulator limit
+    idec limit
+    jump loop
+
+    .mark: done
+    print accumulator
+    end
+.end
+
+.function: main
+    frame ^[(param 0 (istore 1 20000))]
+    spawn sum_up_to
+
+    frame ^[(param 0 (istore 1 40000))]
+    call 0 sum_up_to
+    izero 0
+    end
+.end
@@ -0,0 +1,91 @@
+#include <iostream>
+#include <map>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+#include <viua/types/object.h>
+#include <viua/types/prototype.h>
+#include <viua/types/string.h>
+#include <viua/cpu/cpu.h>
+using namespace std;
+
+
+/*  Host running one program on many CPUs at once, each on its own thread.
+ *
+ *  Usage: multivm <cpus> <executable>
+ *  The executable is loaded once and its image is shared by all CPUs.
+ *  Programs report their results with embedding::record function, and
+ *  the host prints every distinct report with the number of CPUs that made it.
+ */
+
+
+// results recorded by the program running on current thread
+static thread_local string recorded;
+
+static void record(Frame* frame, RegisterSet*, RegisterSet*) {
+    recorded += (recorded.size() ? " " : "") + frame->args->at(0)->str();
+}
+
+static string runProgram(shared_ptr<const ModuleImage> image) {
+    recorded = "";
+
+    CPU cpu;
+    cpu.load(image);
+    cpu.registerExternalFunction("embedding::record", &record);
+
+    Prototype* proto_object = new Prototype("Object");
+    proto_object->attach("Object::set", "set");
+    proto_object->attach("Object::get", "get");
+    cpu.registerForeignPrototype("Object", proto_object);
+    cpu.registerForeignMethod("Object::set", static_cast<ForeignMethodMemberPointer>(&Object::set));
+    cpu.registerForeignMethod("Object::get", static_cast<ForeignMethodMemberPointer>(&Object::get));
+
+    Prototype* proto_string = new Prototype("String");
+    proto_string->attach("String::stringify", "stringify");
+    proto_string->attach("String::represent", "represent");
+    cpu.registerForeignPrototype("String", proto_string);
+    cpu.registerForeignMethod("String::stringify", static_cast<ForeignMethodMemberPointer>(&String::stringify));
+    cpu.registerForeignMethod("String::represent", static_cast<ForeignMethodMemberPointer>(&String::represent));
+
+    cpu.run();
+
+    string exception, message;
+    tie(ignore, exception, message) = cpu.exitcondition();
+    if (exception.size()) {
+        return ("uncaught object: " + exception + " = " + message);
+    }
+    return recorded;
+}
+
+
+int main(int argc, char* argv[]) {
+    if (argc < 3) {
+        cout << "usage: " << argv[0] << " <cpus> <executable>" << endl;
+        return 1;
+    }
+
+    unsigned cpus = static_cast<unsigned>(stoul(argv[1]));
+    shared_ptr<const ModuleImage> image = ModuleImage::executable(argv[2]);
+
+    vector<string> reports(cpus);
+    vector<thread> threads;
+    for (unsigned i = 0; i < cpus; ++i) {
+        threads.emplace_back([i, &image, &reports]() {
+            reports[i] = runProgram(image);
+        });
+    }
+    for (thread& each : threads) {
+        each.join();
+    }
+
+    map<string, unsigned> distinct;
+    for (const string& report : reports) {
+        ++distinct[report];
+    }
+    for (const auto& each : distinct) {
+        cout << each.second << ": " << each.first << endl;
+    }
+
+    return 0;
+}
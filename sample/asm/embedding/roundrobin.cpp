@@ -0,0 +1,50 @@
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+#include <viua/cpu/cpu.h>
+#include <viua/cpu/roundrobin.h>
+using namespace std;
+
+
+/*  Host running several programs on one thread.
+ *
+ *  Usage: roundrobin <budget> <executable>...
+ *  Programs are given <budget> instructions in turn, and
+ *  a line with the exit code of each program is printed when it finishes.
+ */
+
+
+int main(int argc, char* argv[]) {
+    if (argc < 3) {
+        cout << "usage: " << argv[0] << " <budget> <executable>..." << endl;
+        return 1;
+    }
+
+    vector<unique_ptr<CPU>> programs;
+    vector<string> names;
+    RoundRobin round_robin(static_cast<unsigned>(stoul(argv[1])));
+
+    for (int i = 2; i < argc; ++i) {
+        CPU* cpu = new CPU();
+        cpu->load(ModuleImage::executable(argv[i]));
+
+        programs.emplace_back(cpu);
+        names.push_back(argv[i]);
+        round_robin.add(cpu);
+    }
+
+    while (round_robin.running()) {
+        CPU* finished = round_robin.step();
+        if (finished == nullptr) {
+            continue;
+        }
+        for (unsigned i = 0; i < programs.size(); ++i) {
+            if (programs[i].get() == finished) {
+                cout << names[i] << ": " << get<0>(finished->exitcondition()) << endl;
+            }
+        }
+    }
+
+    return 0;
+}
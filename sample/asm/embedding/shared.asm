@@ -0,0 +1,48 @@
+; This program is run on many CPUs at once by the multivm host.
+; Each of them links the same library and imports the same foreign module, and
+; reports its results to the host with embedding::record function.
+
+.signature: std::string::represent
+.signature: typesystem::typeof
+.signature: embedding::record
+
+.function: sum_up_to
+    .name: 1 limit
+    .name: 2 accumulator
+    arg limit 0
+    izero accumulator
+
+    .mark: loop
+    branch (ieq 3 limit (izero 4)) done
+    iadd accumulator accumulator limit
+    idec limit
+    jump loop
+
+    .mark: done
+    move 0 accumulator
+    end
+.end
+
+.function: main
+    link std::string
+    import "typesystem"
+
+    frame ^[(param 0 (istore 1 1000))]
+    call 2 sum_up_to
+
+    frame ^[(param 0 2)]
+    call 3 std::string::represent
+
+    frame ^[(param 0 3)]
+    call 4 typesystem::typeof
+
+    frame ^[(param 0 2)]
+    call 0 embedding::record
+    frame ^[(param 0 3)]
+    call 0 embedding::record
+    frame ^[(param 0 4)]
+    call 0 embedding::record
+
+    izero 0
+    end
+.end
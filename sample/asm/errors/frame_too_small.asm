@@ -0,0 +1,11 @@
+.function: store_in_4
+    istore 4 42
+    end
+.end
+
+.function: main
+    frame 0 2
+    call store_in_4
+    izero 0
+    end
+.end
@@ -0,0 +1,49 @@
+; Objects thrown by functions called directly by main are caught by catchers registered in main.
+; Frames of the calls are dropped before the catchers run, so catchers and code after them
+; use registers of main.
+
+.function: throws_integer
+    istore 1 42
+    throw 1
+    end
+.end
+
+.function: reads_null_register
+    print 1
+    end
+.end
+
+.block: handle
+    pull 2
+    print 2
+    leave
+.end
+
+.block: call_throws_integer
+    frame 0
+    call 0 throws_integer
+    leave
+.end
+
+.block: call_reads_null_register
+    frame 0
+    call 0 reads_null_register
+    leave
+.end
+
+.function: main
+    strstore 3 "main"
+
+    try
+    catch "Integer" handle
+    enter call_throws_integer
+    print 3
+
+    try
+    catch "Exception" handle
+    enter call_reads_null_register
+    print 3
+
+    izero 0
+    end
+.end
@@ -12,8 +12,8 @@ void hello(Frame*, RegisterSet*, RegisterSet*) {
 
 
 const ExternalFunctionSpec functions[] = {
-    { "World::print_hello", &hello },
-    { nullptr, nullptr },
+    { "World::print_hello", &hello, false },
+    { nullptr, nullptr, false },
 };
 
 extern "C" const ExternalFunctionSpec* exports() {
@@ -23,8 +23,8 @@ void math_sqrt(Frame* frame, RegisterSet*, RegisterSet*) {
 
 
 const ExternalFunctionSpec functions[] = {
-    { "math::sqrt", &math_sqrt },
-    { nullptr, nullptr },
+    { "math::sqrt", &math_sqrt, false },
+    { nullptr, nullptr, false },
 };
 
 extern "C" const ExternalFunctionSpec* exports() {
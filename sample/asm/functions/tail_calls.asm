@@ -0,0 +1,25 @@
+; Tail call replaces the frame of calling function with the frame of the called one so
+; this recursion runs in constant stack space even though it is deeper than the call stack allows.
+
+.function: count_down
+    .name: 1 counter
+    .name: 2 accumulator
+    arg counter 0
+    arg accumulator 1
+
+    branch (ieq 3 counter (izero 4)) done
+
+    frame ^[(param 0 (idec counter)) (param 1 (iinc accumulator))]
+    tailcall count_down
+
+    .mark: done
+    move 0 accumulator
+    end
+.end
+
+.function: main
+    frame ^[(param 0 (istore 1 100000)) (param 1 (izero 2))]
+    print (call 3 count_down)
+    izero 0
+    end
+.end
@@ -0,0 +1,12 @@
+.function: dead
+    frame 0
+    call shakenlib::unused_last
+    end
+.end
+
+.function: main
+    frame ^[(param 0 (istore 1 3))]
+    call shakenlib::countdown
+    izero 0
+    end
+.end
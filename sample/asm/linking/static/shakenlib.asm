@@ -0,0 +1,32 @@
+.function: shakenlib::unused_first
+    istore 1 0
+    istore 2 10
+    .mark: loop
+    iinc 1
+    branch (ilt 3 1 2) loop +1
+    end
+.end
+
+.function: shakenlib::countdown
+    ; jumps of this function must be adjusted when functions before it are removed
+    arg 1 0
+    .mark: loop
+    print 1
+    idec 1
+    branch 1 loop +1
+    frame 0
+    call shakenlib::done
+    end
+.end
+
+.function: shakenlib::done
+    strstore 1 "done"
+    print 1
+    end
+.end
+
+.function: shakenlib::unused_last
+    frame 0
+    call shakenlib::unused_first
+    end
+.end
@@ -0,0 +1,60 @@
+; This script contains calls to small functions which are inlined
+; by the assembler (enabled by -O2 option).
+; Output must be the same regardless of whether the script is optimized or not.
+
+.noinline: log
+
+.function: square
+    .name: 1 x
+    arg x 0
+    imul 0 x x
+    end
+.end
+
+.function: sum
+    arg 1 0
+    arg 2 1
+    iadd 0 1 2
+    end
+.end
+
+.function: sum_of_squares
+    ; becomes a leaf after calls to square are inlined
+    frame 1
+    param 0 (arg 1 0)
+    call 3 square
+    frame 1
+    param 0 (arg 2 1)
+    call 4 square
+    frame 2
+    param 0 3
+    param 1 4
+    call 5 sum
+    move 0 5
+    end
+.end
+
+.function: log
+    print (arg 1 0)
+    end
+.end
+
+.function: main
+    .name: 1 a
+    .name: 2 b
+    istore a 3
+    istore b 4
+
+    frame ^[(param 0 a) (param 1 b)]
+    call 3 sum_of_squares
+
+    ; log is never inlined
+    frame ^[(param 0 3)]
+    call log
+
+    frame ^[(param 0 3) (param 1 b)]
+    print (call 4 sum)
+
+    izero 0
+    end
+.end
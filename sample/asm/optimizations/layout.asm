@@ -0,0 +1,49 @@
+; Only some of the functions and blocks in this script are executed.
+; Profile written by the CPU lets the assembler lay out the executed ones together.
+
+.block: handle_integer
+    ; never executed as nothing is thrown
+    pull 2
+    print 2
+    leave
+.end
+
+.block: add_step
+    iadd 1 1 2
+    leave
+.end
+
+.function: report_error
+    ; never called
+    print (strstore 1 "error")
+    end
+.end
+
+.function: step
+    .name: 1 counter
+    arg counter 0
+    istore 2 3
+    try
+    catch "Integer" handle_integer
+    enter add_step
+    move 0 counter
+    end
+.end
+
+.function: main
+    .name: 1 counter
+    .name: 2 limit
+    izero counter
+    istore limit 100
+
+    .mark: loop
+    branch (ilt 3 counter limit) +1 done
+    frame ^[(param 0 counter)]
+    call counter step
+    jump loop
+
+    .mark: done
+    print counter
+    izero 0
+    end
+.end
@@ -0,0 +1,36 @@
+; This script contains sequences of instructions which are rewritten by
+; the peephole optimizer (enabled by -O1 option of the assembler).
+; Output must be the same regardless of whether the script is optimized or not.
+
+.function: main
+    ; copy-free
+    istore 1 40
+    copy 2 1
+    free 1
+
+    ; constant-fold
+    istore 3 1
+    istore 4 1
+    iadd 5 3 4
+
+    ; move-move
+    move 6 5
+    move 5 6
+
+    ; jump-to-jump and jump-to-next
+    jump first
+    .mark: second
+    jump third
+    .mark: first
+    jump second
+    .mark: third
+
+    ; branch-to-next
+    branch (ilt 7 2 5) next
+    .mark: next
+
+    iadd 8 2 5
+    print 8
+    izero 0
+    end
+.end
@@ -0,0 +1,22 @@
+.function: sum
+    ; registers used by this function are deliberately sparse
+    .name: 200 total
+    arg 10 0
+    arg 100 1
+    iadd total 10 100
+    move 0 total
+    end
+.end
+
+.function: main
+    ; frame is much larger than sum function requires
+    frame 2 256
+    istore 1 20
+    param 0 1
+    istore 2 22
+    param 1 2
+    call 3 sum
+    print 3
+    izero 0
+    end
+.end
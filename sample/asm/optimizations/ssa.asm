@@ -0,0 +1,48 @@
+; This script contains constants, copies, dead code and branches on constant conditions which
+; are optimized by the assembler (enabled by -O2 option).
+; Output must be the same regardless of whether the script is optimized or not.
+
+.function: main
+    .name: 1 width
+    .name: 2 height
+    .name: 3 area
+    .name: 4 limit
+    istore width 6
+    istore height 7
+
+    ; folded to a constant
+    imul area width height
+
+    ; never used
+    strstore 5 "unused"
+    istore 6 42
+
+    ; reads of the copy become reads of the original
+    copy 7 area
+    print 7
+
+    istore limit 40
+    ; folded to a jump
+    branch (igt 8 area limit) big small
+
+    .mark: small
+    strstore 9 "small"
+    print 9
+    jump done
+
+    .mark: big
+    strstore 9 "big"
+    print 9
+
+    .mark: done
+    ; loop counter is not a constant, it is merged from two paths
+    izero 10
+    istore 12 3
+    .mark: loop
+    print 10
+    iinc 10
+    branch (ilt 11 10 12) loop
+
+    izero 0
+    end
+.end
@@ -0,0 +1,27 @@
+; Recursive call is in tail position so -O1 replaces it with a tail call.
+; Without optimizations this script exceeds size of the call stack.
+
+.function: count_down
+    .name: 1 counter
+    .name: 2 accumulator
+    arg counter 0
+    arg accumulator 1
+
+    branch (ieq 3 counter (izero 4)) done
+
+    frame ^[(param 0 (idec counter)) (param 1 (iinc accumulator))]
+    call 5 count_down
+    move 0 5
+    end
+
+    .mark: done
+    move 0 accumulator
+    end
+.end
+
+.function: main
+    frame ^[(param 0 (istore 1 100000)) (param 1 (izero 2))]
+    print (call 3 count_down)
+    izero 0
+    end
+.end
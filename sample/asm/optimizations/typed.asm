@@ -0,0 +1,15 @@
+; This script uses typed integer instructions directly.
+; Their operands must hold Integers.
+
+.function: main
+    istore 1 40
+    istore 2 2
+    tiadd 3 1 2
+    tisub 4 3 2
+    timul 5 4 2
+    tidiv 6 5 2
+    branch (tieq 7 6 1) +1 +2
+    print 3
+    izero 0
+    end
+.end
@@ -0,0 +1,45 @@
+; This script contains integer arithmetic on registers whose types are inferred
+; by the assembler (enabled by -O2 option).
+; Instructions operating on proven Integers are replaced with their typed variants.
+; Output must be the same regardless of whether the script is optimized or not.
+
+.function: triangle
+    ; parameters may be references so their types are never known
+    arg 1 0
+    izero 2
+    izero 3
+
+    .mark: loop
+    ; counter is merged from two paths, and is an Integer on both of them
+    iinc 3
+    iadd 2 2 3
+    branch (ilt 4 3 1) loop
+
+    move 0 2
+    end
+.end
+
+.function: main
+    .name: 1 n
+    istore n 4
+
+    frame ^[(param 0 n)]
+    call 2 triangle
+    print 2
+
+    ; booleans are not Integers
+    ilt 3 2 n
+    iadd 4 3 n
+    print 4
+
+    ; types follow objects when they are copied, moved or swapped
+    copy 5 n
+    strstore 6 "text"
+    swap 5 6
+    move 7 6
+    imul 8 7 n
+    print 8
+
+    izero 0
+    end
+.end
@@ -0,0 +1,35 @@
+; Each spawned process sums integers up to its parameter and prints the sum.
+; Processes run alongside the main function so their output may come in any order, and
+; the program finishes when all of them have finished.
+
+.function: sum_up_to
+    .name: 1 limit
+    .name: 2 accumulator
+    arg limit 0
+    izero accumulator
+
+    .mark: loop
+    branch (ieq 3 limit (izero 4)) done
+    iadd accumulator accumulator limit
+    idec limit
+    jump loop
+
+    .mark: done
+    print accumulator
+    end
+.end
+
+.function: main
+    frame ^[(param 0 (istore 1 1000))]
+    spawn sum_up_to
+    frame ^[(param 0 (istore 1 2000))]
+    spawn sum_up_to
+    frame ^[(param 0 (istore 1 3000))]
+    spawn sum_up_to
+    frame ^[(param 0 (istore 1 4000))]
+    spawn sum_up_to
+
+    print (istore 1 0)
+    izero 0
+    end
+.end
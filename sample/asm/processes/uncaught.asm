@@ -0,0 +1,14 @@
+; Uncaught exception stops only the process that threw it.
+
+.function: fail
+    throw (strstore 1 "failed")
+    end
+.end
+
+.function: main
+    frame 0
+    spawn fail
+    print (strstore 1 "main finished")
+    izero 0
+    end
+.end
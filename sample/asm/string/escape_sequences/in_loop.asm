@@ -0,0 +1,19 @@
+; String literals are decoded once and
+; every execution of strstore must produce the same, fresh object.
+
+.function: main
+    istore 1 0
+    istore 2 3
+
+    .mark: loop
+    ilt 3 1 2
+    not 3
+    branch 3 final
+    strstore 4 "Hello\tWorld!"
+    print 4
+    iinc 1
+    jump loop
+    .mark: final
+    izero 0
+    end
+.end
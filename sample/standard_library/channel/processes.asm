@@ -0,0 +1,54 @@
+.signature: std::channel::make
+.signature: std::channel::send
+.signature: std::channel::receive
+
+; Producer process sends integers from 1 to 100 over a channel which holds at most four of them, and
+; main function sums them as they arrive.
+; Sending to a full channel (and receiving from an empty one) suspends the process until
+; the other side makes progress, so this program finishes even when run on a single thread.
+
+.function: produce
+    .name: 1 channel
+    .name: 2 counter
+    .name: 3 limit
+    arg channel 0
+    arg limit 1
+    istore counter 1
+
+    .mark: loop
+    branch (igt 4 counter limit) done
+    frame ^[(param 0 channel) (param 1 counter)]
+    call 0 std::channel::send
+    iinc counter
+    jump loop
+
+    .mark: done
+    end
+.end
+
+.function: main
+    import "channel"
+
+    .name: 1 channel
+    .name: 2 sum
+    .name: 3 received
+    frame ^[(param 0 (istore 1 4))]
+    call channel std::channel::make
+
+    frame ^[(param 0 channel) (param 1 (istore 4 100))]
+    spawn produce
+
+    izero sum
+    izero received
+    .mark: loop
+    branch (ieq 4 received (istore 5 100)) done
+    frame ^[(param 0 channel)]
+    iadd sum sum (call 6 std::channel::receive)
+    iinc received
+    jump loop
+
+    .mark: done
+    print sum
+    izero 0
+    end
+.end
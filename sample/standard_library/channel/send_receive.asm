@@ -0,0 +1,39 @@
+.signature: std::channel::make
+.signature: std::channel::send
+.signature: std::channel::try_send
+.signature: std::channel::receive
+.signature: std::channel::try_receive
+
+.function: main
+    ; first, import the channel module to make std::channel functions available
+    import "channel"
+
+    ; capacity of a channel is rounded up to a power of two
+    frame ^[(param 0 (istore 1 2))]
+    call 1 std::channel::make
+    print 1
+
+    frame ^[(param 0 1) (param 1 (strstore 2 "Hello World!"))]
+    call 0 std::channel::send
+
+    ; values are copied into the channel
+    frame ^[(param 0 1) (param 1 (istore 2 42))]
+    print (call 3 std::channel::try_send)
+    print 2
+
+    ; channel is full
+    frame ^[(param 0 1) (param 1 (istore 2 43))]
+    print (call 3 std::channel::try_send)
+
+    frame ^[(param 0 1)]
+    print (call 3 std::channel::receive)
+    frame ^[(param 0 1)]
+    print (call 3 std::channel::try_receive)
+
+    ; channel is empty
+    frame ^[(param 0 1)]
+    print (call 3 std::channel::try_receive)
+
+    izero 0
+    end
+.end
@@ -0,0 +1,49 @@
+.signature: std::functional::pmap
+
+; Function applied to integers from 1 to 1000 throws every multiple of 100 it is given.
+; Chunks stop at the first object thrown in them, and the one thrown closest to the beginning of
+; the vector is rethrown by pmap so the same object is caught no matter how many threads processed the vector.
+
+.function: throw_hundreds
+    arg 1 0
+    istore 2 100
+    branch (ieq 3 (imul 3 (idiv 3 1 2) 2) 1) +1 done
+    throw 1
+    .mark: done
+    move 0 1
+    end
+.end
+
+.block: handle_integer
+    pull 2
+    print 2
+    leave
+.end
+
+.block: map_numbers
+    frame ^[(param 0 (function 3 throw_hundreds)) (param 1 1)]
+    call 4 std::functional::pmap
+    print 4
+    leave
+.end
+
+.function: main
+    .name: 1 numbers
+    .name: 2 counter
+
+    vec numbers
+    istore counter 1
+    .mark: loop
+    branch (igt 3 counter (istore 4 1000)) done
+    vpush numbers (copy 3 counter)
+    iinc counter
+    jump loop
+    .mark: done
+
+    try
+    catch "Integer" handle_integer
+    enter map_numbers
+
+    izero 0
+    end
+.end
@@ -0,0 +1,80 @@
+.signature: std::functional::pmap
+.signature: std::functional::pfilter
+.signature: std::functional::preduce
+
+; Squares of integers from 1 to 1000 are computed in parallel, and
+; then filtered and summed in parallel.
+; Vector is long enough to be split into chunks when the program runs on more than one thread.
+
+.function: square
+    arg 1 0
+    imul 0 1 1
+    end
+.end
+
+.function: is_even
+    ; n is even if n == (n / 2) * 2
+    arg 1 0
+    istore 2 2
+    ieq 0 1 (imul 3 (idiv 3 1 2) 2)
+    end
+.end
+
+.function: add
+    arg 1 0
+    arg 2 1
+    iadd 0 1 2
+    end
+.end
+
+.function: multiply_by
+    .name: 2 factor
+    arg 1 0
+    imul 0 1 factor
+    end
+.end
+
+.function: make_multiplier
+    clbind (arg 2 0)
+    move 0 (closure 1 multiply_by)
+    end
+.end
+
+.function: main
+    .name: 1 numbers
+    .name: 2 counter
+    .name: 3 squares
+
+    vec numbers
+    istore counter 1
+    .mark: loop
+    branch (igt 4 counter (istore 5 1000)) done
+    vpush numbers (copy 4 counter)
+    iinc counter
+    jump loop
+    .mark: done
+
+    frame ^[(param 0 (function 4 square)) (param 1 numbers)]
+    call squares std::functional::pmap
+    print (vlen 4 squares)
+    print (vat 4 squares 0)
+    empty 4
+    print (vat 4 squares 999)
+    empty 4
+
+    frame ^[(param 0 (function 4 is_even)) (param 1 squares)]
+    print (vlen 4 (call 5 std::functional::pfilter))
+
+    frame ^[(param 0 (function 4 add)) (param 1 squares) (param 2 (izero 6))]
+    print (call 5 std::functional::preduce)
+
+    frame ^[(param 0 (istore 6 3))]
+    call 4 make_multiplier
+    frame ^[(param 0 4) (param 1 numbers)]
+    call 6 std::functional::pmap
+    frame ^[(param 0 (function 7 add)) (param 1 6) (param 2 (izero 8))]
+    print (call 5 std::functional::preduce)
+
+    izero 0
+    end
+.end
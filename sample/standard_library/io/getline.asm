@@ -0,0 +1,29 @@
+.signature: std::io::getline
+
+; Process reading standard input is suspended until a line arrives, so
+; main function keeps running (and finishes counting) while the input is not there yet.
+
+.function: read_line
+    frame 0
+    print (call 1 std::io::getline)
+    end
+.end
+
+.function: main
+    import "io"
+
+    frame 0
+    spawn read_line
+
+    .name: 1 counter
+    izero counter
+    .mark: loop
+    branch (ilt 2 counter (istore 3 100000)) +1 done
+    iinc counter
+    jump loop
+
+    .mark: done
+    print (strstore 2 "counted")
+    izero 0
+    end
+.end
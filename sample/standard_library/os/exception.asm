@@ -0,0 +1,29 @@
+.signature: os::system
+
+; Object thrown by a blocking foreign function is thrown by the wait instruction.
+
+.block: handle_exception
+    pull 3
+    print 3
+    leave
+.end
+
+.block: wait_for_command
+    print (wait 2 1)
+    leave
+.end
+
+.function: main
+    import "os"
+
+    ; no command is given to the function
+    frame 1
+    call 1 os::system
+
+    try
+    catch "Exception" handle_exception
+    enter wait_for_command
+
+    izero 0
+    end
+.end
@@ -0,0 +1,30 @@
+.signature: os::system
+
+; Calls to blocking foreign functions run in background so
+; the four commands below sleep at the same time instead of one after another.
+
+.function: main
+    import "os"
+
+    strstore 1 "sleep 0.5"
+
+    frame ^[(param 0 1)]
+    call 2 os::system
+    frame ^[(param 0 1)]
+    call 3 os::system
+    frame ^[(param 0 1)]
+    call 4 os::system
+    frame ^[(param 0 1)]
+    call 5 os::system
+
+    print (strstore 6 "started")
+
+    print (wait 6 2)
+    print (wait 6 3)
+    print (wait 6 4)
+    print (wait 6 5)
+    print 5
+
+    izero 0
+    end
+.end
@@ -0,0 +1,14 @@
+.signature: os::system
+
+.function: main
+    import "os"
+
+    frame ^[(param 0 (strstore 1 "exit 3"))]
+    call 2 os::system
+
+    ; exit status is encoded as returned by system(3)
+    print (wait 3 2)
+
+    izero 0
+    end
+.end
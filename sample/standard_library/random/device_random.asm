@@ -5,9 +5,11 @@
     import "random"
 
     ; this call can block if not enough entropy bytes can be found
-    ; to form an integer, but is safe
+    ; to form an integer so it runs in background and returns a future, and
+    ; the process waits for the integer only when it needs it
     frame 0
-    print (call 1 std::random::device::random)
+    call 1 std::random::device::random
+    print (wait 2 1)
 
     izero 0
     end
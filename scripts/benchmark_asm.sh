@@ -0,0 +1,77 @@
+#!/usr/bin/env sh
+
+##############################################################
+#
+#   This script measures throughput of the assembler.
+#   It generates a synthetic assembly file with given
+#   number of lines (100000 by default), assembles it, runs
+#   the result to check that the bytecode is correct, and
+#   reports how many lines were assembled per second.
+#
+#       ./scripts/benchmark_asm.sh [<lines>]
+#
+#   Assembler is run with compilation cache disabled.
+#
+##############################################################
+
+set -e
+
+VIUA_ASM=./build/bin/vm/asm
+VIUA_CPU=./build/bin/vm/cpu
+
+LINES=${1:-100000}
+SOURCE=./tmp/benchmark_asm.asm
+COMPILED=./tmp/benchmark_asm.bin
+
+awk -v lines=$LINES 'BEGIN {
+    n = 0;
+    f = 0;
+    while (n < lines) {
+        print ".function: f" f;
+        print ".name: 1 counter";
+        print "arg counter 0";
+        print "istore 2 100";
+        n += 4;
+        for (k = 0; k < 8; ++k) {
+            print "iadd 3 counter 2";
+            print "ilt 4 counter 2";
+            print "igte 5 counter 2";
+            print "strstore 6 \"hello world\"";
+            print "move 7 6";
+            n += 5;
+        }
+        print "branch (ilt 4 counter 2) +1 +1";
+        print "copy 0 counter";
+        print "end";
+        print ".end";
+        print "";
+        n += 5;
+        ++f;
+    }
+    print ".function: main";
+    for (i = 0; i < f; ++i) {
+        print "frame ^[(param 0 (istore 1 " i "))]";
+        print "call 1 f" i;
+    }
+    print "print 1";
+    print "izero 0";
+    print "end";
+    print ".end";
+}' > $SOURCE
+
+TOTAL_LINES=$(wc -l < $SOURCE)
+
+START=$(date +%s%N)
+$VIUA_ASM --no-cache -o $COMPILED $SOURCE
+END=$(date +%s%N)
+
+OUTPUT=$($VIUA_CPU $COMPILED)
+# main function prints the value returned by the last generated function, i.e. its index
+if [ "$OUTPUT" != "$(( $(grep -c '^.function: f' $SOURCE) - 1 ))" ]; then
+    echo "fatal: assembled program produced unexpected output: $OUTPUT"
+    exit 1
+fi
+
+MS=$(( (END - START) / 1000000 ))
+echo "assembled $TOTAL_LINES lines ($(wc -c < $COMPILED) bytes of bytecode) in $MS ms"
+echo "throughput: $(( TOTAL_LINES * 1000 / (MS + 1) )) lines/s"
@@ -0,0 +1,82 @@
+#!/usr/bin/env sh
+
+##############################################################
+#
+#   This script measures speedup of std::functional::pmap.
+#   It maps a CPU-bound function over a vector with given
+#   number of elements (1000000 by default) on one worker
+#   thread, and then on given number of threads (number of
+#   processors by default), and reports the speedup.
+#
+#       ./scripts/benchmark_pmap.sh [<elements> [<threads>]]
+#
+##############################################################
+
+set -e
+
+VIUA_ASM=./build/bin/vm/asm
+VIUA_CPU=./build/bin/vm/cpu
+
+ELEMENTS=${1:-1000000}
+THREADS=${2:-$(nproc)}
+SOURCE=./tmp/benchmark_pmap.asm
+COMPILED=./tmp/benchmark_pmap.bin
+
+cat > $SOURCE <<SOURCE_END
+.signature: std::functional::pmap
+
+; sum of integers from 1 to n, computed the slow way
+.function: triangle
+    .name: 1 n
+    .name: 2 sum
+    arg n 0
+    izero sum
+    .mark: loop
+    branch n +1 done
+    iadd sum sum n
+    idec n
+    jump loop
+    .mark: done
+    move 0 sum
+    end
+.end
+
+.function: main
+    .name: 1 numbers
+    .name: 2 counter
+    vec numbers
+    izero counter
+    .mark: loop
+    branch (ilt 3 counter (istore 4 $ELEMENTS)) +1 done
+    vpush numbers (istore 3 64)
+    iinc counter
+    jump loop
+    .mark: done
+
+    frame ^[(param 0 (function 3 triangle)) (param 1 numbers)]
+    call 4 std::functional::pmap
+    print (vlen 5 4)
+    izero 0
+    end
+.end
+SOURCE_END
+
+$VIUA_ASM -o $COMPILED $SOURCE
+
+measure() {
+    START=$(date +%s%N)
+    OUTPUT=$($VIUA_CPU --threads $1 $COMPILED)
+    END=$(date +%s%N)
+    if [ "$OUTPUT" != "$ELEMENTS" ]; then
+        echo "fatal: benchmark program produced unexpected output: $OUTPUT" >&2
+        exit 1
+    fi
+    echo $(( (END - START) / 1000000 ))
+}
+
+SEQUENTIAL=$(measure 1)
+PARALLEL=$(measure $THREADS)
+
+echo "pmap over $ELEMENTS elements on 1 thread: $SEQUENTIAL ms"
+echo "pmap over $ELEMENTS elements on $THREADS threads: $PARALLEL ms"
+echo "speedup: $(awk -v s=$SEQUENTIAL -v p=$PARALLEL 'BEGIN { printf "%.2f", s / (p ? p : 1) }')x"
@@ -0,0 +1,93 @@
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+#include <viua/types/integer.h>
+#include <viua/types/channel.h>
+using namespace std;
+
+
+/*  Benchmark of channels passing values between threads.
+ *
+ *      ./build/bin/bench/channel [<messages> [<producers> [<consumers>]]]
+ *
+ *  Throughput is measured with producers and consumers sending and receiving Integers over a single channel.
+ *  Latency is measured by two threads passing one value back and forth over a pair of channels.
+ */
+
+
+static double seconds_since(const chrono::steady_clock::time_point& start) {
+    return chrono::duration<double>(chrono::steady_clock::now() - start).count();
+}
+
+static unsigned argument(int argc, char* argv[], int index, unsigned fallback) {
+    return ((index < argc) ? unsigned(stoul(argv[index])) : fallback);
+}
+
+int main(int argc, char* argv[]) {
+    unsigned messages = argument(argc, argv, 1, 1000000);
+    unsigned producers = argument(argc, argv, 2, 2);
+    unsigned consumers = argument(argc, argv, 3, 2);
+    const unsigned capacity = 1024;
+
+    Channel channel(capacity);
+    vector<thread> threads;
+    vector<long long> sums(consumers, 0);
+
+    auto start = chrono::steady_clock::now();
+    for (unsigned p = 0; p < producers; ++p) {
+        threads.emplace_back([&channel, messages, producers, p]() {
+            for (unsigned i = p; i < messages; i += producers) {
+                channel.send(new Integer(int(i)));
+            }
+        });
+    }
+    for (unsigned c = 0; c < consumers; ++c) {
+        threads.emplace_back([&channel, &sums, messages, consumers, c]() {
+            unsigned share = (messages / consumers) + ((c < (messages % consumers)) ? 1 : 0);
+            for (unsigned i = 0; i < share; ++i) {
+                Type* value = channel.receive();
+                sums[c] += static_cast<Integer*>(value)->value();
+                delete value;
+            }
+        });
+    }
+    for (thread& each : threads) {
+        each.join();
+    }
+    double elapsed = seconds_since(start);
+
+    long long sum = 0;
+    for (long long each : sums) {
+        sum += each;
+    }
+    if (sum != (static_cast<long long>(messages) * (messages-1) / 2)) {
+        cout << "fatal: values were lost or duplicated in the channel" << endl;
+        return 1;
+    }
+
+    cout << "throughput: " << messages << " messages, " << producers << " producer(s), " << consumers << " consumer(s), capacity " << capacity << endl;
+    cout << "    " << static_cast<unsigned long long>(messages / elapsed) << " messages/s (" << (elapsed * 1e9 / messages) << " ns per message)" << endl;
+
+    unsigned round_trips = (messages / 10 ? messages / 10 : 1);
+    Channel ping(1), pong(1);
+    thread echo([&ping, &pong, round_trips]() {
+        for (unsigned i = 0; i < round_trips; ++i) {
+            pong.send(ping.receive());
+        }
+    });
+    start = chrono::steady_clock::now();
+    for (unsigned i = 0; i < round_trips; ++i) {
+        ping.send(new Integer(int(i)));
+        delete pong.receive();
+    }
+    elapsed = seconds_since(start);
+    echo.join();
+
+    cout << "latency: " << round_trips << " round trips" << endl;
+    cout << "    " << (elapsed * 1e9 / round_trips) << " ns per round trip (" << (elapsed * 1e9 / round_trips / 2) << " ns one way)" << endl;
+
+    return 0;
+}
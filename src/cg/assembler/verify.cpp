@@ -17,11 +17,12 @@ string assembler::verify::functionCallsAreDefined(const vector<string>& lines, c
     string line;
     for (unsigned i = 0; i < lines.size(); ++i) {
         line = str::lstrip(lines[i]);
-        if (not str::startswith(line, "call")) {
+        string instruction = str::chunk(line);
+        if (not (instruction == "call" or instruction == "tailcall" or instruction == "spawn" or instruction == "coroutine")) {
             continue;
         }
 
-        line = str::lstrip(line.substr(4));
+        line = str::lstrip(line.substr(instruction.size()));
         string return_register = str::chunk(line);
         line = str::lstrip(line.substr(return_register.size()));
         string function = str::chunk(line);
@@ -57,11 +58,11 @@ string assembler::verify::frameBalance(const vector<string>& lines, const map<un
 
         line = str::lstrip(line);
         instruction = str::chunk(line);
-        if (not (instruction == "call" or instruction == "excall" or instruction == "fcall" or instruction == "frame" or instruction == "msg" or instruction == "end")) {
+        if (not (instruction == "call" or instruction == "tailcall" or instruction == "spawn" or instruction == "coroutine" or instruction == "excall" or instruction == "fcall" or instruction == "frame" or instruction == "msg" or instruction == "end")) {
             continue;
         }
 
-        if (instruction == "call" or instruction == "excall" or instruction == "fcall" or instruction == "msg") {
+        if (instruction == "call" or instruction == "tailcall" or instruction == "spawn" or instruction == "coroutine" or instruction == "excall" or instruction == "fcall" or instruction == "msg") {
             --balance;
         }
         if (instruction == "frame") {
@@ -222,7 +223,7 @@ string assembler::verify::directives(const vector<string>& lines, const map<unsi
         }
 
         string token = str::chunk(line);
-        if (not (token == ".function:" or token == ".signature:" or token == ".bsignature:" or token == ".block:" or token == ".end" or token == ".name:" or token == ".mark:" or token == ".main:" or token == ".type:" or token == ".class:")) {
+        if (not (token == ".function:" or token == ".signature:" or token == ".bsignature:" or token == ".block:" or token == ".end" or token == ".name:" or token == ".mark:" or token == ".main:" or token == ".type:" or token == ".class:" or token == ".noinline:")) {
             report << "fatal: unrecognised assembler directive on line ";
             report << (expanded_lines_to_source_lines.at(i)+1);
             report << ": `" << token << '`';
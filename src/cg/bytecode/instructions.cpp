@@ -205,6 +205,123 @@ namespace cg {
             return addr_ptr;
         }
 
+        byte* tiadd(byte* addr_ptr, int_op rega, int_op regb, int_op regr) {
+            /*  Inserts tiadd instruction to bytecode.
+             *
+             *  :params:
+             *
+             *  rega    - register index of first operand
+             *  regb    - register index of second operand
+             *  regr    - register index in which to store the result
+             */
+            addr_ptr = insertThreeIntegerOpsInstruction(addr_ptr, TIADD, rega, regb, regr);
+            return addr_ptr;
+        }
+
+        byte* tisub(byte* addr_ptr, int_op rega, int_op regb, int_op regr) {
+            /*  Inserts tisub instruction to bytecode.
+             *
+             *  :params:
+             *
+             *  rega    - register index of first operand
+             *  regb    - register index of second operand
+             *  regr    - register index in which to store the result
+             */
+            addr_ptr = insertThreeIntegerOpsInstruction(addr_ptr, TISUB, rega, regb, regr);
+            return addr_ptr;
+        }
+
+        byte* timul(byte* addr_ptr, int_op rega, int_op regb, int_op regr) {
+            /*  Inserts timul instruction to bytecode.
+             *
+             *  :params:
+             *
+             *  rega    - register index of first operand
+             *  regb    - register index of second operand
+             *  regr    - register index in which to store the result
+             */
+            addr_ptr = insertThreeIntegerOpsInstruction(addr_ptr, TIMUL, rega, regb, regr);
+            return addr_ptr;
+        }
+
+        byte* tidiv(byte* addr_ptr, int_op rega, int_op regb, int_op regr) {
+            /*  Inserts tidiv instruction to bytecode.
+             *
+             *  :params:
+             *
+             *  rega    - register index of first operand
+             *  regb    - register index of second operand
+             *  regr    - register index in which to store the result
+             */
+            addr_ptr = insertThreeIntegerOpsInstruction(addr_ptr, TIDIV, rega, regb, regr);
+            return addr_ptr;
+        }
+
+        byte* tilt(byte* addr_ptr, int_op rega, int_op regb, int_op regr) {
+            /*  Inserts tilt instruction to bytecode.
+             *
+             *  :params:
+             *
+             *  rega    - register index of first operand
+             *  regb    - register index of second operand
+             *  regr    - register index in which to store the result
+             */
+            addr_ptr = insertThreeIntegerOpsInstruction(addr_ptr, TILT, rega, regb, regr);
+            return addr_ptr;
+        }
+
+        byte* tilte(byte* addr_ptr, int_op rega, int_op regb, int_op regr) {
+            /*  Inserts tilte instruction to bytecode.
+             *
+             *  :params:
+             *
+             *  rega    - register index of first operand
+             *  regb    - register index of second operand
+             *  regr    - register index in which to store the result
+             */
+            addr_ptr = insertThreeIntegerOpsInstruction(addr_ptr, TILTE, rega, regb, regr);
+            return addr_ptr;
+        }
+
+        byte* tigt(byte* addr_ptr, int_op rega, int_op regb, int_op regr) {
+            /*  Inserts tigt instruction to bytecode.
+             *
+             *  :params:
+             *
+             *  rega    - register index of first operand
+             *  regb    - register index of second operand
+             *  regr    - register index in which to store the result
+             */
+            addr_ptr = insertThreeIntegerOpsInstruction(addr_ptr, TIGT, rega, regb, regr);
+            return addr_ptr;
+        }
+
+        byte* tigte(byte* addr_ptr, int_op rega, int_op regb, int_op regr) {
+            /*  Inserts tigte instruction to bytecode.
+             *
+             *  :params:
+             *
+             *  rega    - register index of first operand
+             *  regb    - register index of second operand
+             *  regr    - register index in which to store the result
+             */
+            addr_ptr = insertThreeIntegerOpsInstruction(addr_ptr, TIGTE, rega, regb, regr);
+            return addr_ptr;
+        }
+
+        byte* tieq(byte* addr_ptr, int_op rega, int_op regb, int_op regr) {
+            /*  Inserts tieq instruction to bytecode.
+             *
+             *  :params:
+             *
+             *  rega    - register index of first operand
+             *  regb    - register index of second operand
+             *  regr    - register index in which to store the result
+             */
+            addr_ptr = insertThreeIntegerOpsInstruction(addr_ptr, TIEQ, rega, regb, regr);
+            return addr_ptr;
+        }
+
         byte* fstore(byte* addr_ptr, int_op regno, float f) {
             /*  Inserts fstore instruction to bytecode.
              *
@@ -715,6 +832,64 @@ namespace cg {
             return addr_ptr;
         }
 
+        byte* tailcall(byte* addr_ptr, const string& fn_name) {
+            /*  Inserts tailcall instruction.
+             *  Byte offset is calculated automatically.
+             */
+            *(addr_ptr++) = TAILCALL;
+            for (unsigned i = 0; i < fn_name.size(); ++i) {
+                *(addr_ptr++) = fn_name[i];
+            }
+            *(addr_ptr++) = '\0';
+            return addr_ptr;
+        }
+
+        byte* spawn(byte* addr_ptr, const string& fn_name) {
+            /*  Inserts spawn instruction.
+             *  Byte offset is calculated automatically.
+             */
+            *(addr_ptr++) = SPAWN;
+            for (unsigned i = 0; i < fn_name.size(); ++i) {
+                *(addr_ptr++) = fn_name[i];
+            }
+            *(addr_ptr++) = '\0';
+            return addr_ptr;
+        }
+
+        byte* coroutine(byte* addr_ptr, int_op reg, const string& fn_name) {
+            /*  Inserts coroutine instruction.
+             */
+            *(addr_ptr++) = COROUTINE;
+            addr_ptr = insertIntegerOperand(addr_ptr, reg);
+            for (unsigned i = 0; i < fn_name.size(); ++i) {
+                *(addr_ptr++) = fn_name[i];
+            }
+            *(addr_ptr++) = '\0';
+            return addr_ptr;
+        }
+
+        byte* resume(byte* addr_ptr, int_op ret, int_op crt) {
+            /*  Inserts resume instruction.
+             */
+            addr_ptr = insertTwoIntegerOpsInstruction(addr_ptr, RESUME, ret, crt);
+            return addr_ptr;
+        }
+
+        byte* yield(byte* addr_ptr, int_op regno) {
+            /*  Inserts yield instruction.
+             */
+            *(addr_ptr++) = YIELD;
+            addr_ptr = insertIntegerOperand(addr_ptr, regno);
+            return addr_ptr;
+        }
+
+        byte* wait(byte* addr_ptr, int_op ret, int_op future) {
+            /*  Inserts wait instruction.
+             */
+            addr_ptr = insertTwoIntegerOpsInstruction(addr_ptr, WAIT, ret, future);
+            return addr_ptr;
+        }
+
         byte* jump(byte* addr_ptr, int addr) {
             /*  Inserts jump instruction. Parameter is instruction index.
              *  Byte offset is calculated automatically.
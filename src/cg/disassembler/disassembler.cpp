@@ -49,7 +49,7 @@ tuple<string, unsigned> disassembler::instruction(byte* ptr) {
         oss << " " << str::enquote(s);
         bptr += s.size();
         ++bptr; // for null character terminating the C-style string not included in std::string
-    } else if ((op == CALL) or (op == CLOSURE) or (op == FUNCTION) or (op == CLASS) or (op == NEW) or (op == DERIVE) or (op == MSG)) {
+    } else if ((op == CALL) or (op == CLOSURE) or (op == FUNCTION) or (op == CLASS) or (op == NEW) or (op == DERIVE) or (op == MSG) or (op == COROUTINE)) {
         oss << " " << intop(bptr);
         pointer::inc<bool, byte>(bptr);
         pointer::inc<int, byte>(bptr);
@@ -59,7 +59,7 @@ tuple<string, unsigned> disassembler::instruction(byte* ptr) {
         oss << fn_name;
         bptr += fn_name.size();
         ++bptr; // for null character terminating the C-style string not included in std::string
-    } else if ((op == IMPORT) or (op == ENTER) or (op == LINK)) {
+    } else if ((op == IMPORT) or (op == ENTER) or (op == LINK) or (op == TAILCALL) or (op == SPAWN)) {
         oss << " ";
         string s = string(bptr);
         oss << (op == IMPORT ? str::enquote(s) : s);
@@ -121,6 +121,7 @@ tuple<string, unsigned> disassembler::instruction(byte* ptr) {
         case CLBIND:
         case ARGC:
         case THROW:
+        case YIELD:
         case PULL:
         case REGISTER:
             oss << " " << intop(ptr);
@@ -145,6 +146,8 @@ tuple<string, unsigned> disassembler::instruction(byte* ptr) {
         case VPUSH:
         case VLEN:
         case FCALL:
+        case RESUME:
+        case WAIT:
             oss << " " << intop(ptr);
             pointer::inc<bool, byte>(ptr);
             pointer::inc<int, byte>(ptr);
@@ -163,6 +166,15 @@ tuple<string, unsigned> disassembler::instruction(byte* ptr) {
         case IGT:
         case IGTE:
         case IEQ:
+        case TIADD:
+        case TISUB:
+        case TIMUL:
+        case TIDIV:
+        case TILT:
+        case TILTE:
+        case TIGT:
+        case TIGTE:
+        case TIEQ:
         case FADD:
         case FSUB:
         case FMUL:
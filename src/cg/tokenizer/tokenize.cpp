@@ -1,48 +1,46 @@
-#include <sstream>
 #include <viua/support/string.h>
 #include <viua/cg/tokenizer.h>
 using namespace std;
 
 vector<string> tokenize(const string& s) {
     vector<string> tokens;
-    ostringstream token;
-    token.str("");
+    string token;
     for (unsigned i = 0; i < s.size(); ++i) {
-        if (s[i] == ' ' and token.str().size()) {
-            tokens.push_back(token.str());
-            token.str("");
+        if (s[i] == ' ' and token.size()) {
+            tokens.push_back(token);
+            token.clear();
             continue;
         }
         if (s[i] == ' ') {
             continue;
         }
         if (s[i] == '^') {
-            if (token.str().size()) {
-                tokens.push_back(token.str());
-                token.str("");
+            if (token.size()) {
+                tokens.push_back(token);
+                token.clear();
             }
             tokens.push_back("^");
         }
         if (s[i] == '(' or s[i] == ')') {
-            if (token.str().size()) {
-                tokens.push_back(token.str());
-                token.str("");
+            if (token.size()) {
+                tokens.push_back(token);
+                token.clear();
             }
             tokens.push_back((s[i] == '(' ? "(" : ")"));
             continue;
         }
         if (s[i] == '[' or s[i] == ']') {
-            if (token.str().size()) {
-                tokens.push_back(token.str());
-                token.str("");
+            if (token.size()) {
+                tokens.push_back(token);
+                token.clear();
             }
             tokens.push_back((s[i] == '[' ? "[" : "]"));
             continue;
         }
         if (s[i] == '{' or s[i] == '}') {
-            if (token.str().size()) {
-                tokens.push_back(token.str());
-                token.str("");
+            if (token.size()) {
+                tokens.push_back(token);
+                token.clear();
             }
             tokens.push_back((s[i] == '{' ? "{" : "}"));
             continue;
@@ -53,10 +51,10 @@ vector<string> tokenize(const string& s) {
             tokens.push_back(ss);
             continue;
         }
-        token << s[i];
+        token += s[i];
     }
-    if (token.str().size()) {
-        tokens.push_back(token.str());
+    if (token.size()) {
+        tokens.push_back(token);
     }
     return tokens;
 }
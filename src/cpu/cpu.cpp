@@ -1,9 +1,7 @@
-#include <dlfcn.h>
 #include <cstdlib>
 #include <iostream>
 #include <vector>
 #include <functional>
-#include <regex>
 #include <viua/bytecode/bytetypedef.h>
 #include <viua/bytecode/opcodes.h>
 #include <viua/bytecode/maps.h>
@@ -14,12 +12,14 @@
 #include <viua/types/vector.h>
 #include <viua/types/exception.h>
 #include <viua/types/reference.h>
+#include <viua/types/future.h>
 #include <viua/support/pointer.h>
 #include <viua/support/string.h>
 #include <viua/support/env.h>
-#include <viua/loader.h>
 #include <viua/include/module.h>
 #include <viua/cpu/cpu.h>
+#include <viua/cpu/verifier.h>
+#include <viua/cpu/scheduler.h>
 using namespace std;
 
 
@@ -35,13 +35,37 @@ CPU& CPU::load(byte* bc) {
      *
      *  bc:char*    - pointer to byte array containing bytecode with a program to run
      */
-    if (bytecode) { delete[] bytecode; }
+    if (bytecode and not kernel->image) { delete[] bytecode; }
+    kernel->image.reset();
     bytecode = bc;
     jump_base = bytecode;
     return (*this);
 }
 
-CPU& CPU::bytes(uint16_t sz) {
+CPU& CPU::load(shared_ptr<const ModuleImage> image) {
+    /*  Load a program from an image.
+     *  Image is shared, not copied, so a host can run one program on many CPUs while keeping
+     *  a single copy of its bytecode.
+     *
+     *  Bytecode size, entry point and maps of functions and blocks are set from the image.
+     */
+    load(nullptr);
+    kernel->image = image;
+    bytecode = image->bytecode;
+    jump_base = bytecode;
+    bytecode_size = image->size;
+
+    for (const auto& each : image->function_addresses) { mapfunction(each.first, each.second); }
+    for (const auto& each : image->block_addresses) { mapblock(each.first, each.second); }
+    for (const auto& each : image->function_registers) { mapregisters(each.first, each.second); }
+    auto entry = image->function_addresses.find("__entry");
+    if (entry != image->function_addresses.end()) {
+        eoffset(entry->second);
+    }
+    return (*this);
+}
+
+CPU& CPU::bytes(uint32_t sz) {
     /*  Set bytecode size, so the CPU can stop execution even if it doesn't reach HALT instruction but reaches
      *  bytecode address out of bounds.
      */
@@ -49,7 +73,7 @@ CPU& CPU::bytes(uint16_t sz) {
     return (*this);
 }
 
-CPU& CPU::eoffset(uint16_t o) {
+CPU& CPU::eoffset(uint32_t o) {
     /*  Set offset of first executable instruction.
      */
     executable_offset = o;
@@ -79,6 +103,13 @@ CPU& CPU::mapfunction(const string& name, unsigned address) {
     return (*this);
 }
 
+CPU& CPU::mapregisters(const string& name, unsigned size) {
+    /** Maps function name to size of local register set it requires.
+     */
+    function_registers[name] = size;
+    return (*this);
+}
+
 CPU& CPU::mapblock(const string& name, unsigned address) {
     /** Maps block name to bytecode address.
      */
@@ -86,10 +117,16 @@ CPU& CPU::mapblock(const string& name, unsigned address) {
     return (*this);
 }
 
-CPU& CPU::registerExternalFunction(const string& name, ExternalFunction* function_ptr) {
+CPU& CPU::registerExternalFunction(const string& name, ExternalFunction* function_ptr, bool blocking) {
     /** Registers external function in CPU.
+     *  Calls to blocking functions are run on background threads and return futures.
      */
     foreign_functions[name] = function_ptr;
+    if (blocking) {
+        blocking_functions.insert(name);
+    } else {
+        blocking_functions.erase(name);
+    }
     return (*this);
 }
 
@@ -218,6 +255,15 @@ void CPU::pushFrame() {
         throw new Exception(oss.str());
     }
 
+    // frames are requested before the called function is known so
+    // they are resized here to the number of registers the function requires
+    // (functions may require more registers than requested after calls in them were inlined)
+    auto required = function_registers.find(frame_new->function_name);
+    if (required != function_registers.end() and required->second != frame_new->regset->size()) {
+        delete frame_new->regset;
+        frame_new->regset = new RegisterSet(required->second);
+    }
+
     uregset = frame_new->regset;
     // FIXME: remove this print
     //cout << "\npushing new frame on stack: " << hex << frame_new << dec << " (for function: " << frame_new->function_name << ')' << endl;
@@ -245,12 +291,14 @@ void CPU::dropFrame() {
 
 byte* CPU::callNative(byte* addr, const string& call_name, const bool& return_ref, const int& return_index, const string& real_call_name) {
     byte* call_address = nullptr;
-    if (function_addresses.count(call_name)) {
-        call_address = bytecode+function_addresses.at(call_name);
+    auto local = function_addresses.find(call_name);
+    if (local != function_addresses.end()) {
+        call_address = bytecode+local->second;
         jump_base = bytecode;
     } else {
-        call_address = linked_functions.at(call_name).second;
-        jump_base = linked_modules.at(linked_functions.at(call_name).first).second;
+        const pair<string, byte*>& linked = linked_functions.at(call_name);
+        call_address = linked.second;
+        jump_base = linked_modules.at(linked.first).second;
     }
     if (real_call_name.size()) {
         addr += (real_call_name.size()+1);
@@ -296,20 +344,43 @@ byte* CPU::callForeign(byte* addr, const string& call_name, const bool& return_r
     frame_new->resolve_return_value_register = return_ref;
     frame_new->place_return_value_in = return_index;
 
+    if (blocking_functions.count(call_name)) {
+        return callBlocking(return_address, call_name, return_ref, return_index);
+    }
+
     Frame* frame = frame_new;
 
     pushFrame();
 
-    if (foreign_functions.count(call_name) == 0) {
+    auto builtin = builtin_functions.find(call_name);
+    if (builtin == builtin_functions.end() and foreign_functions.count(call_name) == 0) {
         throw new Exception("call to unregistered external function: " + call_name);
     }
 
-    /* FIXME: second parameter should be a pointer to static registers or
-     *        0 if function does not have static registers registered
-     * FIXME: should external functions always have static registers allocated?
-     */
-    ExternalFunction* callback = foreign_functions.at(call_name);
-    (*callback)(frame, nullptr, regset);
+    try {
+        if (builtin != builtin_functions.end()) {
+            (this->*(builtin->second))(frame);
+            if (thrown != nullptr) {
+                // builtin functions may throw any object so they set the thrown slot themselves
+                return return_address;
+            }
+        } else {
+            /* FIXME: second parameter should be a pointer to static registers or
+             *        0 if function does not have static registers registered
+             * FIXME: should external functions always have static registers allocated?
+             */
+            ExternalFunction* callback = foreign_functions.at(call_name);
+            (*callback)(frame, nullptr, regset);
+        }
+    } catch (const WouldBlock& e) {
+        // frame is given back so the call can be run again
+        frames.pop_back();
+        frame_new = frame;
+        uregset = (frames.size() ? frames.back()->regset : regset);
+        waiting = true;
+        waiting_for = e;
+        return nullptr;
+    }
 
     // FIXME: woohoo! segfault!
     Type* returned = nullptr;
@@ -344,6 +415,53 @@ byte* CPU::callForeign(byte* addr, const string& call_name, const bool& return_r
 
     return return_address;
 }
+byte* CPU::callBlocking(byte* return_address, const string& call_name, const bool& return_ref, const int& return_index) {
+    /** Run a call to blocking foreign function on a thread of the blocking call pool.
+     *
+     *  Frame of the call is taken over by the background thread together with copies of its parameters (the caller
+     *  may modify or free the originals while the call runs), and
+     *  a future resolved when the function returns is put in the return register.
+     */
+    Frame* frame = frame_new;
+    frame_new = nullptr;
+    for (unsigned i = 0; i < frame->args->size(); ++i) {
+        Type* parameter = frame->args->at(i);
+        if (parameter == nullptr) {
+            continue;
+        }
+        // references share their reference counts so the object they point to is copied instead
+        Reference* rf = dynamic_cast<Reference*>(parameter);
+        frame->args->empty(i);
+        frame->args->set(i, ((rf == nullptr) ? parameter : rf->pointsTo())->copy());
+    }
+    frame->owns_arguments = true;
+
+    ExternalFunction* callback = foreign_functions.at(call_name);
+    shared_ptr<Future::State> state = make_shared<Future::State>(call_name);
+    kernel->blocking_calls.submit([frame, callback, state]() {
+        try {
+            (*callback)(frame, nullptr, nullptr);
+            if (frame->regset->at(0) != nullptr) {
+                state->value = frame->regset->at(0)->copy();
+            }
+        } catch (Type* e) {
+            state->thrown = e;
+        } catch (const char* e) {
+            state->thrown = new Exception(e);
+        } catch (const WouldBlock&) {
+            state->thrown = new Exception("blocking foreign function would block: " + frame->function_name);
+        }
+        delete frame;
+        state->resolved.store(true);
+    });
+
+    if (return_index != 0) {
+        place(unsigned(return_ref ? static_cast<Integer*>(fetch(unsigned(return_index)))->value() : return_index), new Future(state));
+    }
+
+    return return_address;
+}
+
 byte* CPU::callForeignMethod(byte* addr, Type* object, const string& call_name, const bool& return_ref, const int& return_index, const string& real_call_name) {
     if (real_call_name.size()) {
         addr += (real_call_name.size()+1);
@@ -419,37 +537,52 @@ byte* CPU::callForeignMethod(byte* addr, Type* object, const string& call_name,
 }
 
 void CPU::loadNativeLibrary(const string& module) {
-    regex double_colon("::");
-    ostringstream oss;
-    oss << regex_replace(module, double_colon, "/");
-    string try_path = oss.str();
+    // regular expressions are not used here as compiling them touches locale data shared by all threads
+    string try_path = module;
+    for (string::size_type i = try_path.find("::"); i != string::npos; i = try_path.find("::", i)) {
+        try_path.replace(i, 2, "/");
+    }
     string path = support::env::viua::getmodpath(try_path, "vlib", support::env::getpaths("VIUAPATH"));
     if (path.size() == 0) { path = support::env::viua::getmodpath(try_path, "vlib", VIUAPATH); }
     if (path.size() == 0) { path = support::env::viua::getmodpath(try_path, "vlib", support::env::getpaths("VIUAAFTERPATH")); }
 
-    if (path.size()) {
-        Loader loader(path);
-        loader.load();
+    if (path.size() == 0) {
+        throw new Exception("failed to link: " + module);
+    }
 
-        byte* lnk_btcd = loader.getBytecode();
-        linked_modules[module] = pair<unsigned, byte*>(unsigned(loader.getBytecodeSize()), lnk_btcd);
+    shared_ptr<const ModuleImage> image = ModuleImage::library(path);
+    byte* lnk_btcd = image->bytecode;
+    linked_images[module] = image;
+    linked_modules[module] = pair<unsigned, byte*>(unsigned(image->size), lnk_btcd);
 
-        vector<string> fn_names = loader.getFunctions();
-        map<string, uint16_t> fn_addrs = loader.getFunctionAddresses();
-        for (unsigned i = 0; i < fn_names.size(); ++i) {
-            string fn_linkname = fn_names[i];
-            linked_functions[fn_linkname] = pair<string, byte*>(module, (lnk_btcd+fn_addrs[fn_names[i]]));
-        }
+    const map<string, uint32_t>& fn_addrs = image->function_addresses;
+    linked_functions.reserve(linked_functions.size() + fn_addrs.size());
+    for (auto fn : fn_addrs) {
+        linked_functions[fn.first] = pair<string, byte*>(module, (lnk_btcd+fn.second));
+    }
 
-        vector<string> bl_names = loader.getBlocks();
-        map<string, uint16_t> bl_addrs = loader.getBlockAddresses();
-        for (unsigned i = 0; i < bl_names.size(); ++i) {
-            string bl_linkname = bl_names[i];
-            linked_blocks[bl_linkname] = pair<string, byte*>(module, (lnk_btcd+bl_addrs[bl_linkname]));
+    // register set sizes of local functions take precedence as local functions are called instead of linked ones
+    const map<string, uint32_t>& fn_registers = image->function_registers;
+    for (auto fn : fn_addrs) {
+        if (function_addresses.count(fn.first)) {
+            continue;
+        }
+        auto required = fn_registers.find(fn.first);
+        if (required != fn_registers.end()) {
+            function_registers[fn.first] = required->second;
+        } else {
+            function_registers.erase(fn.first);
         }
-    } else {
-        throw new Exception("failed to link: " + module);
     }
+
+    const map<string, uint32_t>& bl_addrs = image->block_addresses;
+    linked_blocks.reserve(linked_blocks.size() + bl_addrs.size());
+    for (auto bl : bl_addrs) {
+        linked_blocks[bl.first] = pair<string, byte*>(module, (lnk_btcd+bl.second));
+    }
+
+    // unverified module switches the CPU back to checked execution
+    verified = (verified and image->verified);
 }
 void CPU::loadForeignLibrary(const string& module) {
     string path = "";
@@ -461,26 +594,11 @@ void CPU::loadForeignLibrary(const string& module) {
         throw new Exception("LinkException", ("failed to link library: " + module));
     }
 
-    void* handle = dlopen(path.c_str(), RTLD_LAZY);
-
-    if (handle == nullptr) {
-        throw new Exception("LinkException", ("failed to open handle: " + module));
+    shared_ptr<const ForeignLibrary> library = ForeignLibrary::open(path);
+    for (const auto& each : library->functions) {
+        registerExternalFunction(get<0>(each), get<1>(each), get<2>(each));
     }
-
-    ExternalFunctionSpec* (*exports)() = nullptr;
-    if ((exports = (ExternalFunctionSpec*(*)())dlsym(handle, "exports")) == nullptr) {
-        throw new Exception("failed to extract interface from module: " + module);
-    }
-
-    ExternalFunctionSpec* exported = (*exports)();
-
-    unsigned i = 0;
-    while (exported[i].name != NULL) {
-        registerExternalFunction(exported[i].name, exported[i].fpointer);
-        ++i;
-    }
-
-    cxx_dynamic_lib_handles.push_back(handle);
+    foreign_libraries.push_back(library);
 }
 
 
@@ -552,6 +670,33 @@ CPU& CPU::iframe(Frame* frm, unsigned r) {
 }
 
 
+void CPU::unwind(TryFrame* tframe) {
+    /** Drop frames and try frames above the ones in which a thrown object is caught.
+     */
+    unsigned distance = 0;
+    for (long unsigned j = (frames.size()-1); j > 0; --j) {
+        if (frames[j] == tframe->associated_frame) {
+            break;
+        }
+        ++distance;
+    }
+    for (unsigned j = 0; j < distance; ++j) {
+        dropFrame();
+    }
+
+    while (tryframes.back() != tframe) {
+        delete tryframes.back();
+        tryframes.pop_back();
+    }
+
+    // coroutines whose frames were dropped cannot be resumed
+    while (coroutines.size() and coroutines.back()->frames_base >= frames.size()) {
+        coroutines.back()->running = false;
+        coroutines.back()->finished = true;
+        coroutines.pop_back();
+    }
+}
+
 byte* CPU::tick() {
     /** Perform a *tick*, i.e. run a single CPU instruction.
      *
@@ -561,6 +706,11 @@ byte* CPU::tick() {
     bool halt = false;
     byte* previous_instruction_pointer = instruction_pointer;
     ++instruction_counter;
+    waiting = false;
+
+    if (profiling) {
+        profileInstruction(instruction_pointer);
+    }
 
     try {
         instruction_pointer = dispatch(instruction_pointer);
@@ -581,43 +731,48 @@ byte* CPU::tick() {
 
     if (halt or frames.size() == 0) { return nullptr; }
 
-    /*  Machine should halt execution if the instruction pointer exceeds bytecode size and
-     *  top frame is for local function.
-     *  For dynamically linked functions address will not be in bytecode size range.
+    /*  Verified bytecode cannot leave its functions or loop on a single instruction so
+     *  sanity checks below are needed only when running unverified code.
      */
-    Frame* top_frame = (frames.size() ? frames.back() : nullptr);
-    TryFrame* top_tryframe = (tryframes.size() ? tryframes.back() : nullptr);
-    bool is_current_function_dynamic = linked_functions.count(top_frame != nullptr ? top_frame->function_name : "");
-    bool is_current_block_dynamic = linked_blocks.count(top_tryframe != nullptr ? top_tryframe->block_name : "");
-    if (instruction_pointer >= (bytecode+bytecode_size) and not (is_current_function_dynamic or is_current_block_dynamic)) {
-        return_code = 1;
-        return_exception = "InvalidBytecodeAddress";
-        return_message = string("instruction address out of bounds");
-        return nullptr;
-    }
+    if (not verified) {
+        /*  Machine should halt execution if the instruction pointer exceeds bytecode size and
+         *  top frame is for local function.
+         *  For dynamically linked functions address will not be in bytecode size range.
+         */
+        Frame* top_frame = (frames.size() ? frames.back() : nullptr);
+        TryFrame* top_tryframe = (tryframes.size() ? tryframes.back() : nullptr);
+        bool is_current_function_dynamic = linked_functions.count(top_frame != nullptr ? top_frame->function_name : "");
+        bool is_current_block_dynamic = linked_blocks.count(top_tryframe != nullptr ? top_tryframe->block_name : "");
+        if (instruction_pointer >= (bytecode+bytecode_size) and not (is_current_function_dynamic or is_current_block_dynamic)) {
+            return_code = 1;
+            return_exception = "InvalidBytecodeAddress";
+            return_message = string("instruction address out of bounds");
+            return nullptr;
+        }
 
-    /*  Machine should halt execution if previous instruction pointer is the same as current one as
-     *  it means that the execution flow is corrupted.
-     *
-     *  However, execution *should not* be halted if:
-     *      - the offending opcode is END (as this may indicate exiting recursive function),
-     *      - an object has been thrown, as the instruction pointer will be adjusted by
-     *        catchers or execution will be halted on unhandled types,
-     */
-    if (instruction_pointer == previous_instruction_pointer and OPCODE(*instruction_pointer) != END and thrown == nullptr) {
-        return_code = 2;
-        ostringstream oss;
-        return_exception = "InstructionUnchanged";
-        oss << "instruction pointer did not change, possibly endless loop\n";
-        oss << "note: instruction index was " << (instruction_pointer-bytecode) << " and the opcode was '" << OP_NAMES.at(OPCODE(*instruction_pointer)) << "'";
-        if (OPCODE(*instruction_pointer) == CALL) {
-            oss << '\n';
-            oss << "note: this was caused by 'call' opcode immediately calling itself\n"
-                << "      such situation may have several sources, e.g. empty function definition or\n"
-                << "      a function which calls itself in its first instruction";
+        /*  Machine should halt execution if previous instruction pointer is the same as current one as
+         *  it means that the execution flow is corrupted.
+         *
+         *  However, execution *should not* be halted if:
+         *      - the offending opcode is END (as this may indicate exiting recursive function),
+         *      - an object has been thrown, as the instruction pointer will be adjusted by
+         *        catchers or execution will be halted on unhandled types,
+         */
+        if (instruction_pointer == previous_instruction_pointer and OPCODE(*instruction_pointer) != END and thrown == nullptr and not waiting) {
+            return_code = 2;
+            ostringstream oss;
+            return_exception = "InstructionUnchanged";
+            oss << "instruction pointer did not change, possibly endless loop\n";
+            oss << "note: instruction index was " << (instruction_pointer-bytecode) << " and the opcode was '" << OP_NAMES.at(OPCODE(*instruction_pointer)) << "'";
+            if (OPCODE(*instruction_pointer) == CALL) {
+                oss << '\n';
+                oss << "note: this was caused by 'call' opcode immediately calling itself\n"
+                    << "      such situation may have several sources, e.g. empty function definition or\n"
+                    << "      a function which calls itself in its first instruction";
+            }
+            return_message = oss.str();
+            return nullptr;
         }
-        return_message = oss.str();
-        return nullptr;
     }
 
     TryFrame* tframe;
@@ -629,6 +784,7 @@ byte* CPU::tick() {
             tframe = tryframes[(i-1)];
             if (tframe->catchers.count(exception_detailed_type)) {
                 instruction_pointer = tframe->catchers.at(exception_detailed_type)->block_address;
+                unwind(tframe);
 
                 caught = thrown;
                 thrown = nullptr;
@@ -657,22 +813,7 @@ byte* CPU::tick() {
 
             if (handler_found) {
                 instruction_pointer = tframe->catchers.at(handler_found_for_type)->block_address;
-
-                unsigned distance = 0;
-                for (long unsigned j = (frames.size()-1); j > 1; --j) {
-                    if (frames[j] == tframe->associated_frame) {
-                        break;
-                    }
-                    ++distance;
-                }
-                for (unsigned j = 0; j < distance; ++j) {
-                    dropFrame();
-                }
-
-                while (tryframes.back() != tframe) {
-                    delete tryframes.back();
-                    tryframes.pop_back();
-                }
+                unwind(tframe);
 
                 caught = thrown;
                 thrown = nullptr;
@@ -691,16 +832,112 @@ byte* CPU::tick() {
     return instruction_pointer;
 }
 
-int CPU::run() {
-    /*  VM CPU implementation.
+string CPU::verify() {
+    /** Verify loaded bytecode.
+     *
+     *  Returns report of the verification (empty if bytecode is correct).
+     *  Verified bytecode is run without per-instruction sanity checks.
+     */
+    string report = verifier::verify(bytecode, bytecode_size, function_addresses, block_addresses);
+    verified = (report == "");
+    return report;
+}
+
+CPU& CPU::threads(unsigned n) {
+    /** Set number of worker threads running processes of the program.
+     */
+    worker_threads = (n ? n : 1);
+    return (*this);
+}
+
+void CPU::ensureSingleProcess(const string& action) {
+    /** Throw if other processes are running.
+     *
+     *  Typesystem, linked modules and foreign libraries are shared by all processes of a program and
+     *  must not be modified while other processes may be reading them.
+     */
+    if (kernel->scheduler and kernel->scheduler->processes() > 1) {
+        throw new Exception("cannot " + action + " while other processes are running");
+    }
+}
+
+CPU& CPU::enableProfiling() {
+    /** Enable collection of execution profile.
+     *
+     *  Profile is available after the CPU stopped running.
+     */
+    profiling = true;
+    return (*this);
+}
+
+void CPU::prepareProfile() {
+    /** Find extents of functions and blocks in loaded bytecode.
+     *
+     *  Each function or block extends up to the beginning of the next one.
+     */
+    profile_entries.clear();
+    for (auto* addresses : { &function_addresses, &block_addresses }) {
+        for (const auto& each : *addresses) {
+            if (each.second >= bytecode_size) {
+                continue;
+            }
+            profile_entries.push_back(ProfileEntry{ each.first, (addresses == &block_addresses), each.second, bytecode_size, 0, 0 });
+        }
+    }
+    sort(profile_entries.begin(), profile_entries.end(), [](const ProfileEntry& a, const ProfileEntry& b) {
+        return (a.begin < b.begin or (a.begin == b.begin and a.name < b.name));
+    });
+    for (unsigned i = 0; (i+1) < profile_entries.size(); ++i) {
+        profile_entries[i].end = profile_entries[i+1].begin;
+    }
+    profile_current = 0;
+}
+
+void CPU::profileInstruction(byte* instruction) {
+    /** Account an instruction that is about to be executed to its function or block.
+     */
+    if (profile_entries.size() == 0 or instruction < bytecode or instruction >= (bytecode+bytecode_size)) {
+        return;
+    }
+    uint32_t offset = uint32_t(instruction-bytecode);
+
+    // instructions are most likely to come from the same function or block as the previous one
+    if (offset < profile_entries[profile_current].begin or offset >= profile_entries[profile_current].end) {
+        auto found = upper_bound(profile_entries.begin(), profile_entries.end(), offset, [](uint32_t o, const ProfileEntry& e) {
+            return (o < e.begin);
+        });
+        if (found == profile_entries.begin() or offset >= (found-1)->end) {
+            return;
+        }
+        profile_current = unsigned((found-1)-profile_entries.begin());
+    }
+
+    ProfileEntry& entry = profile_entries[profile_current];
+    if (offset == entry.begin) {
+        ++entry.entries;
+    }
+    ++entry.instructions;
+}
+
+void CPU::startProgram() {
+    /** Prepare loaded bytecode to be run.
      */
     if (!bytecode) {
         throw "null bytecode (maybe not loaded?)";
     }
 
+    verify();
+    if (profiling) {
+        prepareProfile();
+    }
     iframe();
     begin(); // set the instruction pointer
-    while (tick()) {}
+}
+
+void CPU::finishProgram(Scheduler& scheduler) {
+    /** Set exit condition of a program whose processes have all finished.
+     */
+    process_failures = scheduler.failures();
 
     if (return_code == 0 and regset->at(0)) {
         // if return code if the default one and
@@ -721,8 +958,52 @@ int CPU::run() {
     // do not delete if execution was halted because of exception
     if (return_exception == "") {
         delete frames.back();
+        frames.pop_back();
         delete regset;
+        regset = nullptr;
     }
+}
+
+int CPU::run() {
+    /*  VM CPU implementation.
+     */
+    startProgram();
+
+    /*  Processes spawned by the program run alongside it.
+     *  Program stops running when all of its processes finish.
+     */
+    Scheduler scheduler(worker_threads);
+    kernel->scheduler = &scheduler;
+    scheduler.run(this);
+    kernel->scheduler = nullptr;
+    finishProgram(scheduler);
 
     return return_code;
 }
+
+RUN_STATUS CPU::runFor(unsigned instructions) {
+    /** Run the program for at most given number of instructions (counted across all of its processes).
+     *
+     *  Program is started by the first call, and every next call resumes it.
+     *  Processes are run on calling thread so an embedder can interleave several programs on one thread,
+     *  giving each of them a budget in turn.
+     *  When RUN_FINISHED is returned the exit condition of the program is set as it is after run().
+     */
+    if (not budgeted_scheduler) {
+        startProgram();
+        budgeted_scheduler.reset(new Scheduler(worker_threads));
+        budgeted_scheduler->start(this);
+    } else if (budgeted_scheduler->processes() == 0) {
+        return RUN_FINISHED;
+    }
+
+    kernel->scheduler = budgeted_scheduler.get();
+    unsigned executed = budgeted_scheduler->runFor(instructions);
+    kernel->scheduler = nullptr;
+
+    if (budgeted_scheduler->processes() == 0) {
+        finishProgram(*budgeted_scheduler);
+        return RUN_FINISHED;
+    }
+    return ((executed < instructions) ? RUN_WAITING : RUN_PREEMPTED);
+}
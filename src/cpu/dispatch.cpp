@@ -48,6 +48,33 @@ byte* CPU::dispatch(byte* addr) {
         case IEQ:
             addr = ieq(addr+1);
             break;
+        case TIADD:
+            addr = tiadd(addr+1);
+            break;
+        case TISUB:
+            addr = tisub(addr+1);
+            break;
+        case TIMUL:
+            addr = timul(addr+1);
+            break;
+        case TIDIV:
+            addr = tidiv(addr+1);
+            break;
+        case TILT:
+            addr = tilt(addr+1);
+            break;
+        case TILTE:
+            addr = tilte(addr+1);
+            break;
+        case TIGT:
+            addr = tigt(addr+1);
+            break;
+        case TIGTE:
+            addr = tigte(addr+1);
+            break;
+        case TIEQ:
+            addr = tieq(addr+1);
+            break;
         case FSTORE:
             addr = fstore(addr+1);
             break;
@@ -189,6 +216,24 @@ byte* CPU::dispatch(byte* addr) {
         case CALL:
             addr = call(addr+1);
             break;
+        case TAILCALL:
+            addr = tailcall(addr+1);
+            break;
+        case SPAWN:
+            addr = spawn(addr+1);
+            break;
+        case COROUTINE:
+            addr = coroutine(addr+1);
+            break;
+        case RESUME:
+            addr = resume(addr+1);
+            break;
+        case YIELD:
+            addr = yield(addr+1);
+            break;
+        case WAIT:
+            addr = wait(addr+1);
+            break;
         case END:
             addr = end(addr);
             break;
@@ -0,0 +1,314 @@
+#include <algorithm>
+#include <memory>
+#include <thread>
+#include <viua/types/vector.h>
+#include <viua/types/function.h>
+#include <viua/types/closure.h>
+#include <viua/types/reference.h>
+#include <viua/types/exception.h>
+#include <viua/cpu/cpu.h>
+#include <viua/cpu/scheduler.h>
+using namespace std;
+
+
+/*  Chunks are not made smaller than this so short vectors are processed without
+ *  the cost of starting threads.
+ */
+const unsigned MINIMAL_CHUNK_SIZE = 256;
+
+
+const map<string, CPU::BuiltinFunction> CPU::builtin_functions = {
+    { "std::functional::pmap", &CPU::pmap },
+    { "std::functional::pfilter", &CPU::pfilter },
+    { "std::functional::preduce", &CPU::preduce },
+};
+
+
+static Type* argument(Frame* frame, unsigned i) {
+    Type* object = frame->args->at(i);
+    if (object == nullptr) {
+        throw new Exception("missing argument for " + frame->function_name);
+    }
+    Reference* rf = dynamic_cast<Reference*>(object);
+    return ((rf == nullptr) ? object : rf->pointsTo());
+}
+
+static Function* functionArgument(Frame* frame, unsigned i) {
+    Function* fn = dynamic_cast<Function*>(argument(frame, i));
+    if (fn == nullptr) {
+        throw new Exception(frame->function_name + ": expected Function or Closure as argument " + to_string(i));
+    }
+    return fn;
+}
+
+static Vector* vectorArgument(Frame* frame, unsigned i) {
+    Vector* vec = dynamic_cast<Vector*>(argument(frame, i));
+    if (vec == nullptr) {
+        throw new Exception(frame->function_name + ": expected Vector as argument " + to_string(i));
+    }
+    return vec;
+}
+
+static Type* copyOf(Type* object) {
+    // references share their reference counts (which is not safe to do from many threads) so
+    // the object they point to is copied instead
+    Reference* rf = dynamic_cast<Reference*>(object);
+    return ((rf == nullptr) ? object : rf->pointsTo())->copy();
+}
+
+static Function* isolatedCopy(Function* fn) {
+    // objects bound by closures are referenced by them so each chunk gets its own copies
+    Closure* closure = dynamic_cast<Closure*>(fn);
+    if (closure == nullptr) {
+        return static_cast<Function*>(fn->copy());
+    }
+    Closure* isolated = new Closure();
+    isolated->function_name = closure->function_name;
+    isolated->regset = new RegisterSet(closure->regset->size());
+    for (unsigned i = 0; i < closure->regset->size(); ++i) {
+        if (closure->regset->at(i) != nullptr) {
+            isolated->regset->set(i, copyOf(closure->regset->at(i)));
+        }
+    }
+    return isolated;
+}
+
+
+Type* CPU::applyFunction(Function* fn, const vector<Type*>& parameters) {
+    /** Call a function object in this context and run it until it returns.
+     *
+     *  Parameters become owned by the frame of the call.
+     *  Returns object returned by the function, and
+     *  throws object the function did not catch.
+     */
+    string call_name = fn->name();
+    auto required = function_registers.find(call_name);
+    requestNewFrame(static_cast<int>(parameters.size()), static_cast<int>((required != function_registers.end()) ? required->second : DEFAULT_REGISTER_SIZE));
+    for (unsigned i = 0; i < parameters.size(); ++i) {
+        frame_new->args->set(i, parameters[i]);
+    }
+    frame_new->owns_arguments = true;
+
+    // return value is placed in the first register of the initial frame of the context
+    instruction_pointer = callNative(bytecode, call_name, false, 1, "");
+    frames.back()->return_address = nullptr;
+    if (fn->type() == "Closure") {
+        uregset = static_cast<Closure*>(fn)->regset;
+    }
+
+    while (tick() != nullptr) {
+        if (waiting) {
+            this_thread::yield();
+        }
+    }
+
+    if (thrown != nullptr or return_exception.size() or frames.size() > 1) {
+        Type* failure = thrown;
+        thrown = nullptr;
+        if (failure == nullptr) {
+            failure = new Exception(return_exception.size() ? return_message : ("function did not return: " + call_name));
+        }
+        throw failure;
+    }
+
+    Type* returned = uregset->get(1);
+    if (uregset->isflagged(1, REFERENCE)) {
+        returned = returned->copy();
+    }
+    uregset->empty(1);
+    return returned;
+}
+
+bool CPU::processChunks(Function* fn, unsigned elements, const std::function<void(CPU*, Function*, unsigned, unsigned, vector<Type*>&)>& work, vector<vector<Type*>>& results) {
+    /** Run work on consecutive chunks of elements, each in its own context and on its own thread.
+     *
+     *  Work of every chunk is given its own copy of the function it applies.
+     *  Work appends objects it produced for its chunk to the vector it is given.
+     *  Results of chunks are stored in order.
+     *
+     *  Returns false if work failed on any of the chunks.
+     *  Object thrown for the chunk closest to the beginning is put in the thrown slot so
+     *  the failure that is reported does not depend on scheduling of threads, and
+     *  results of all chunks are deleted.
+     */
+    // chunks are processed by as many threads as there are workers running processes
+    unsigned threads = ((kernel->scheduler != nullptr) ? kernel->scheduler->workers() : 1);
+    unsigned chunks = min(threads, (elements + MINIMAL_CHUNK_SIZE - 1) / MINIMAL_CHUNK_SIZE);
+    if (chunks == 0) {
+        return true;
+    }
+
+    results.assign(chunks, vector<Type*>());
+    vector<Type*> failures(chunks, nullptr);
+    vector<unique_ptr<Function>> functions;
+    for (unsigned chunk = 0; chunk < chunks; ++chunk) {
+        functions.emplace_back(isolatedCopy(fn));
+    }
+
+    auto run = [&](unsigned chunk) {
+        unsigned begin = (elements / chunks) * chunk + min(chunk, elements % chunks);
+        unsigned end = begin + (elements / chunks) + ((chunk < (elements % chunks)) ? 1 : 0);
+
+        CPU context(kernel);
+        context.verified = verified;
+        context.debug = debug;
+        context.errors = errors;
+        Frame* initial_frame = new Frame(nullptr, 0, 2);
+        initial_frame->function_name = frames.back()->function_name;
+        context.iframe(initial_frame);
+
+        try {
+            work(&context, functions[chunk].get(), begin, end, results[chunk]);
+        } catch (Type* e) {
+            failures[chunk] = e;
+        } catch (const char* e) {
+            failures[chunk] = new Exception(e);
+        }
+
+        while (context.frames.size()) {
+            context.dropFrame();
+        }
+        for (TryFrame* tframe : context.tryframes) {
+            delete tframe;
+        }
+        delete context.caught;
+    };
+
+    vector<thread> workers;
+    for (unsigned chunk = 1; chunk < chunks; ++chunk) {
+        workers.emplace_back(run, chunk);
+    }
+    run(0);
+    for (thread& worker : workers) {
+        worker.join();
+    }
+
+    auto failure = find_if(failures.begin(), failures.end(), [](Type* e) { return e != nullptr; });
+    if (failure == failures.end()) {
+        return true;
+    }
+
+    thrown = *failure;
+    for (auto other = (failure+1); other != failures.end(); ++other) {
+        delete *other;
+    }
+    for (vector<Type*>& produced : results) {
+        for (Type* object : produced) {
+            delete object;
+        }
+    }
+    results.clear();
+    return false;
+}
+
+void CPU::pmap(Frame* frame) {
+    /** Return vector of results of applying a function to each element of a vector.
+     */
+    Function* fn = functionArgument(frame, 0);
+    Vector* vec = vectorArgument(frame, 1);
+    if (not (function_addresses.count(fn->name()) or linked_functions.count(fn->name()))) {
+        throw new Exception("pmap of undefined function: " + fn->name());
+    }
+
+    vector<Type*>& elements = vec->value();
+    vector<vector<Type*>> results;
+    bool finished = processChunks(fn, static_cast<unsigned>(elements.size()), [&elements](CPU* context, Function* applied, unsigned begin, unsigned end, vector<Type*>& produced) {
+        for (unsigned i = begin; i < end; ++i) {
+            produced.push_back(context->applyFunction(applied, { copyOf(elements[i]) }));
+        }
+    }, results);
+    if (not finished) {
+        return;
+    }
+
+    Vector* mapped = new Vector();
+    for (vector<Type*>& produced : results) {
+        mapped->value().insert(mapped->value().end(), produced.begin(), produced.end());
+    }
+    frame->regset->set(0, mapped);
+}
+
+void CPU::pfilter(Frame* frame) {
+    /** Return vector of elements of a vector for which a function returned true.
+     */
+    Function* fn = functionArgument(frame, 0);
+    Vector* vec = vectorArgument(frame, 1);
+    if (not (function_addresses.count(fn->name()) or linked_functions.count(fn->name()))) {
+        throw new Exception("pfilter of undefined function: " + fn->name());
+    }
+
+    vector<Type*>& elements = vec->value();
+    vector<vector<Type*>> results;
+    bool finished = processChunks(fn, static_cast<unsigned>(elements.size()), [&elements](CPU* context, Function* applied, unsigned begin, unsigned end, vector<Type*>& produced) {
+        for (unsigned i = begin; i < end; ++i) {
+            unique_ptr<Type> keep(context->applyFunction(applied, { copyOf(elements[i]) }));
+            if (keep->boolean()) {
+                produced.push_back(copyOf(elements[i]));
+            }
+        }
+    }, results);
+    if (not finished) {
+        return;
+    }
+
+    Vector* filtered = new Vector();
+    for (vector<Type*>& produced : results) {
+        filtered->value().insert(filtered->value().end(), produced.begin(), produced.end());
+    }
+    frame->regset->set(0, filtered);
+}
+
+void CPU::preduce(Frame* frame) {
+    /** Reduce a vector to a single value by applying a function to an accumulator and each element.
+     *
+     *  Function must be associative: chunks are reduced in parallel (the first one starting with the initial value, and
+     *  the others with their first element), and their results are then combined in order.
+     */
+    Function* fn = functionArgument(frame, 0);
+    Vector* vec = vectorArgument(frame, 1);
+    Type* initial = argument(frame, 2);
+    if (not (function_addresses.count(fn->name()) or linked_functions.count(fn->name()))) {
+        throw new Exception("preduce of undefined function: " + fn->name());
+    }
+
+    vector<Type*>& elements = vec->value();
+    vector<vector<Type*>> results;
+    bool finished = processChunks(fn, static_cast<unsigned>(elements.size()), [initial, &elements](CPU* context, Function* applied, unsigned begin, unsigned end, vector<Type*>& produced) {
+        Type* accumulator = ((begin == 0) ? initial->copy() : copyOf(elements[begin++]));
+        for (unsigned i = begin; i < end; ++i) {
+            // accumulator becomes owned by the frame of the call
+            accumulator = context->applyFunction(applied, { accumulator, copyOf(elements[i]) });
+        }
+        produced.push_back(accumulator);
+    }, results);
+    if (not finished) {
+        return;
+    }
+
+    if (results.size() == 0) {
+        frame->regset->set(0, initial->copy());
+        return;
+    }
+
+    // results of chunks are combined in this thread, in a context of its own
+    vector<vector<Type*>> combined;
+    finished = processChunks(fn, 1, [&results](CPU* context, Function* applied, unsigned, unsigned, vector<Type*>& produced) {
+        Type* accumulator = results[0][0];
+        results[0].clear();
+        for (unsigned i = 1; i < results.size(); ++i) {
+            Type* partial = results[i][0];
+            results[i].clear();
+            accumulator = context->applyFunction(applied, { accumulator, partial });
+        }
+        produced.push_back(accumulator);
+    }, combined);
+    if (not finished) {
+        for (vector<Type*>& partials : results) {
+            for (Type* object : partials) {
+                delete object;
+            }
+        }
+        return;
+    }
+    frame->regset->set(0, combined[0][0]);
+}
@@ -0,0 +1,106 @@
+#include <dlfcn.h>
+#include <mutex>
+#include <unordered_map>
+#include <viua/types/exception.h>
+#include <viua/loader.h>
+#include <viua/cpu/verifier.h>
+#include <viua/cpu/image.h>
+using namespace std;
+
+
+/*  Libraries that are currently loaded, by path.
+ *  CPUs running on different threads link and import modules concurrently so
+ *  the registries are guarded by locks.
+ *  Registries do not keep libraries alive: a library is loaded again after all CPUs using it were destroyed.
+ */
+static mutex images_lock;
+static unordered_map<string, weak_ptr<const ModuleImage>> loaded_images;
+
+static mutex libraries_lock;
+static unordered_map<string, weak_ptr<const ForeignLibrary>> opened_libraries;
+
+
+ModuleImage::ModuleImage(const string& p, byte* b, uint32_t s, const map<string, uint32_t>& functions, const map<string, uint32_t>& blocks, const map<string, uint32_t>& registers, bool v):
+    path(p), bytecode(b), size(s),
+    function_addresses(functions), block_addresses(blocks), function_registers(registers),
+    verified(v)
+{
+}
+
+ModuleImage::~ModuleImage() {
+    delete[] bytecode;
+}
+
+shared_ptr<const ModuleImage> ModuleImage::executable(const string& path) {
+    /** Load an executable.
+     *
+     *  Executables are not shared through the registry (a host that runs a program on many CPUs
+     *  loads it once and gives the image to each of them).
+     */
+    Loader loader(path);
+    loader.executable();
+    return make_shared<const ModuleImage>(path, loader.getBytecode(), loader.getBytecodeSize(), loader.getFunctionAddresses(), loader.getBlockAddresses(), loader.getFunctionRegisters(), false);
+}
+
+shared_ptr<const ModuleImage> ModuleImage::library(const string& path) {
+    /** Get image of a library, loading it if no CPU is using it yet.
+     */
+    lock_guard<mutex> lck(images_lock);
+    shared_ptr<const ModuleImage> image = loaded_images[path].lock();
+    if (image) {
+        return image;
+    }
+
+    Loader loader(path);
+    loader.load();
+
+    const map<string, uint32_t>& fn_addrs = loader.getFunctionAddresses();
+    const map<string, uint32_t>& bl_addrs = loader.getBlockAddresses();
+    byte* bytecode = loader.getBytecode();
+    unordered_map<string, unsigned> module_functions(fn_addrs.begin(), fn_addrs.end());
+    unordered_map<string, unsigned> module_blocks(bl_addrs.begin(), bl_addrs.end());
+    bool verified = (verifier::verify(bytecode, loader.getBytecodeSize(), module_functions, module_blocks) == "");
+
+    image = make_shared<const ModuleImage>(path, bytecode, loader.getBytecodeSize(), fn_addrs, bl_addrs, loader.getFunctionRegisters(), verified);
+    loaded_images[path] = image;
+    return image;
+}
+
+
+ForeignLibrary::ForeignLibrary(const string& p, void* h, const vector<tuple<string, ExternalFunction*, bool>>& f): handle(h), path(p), functions(f) {
+}
+
+ForeignLibrary::~ForeignLibrary() {
+    dlclose(handle);
+}
+
+shared_ptr<const ForeignLibrary> ForeignLibrary::open(const string& path) {
+    /** Get a foreign library, opening it if no CPU is using it yet.
+     */
+    lock_guard<mutex> lck(libraries_lock);
+    shared_ptr<const ForeignLibrary> library = opened_libraries[path].lock();
+    if (library) {
+        return library;
+    }
+
+    void* handle = dlopen(path.c_str(), RTLD_LAZY);
+    if (handle == nullptr) {
+        throw new Exception("LinkException", ("failed to open handle: " + path));
+    }
+
+    ExternalFunctionSpec* (*exports)() = nullptr;
+    if ((exports = (ExternalFunctionSpec*(*)())dlsym(handle, "exports")) == nullptr) {
+        dlclose(handle);
+        throw new Exception("failed to extract interface from module: " + path);
+    }
+
+    vector<tuple<string, ExternalFunction*, bool>> functions;
+    ExternalFunctionSpec* exported = (*exports)();
+    for (unsigned i = 0; exported[i].name != NULL; ++i) {
+        functions.emplace_back(exported[i].name, exported[i].fpointer, exported[i].blocking);
+    }
+
+    library = make_shared<const ForeignLibrary>(path, handle, functions);
+    opened_libraries[path] = library;
+    return library;
+}
@@ -1,8 +1,10 @@
 #include <viua/types/boolean.h>
 #include <viua/types/reference.h>
+#include <viua/types/coroutine.h>
 #include <viua/support/pointer.h>
 #include <viua/exceptions.h>
 #include <viua/cpu/cpu.h>
+#include <viua/cpu/scheduler.h>
 using namespace std;
 
 
@@ -164,6 +166,7 @@ byte* CPU::argc(byte* addr) {
 byte* CPU::call(byte* addr) {
     /*  Run call instruction.
      */
+    byte* instruction = (addr-1);
     bool return_register_ref = *(bool*)addr;
     pointer::inc<bool, byte>(addr);
 
@@ -173,14 +176,142 @@ byte* CPU::call(byte* addr) {
     string call_name = string(addr);
 
     bool is_native = (function_addresses.count(call_name) or linked_functions.count(call_name));
-    bool is_foreign = foreign_functions.count(call_name);
+    bool is_foreign = (foreign_functions.count(call_name) or builtin_functions.count(call_name));
 
     if (not (is_native or is_foreign)) {
         throw new Exception("call to undefined function: " + call_name);
     }
 
     auto caller = (is_native ? &CPU::callNative : &CPU::callForeign);
-    return (this->*caller)(addr, call_name, return_register_ref, return_register_index, "");
+    byte* next = (this->*caller)(addr, call_name, return_register_ref, return_register_index, "");
+    // foreign function that would block is called again by the next tick
+    return (next ? next : instruction);
+}
+
+byte* CPU::tailcall(byte* addr) {
+    /*  Run tailcall instruction.
+     *
+     *  Called function replaces the current one on the call stack: it returns directly to the caller of
+     *  current function, and reuses register set of current frame so recursion in tail position runs in
+     *  constant stack space.
+     */
+    string call_name = string(addr);
+
+    if (not (function_addresses.count(call_name) or linked_functions.count(call_name))) {
+        if (foreign_functions.count(call_name)) {
+            throw new Exception("tail call to foreign function: " + call_name);
+        }
+        throw new Exception("tail call to undefined function: " + call_name);
+    }
+    if (frame_new == nullptr) {
+        throw new Exception("tail call without a frame: use `frame 0' in source code if the function takes no parameters");
+    }
+    if (frames.size() == 0) {
+        throw new Exception("no frame on stack: nothing to replace with tail call");
+    }
+    if (tryframes.size() and tryframes.back()->associated_frame == frames.back()) {
+        throw new Exception("tail call from inside of a try block");
+    }
+
+    // parameters point to objects in registers of current frame which is about to be dropped
+    // so new frame receives their copies
+    for (unsigned i = 0; i < frame_new->args->size(); ++i) {
+        Type* parameter = frame_new->args->at(i);
+        if (parameter == nullptr) {
+            continue;
+        }
+        frame_new->args->empty(i);
+        frame_new->args->set(i, parameter->copy());
+    }
+    frame_new->owns_arguments = true;
+
+    Frame* current = frames.back();
+    byte* return_address = current->return_address;
+    bool return_ref = current->resolve_return_value_register;
+    int return_index = current->place_return_value_in;
+
+    // register set of current frame is cleared and handed over to the new frame
+    RegisterSet* registers = current->regset;
+    for (unsigned i = 0; i < registers->size(); ++i) {
+        if (registers->at(i) == nullptr) {
+            continue;
+        }
+        if (registers->isflagged(i, (KEEP | REFERENCE | BOUND))) {
+            registers->empty(i);
+        } else {
+            registers->free(i);
+        }
+    }
+    current->regset = frame_new->regset;
+    frame_new->regset = registers;
+
+    dropFrame();
+
+    byte* call_address = callNative(addr, call_name, return_ref, return_index, "");
+    frames.back()->return_address = return_address;
+    return call_address;
+}
+
+byte* CPU::spawn(byte* addr) {
+    /*  Run spawn instruction.
+     *
+     *  Function is started in a new process which has its own call stack and register sets, and
+     *  runs alongside the spawning one.
+     *  Processes share only loaded code, typesystem and foreign libraries; parameters are copied so
+     *  no object is reachable from more than one process.
+     */
+    string call_name = string(addr);
+
+    if (not (function_addresses.count(call_name) or linked_functions.count(call_name))) {
+        if (foreign_functions.count(call_name)) {
+            throw new Exception("spawn of foreign function: " + call_name);
+        }
+        throw new Exception("spawn of undefined function: " + call_name);
+    }
+    if (frame_new == nullptr) {
+        throw new Exception("spawn without a frame: use `frame 0' in source code if the function takes no parameters");
+    }
+    if (kernel->scheduler == nullptr) {
+        throw new Exception("spawn outside of a running program");
+    }
+
+    for (unsigned i = 0; i < frame_new->args->size(); ++i) {
+        // copies of a coroutine share its frames so it must not be resumed by more than one process
+        Reference* rf = dynamic_cast<Reference*>(frame_new->args->at(i));
+        if (dynamic_cast<Coroutine*>(rf ? rf->pointsTo() : frame_new->args->at(i)) != nullptr) {
+            throw new Exception("coroutine passed to spawned process");
+        }
+    }
+    for (unsigned i = 0; i < frame_new->args->size(); ++i) {
+        Type* parameter = frame_new->args->at(i);
+        if (parameter == nullptr) {
+            continue;
+        }
+        // references share their reference counts so the object they point to is copied instead
+        Reference* rf = dynamic_cast<Reference*>(parameter);
+        if (rf != nullptr) {
+            parameter = rf->pointsTo();
+        }
+        frame_new->args->empty(i);
+        frame_new->args->set(i, parameter->copy());
+    }
+    frame_new->owns_arguments = true;
+
+    CPU* process = new CPU(kernel);
+    process->verified = verified;
+    process->debug = debug;
+    process->errors = errors;
+    process->regset = new RegisterSet(DEFAULT_REGISTER_SIZE);
+    process->frame_new = frame_new;
+    frame_new = nullptr;
+
+    process->instruction_pointer = process->callNative(addr, call_name, false, 0, "");
+    // process finishes when its function returns
+    process->frames.back()->return_address = nullptr;
+
+    kernel->scheduler->spawn(process);
+
+    return (addr+call_name.size()+1);
 }
 
 byte* CPU::end(byte* addr) {
@@ -191,16 +322,21 @@ byte* CPU::end(byte* addr) {
     }
     addr = frames.back()->ret_address();
 
+    // function started as the coroutine returns to the function that resumed it
+    bool ends_coroutine = (coroutines.size() and frames.size() == (coroutines.back()->frames_base+1));
+
     Type* returned = nullptr;
     bool returned_is_reference = false;
     int return_value_register = frames.back()->place_return_value_in;
     bool resolve_return_value_register = frames.back()->resolve_return_value_register;
     if (return_value_register != 0) {
         // we check in 0. register because it's reserved for return values
+        // (coroutines may return without a value)
         if (uregset->at(0) == nullptr) {
-            throw new Exception("return value requested by frame but function did not set return register");
-        }
-        if (uregset->isflagged(0, REFERENCE)) {
+            if (not ends_coroutine) {
+                throw new Exception("return value requested by frame but function did not set return register");
+            }
+        } else if (uregset->isflagged(0, REFERENCE)) {
             returned = uregset->get(0);
             returned_is_reference = true;
         } else {
@@ -210,6 +346,15 @@ byte* CPU::end(byte* addr) {
 
     dropFrame();
 
+    shared_ptr<Coroutine::State> finished_coroutine;
+    if (ends_coroutine) {
+        finished_coroutine = coroutines.back();
+        coroutines.pop_back();
+        finished_coroutine->running = false;
+        finished_coroutine->finished = true;
+        uregset = finished_coroutine->caller_registers;
+    }
+
     // place return value
     if (returned and frames.size() > 0) {
         if (resolve_return_value_register) {
@@ -222,11 +367,11 @@ byte* CPU::end(byte* addr) {
     }
 
     if (frames.size() > 0) {
-        if (function_addresses.count(frames.back()->function_name)) {
-            jump_base = bytecode;
-        } else {
-            jump_base = linked_modules.at(linked_functions.at(frames.back()->function_name).first).second;
-        }
+        auto linked = linked_functions.find(frames.back()->function_name);
+        jump_base = ((linked == linked_functions.end()) ? bytecode : linked_modules.at(linked->second.first).second);
+    }
+    if (finished_coroutine) {
+        jump_base = finished_coroutine->caller_jump_base;
     }
 
     return addr;
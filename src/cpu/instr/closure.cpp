@@ -157,12 +157,14 @@ byte* CPU::fcall(byte* addr) {
     }
 
     byte* call_address = nullptr;
-    if (function_addresses.count(call_name)) {
-        call_address = bytecode+function_addresses.at(call_name);
+    auto local = function_addresses.find(call_name);
+    if (local != function_addresses.end()) {
+        call_address = bytecode+local->second;
         jump_base = bytecode;
     } else {
-        call_address = linked_functions.at(call_name).second;
-        jump_base = linked_modules.at(linked_functions.at(call_name).first).second;
+        const pair<string, byte*>& linked = linked_functions.at(call_name);
+        call_address = linked.second;
+        jump_base = linked_modules.at(linked.first).second;
     }
 
     // save return address for frame
@@ -0,0 +1,197 @@
+#include <viua/types/integer.h>
+#include <viua/types/coroutine.h>
+#include <viua/types/exception.h>
+#include <viua/support/pointer.h>
+#include <viua/cpu/cpu.h>
+using namespace std;
+
+
+byte* CPU::coroutine(byte* addr) {
+    /*  Run coroutine instruction.
+     *
+     *  Function is started as a coroutine with parameters from the prepared frame, but
+     *  does not run until the coroutine is resumed.
+     */
+    int reg;
+    bool reg_ref;
+
+    reg_ref = *((bool*)addr);
+    pointer::inc<bool, byte>(addr);
+    reg = *((int*)addr);
+    pointer::inc<int, byte>(addr);
+
+    string call_name = string(addr);
+    addr += (call_name.size()+1);
+
+    if (reg_ref) {
+        reg = static_cast<Integer*>(fetch(reg))->value();
+    }
+
+    if (not (function_addresses.count(call_name) or linked_functions.count(call_name))) {
+        if (foreign_functions.count(call_name) or builtin_functions.count(call_name)) {
+            throw new Exception("coroutine from foreign function: " + call_name);
+        }
+        throw new Exception("coroutine from undefined function: " + call_name);
+    }
+    if (frame_new == nullptr) {
+        throw new Exception("coroutine without a frame: use `frame 0' in source code if the function takes no parameters");
+    }
+
+    // coroutine may run after objects its parameters point to are gone so
+    // its frame receives their copies
+    for (unsigned i = 0; i < frame_new->args->size(); ++i) {
+        Type* parameter = frame_new->args->at(i);
+        if (parameter == nullptr) {
+            continue;
+        }
+        frame_new->args->empty(i);
+        frame_new->args->set(i, parameter->copy());
+    }
+    frame_new->owns_arguments = true;
+
+    // frame is resized to the number of registers the function requires (as it would be by pushFrame())
+    auto required = function_registers.find(call_name);
+    if (required != function_registers.end() and required->second != frame_new->regset->size()) {
+        delete frame_new->regset;
+        frame_new->regset = new RegisterSet(required->second);
+    }
+    frame_new->function_name = call_name;
+
+    Coroutine* crt = new Coroutine();
+    Coroutine::State& state = *(crt->state);
+    state.function_name = call_name;
+    state.frames.push_back(frame_new);
+    state.registers = frame_new->regset;
+    frame_new = nullptr;
+
+    auto local = function_addresses.find(call_name);
+    if (local != function_addresses.end()) {
+        state.resume_address = bytecode+local->second;
+        state.jump_base = bytecode;
+    } else {
+        const pair<string, byte*>& linked = linked_functions.at(call_name);
+        state.resume_address = linked.second;
+        state.jump_base = linked_modules.at(linked.first).second;
+    }
+
+    place(unsigned(reg), crt);
+
+    return addr;
+}
+
+byte* CPU::resume(byte* addr) {
+    /*  Run resume instruction.
+     *
+     *  Frames of the coroutine are put back on the call stack, and
+     *  the coroutine runs until it yields a value or returns.
+     *  The value is put in the return register (returning without a value leaves the register untouched).
+     */
+    int return_value_reg, coroutine_reg;
+    bool return_value_ref, coroutine_ref;
+
+    return_value_ref = *((bool*)addr);
+    pointer::inc<bool, byte>(addr);
+    return_value_reg = *((int*)addr);
+    pointer::inc<int, byte>(addr);
+
+    coroutine_ref = *((bool*)addr);
+    pointer::inc<bool, byte>(addr);
+    coroutine_reg = *((int*)addr);
+    pointer::inc<int, byte>(addr);
+
+    if (return_value_ref) {
+        return_value_reg = static_cast<Integer*>(fetch(return_value_reg))->value();
+    }
+    if (coroutine_ref) {
+        coroutine_reg = static_cast<Integer*>(fetch(coroutine_reg))->value();
+    }
+
+    Coroutine* crt = dynamic_cast<Coroutine*>(fetch(coroutine_reg));
+    if (crt == nullptr) {
+        throw new Exception("resume of an object which is not a coroutine: " + fetch(coroutine_reg)->type());
+    }
+    shared_ptr<Coroutine::State> state = crt->state;
+    if (state->finished) {
+        throw new Exception("resume of finished coroutine: " + state->function_name);
+    }
+    if (state->running) {
+        throw new Exception("resume of running coroutine: " + state->function_name);
+    }
+
+    state->frames_base = unsigned(frames.size());
+    state->tryframes_base = unsigned(tryframes.size());
+    state->caller_registers = uregset;
+    state->caller_jump_base = jump_base;
+    state->return_address = addr;
+    state->return_register = unsigned(return_value_reg);
+
+    // when the coroutine returns, its return value is placed as if it was called here
+    Frame* bottom = state->frames.front();
+    bottom->return_address = addr;
+    bottom->place_return_value_in = return_value_reg;
+    bottom->resolve_return_value_register = false;
+
+    frames.insert(frames.end(), state->frames.begin(), state->frames.end());
+    tryframes.insert(tryframes.end(), state->tryframes.begin(), state->tryframes.end());
+    state->frames.clear();
+    state->tryframes.clear();
+
+    uregset = state->registers;
+    jump_base = state->jump_base;
+    state->running = true;
+    coroutines.push_back(state);
+
+    return state->resume_address;
+}
+
+byte* CPU::yield(byte* addr) {
+    /*  Run yield instruction.
+     *
+     *  Frames of current coroutine (including frames of functions it called) are taken off the call stack and
+     *  kept in the coroutine, and a copy of the yielded object is given to the function that resumed it.
+     */
+    int reg;
+    bool reg_ref;
+
+    reg_ref = *((bool*)addr);
+    pointer::inc<bool, byte>(addr);
+    reg = *((int*)addr);
+    pointer::inc<int, byte>(addr);
+
+    if (reg_ref) {
+        reg = static_cast<Integer*>(fetch(reg))->value();
+    }
+
+    if (coroutines.size() == 0) {
+        throw new Exception("yield outside of a coroutine");
+    }
+    if (frame_new != nullptr) {
+        throw new Exception("yield with unused frame");
+    }
+
+    Type* yielded = fetch(reg)->copy();
+
+    shared_ptr<Coroutine::State> state = coroutines.back();
+    coroutines.pop_back();
+
+    state->frames.assign(frames.begin()+state->frames_base, frames.end());
+    frames.resize(state->frames_base);
+    state->tryframes.assign(tryframes.begin()+state->tryframes_base, tryframes.end());
+    tryframes.resize(state->tryframes_base);
+
+    state->registers = uregset;
+    state->jump_base = jump_base;
+    state->resume_address = addr;
+    state->running = false;
+
+    uregset = state->caller_registers;
+    jump_base = state->caller_jump_base;
+
+    if (state->return_register != 0) {
+        place(state->return_register, yielded);
+    } else {
+        delete yielded;
+    }
+
+    return state->return_address;
+}
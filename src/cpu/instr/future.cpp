@@ -0,0 +1,56 @@
+#include <viua/types/integer.h>
+#include <viua/types/future.h>
+#include <viua/types/exception.h>
+#include <viua/support/pointer.h>
+#include <viua/cpu/cpu.h>
+using namespace std;
+
+
+byte* CPU::wait(byte* addr) {
+    /*  Run wait instruction.
+     *
+     *  If the call the future stands for has not returned yet, the instruction is run again when
+     *  the process is scheduled next time (other processes run in the meantime).
+     *  Once the future is resolved, a copy of the returned value is put in the target register, or
+     *  a copy of the object thrown by the call is thrown.
+     */
+    byte* wait_address = (addr-1);
+    int target_reg, future_reg;
+    bool target_ref, future_ref;
+
+    target_ref = *((bool*)addr);
+    pointer::inc<bool, byte>(addr);
+    target_reg = *((int*)addr);
+    pointer::inc<int, byte>(addr);
+
+    future_ref = *((bool*)addr);
+    pointer::inc<bool, byte>(addr);
+    future_reg = *((int*)addr);
+    pointer::inc<int, byte>(addr);
+
+    if (target_ref) {
+        target_reg = static_cast<Integer*>(fetch(target_reg))->value();
+    }
+    if (future_ref) {
+        future_reg = static_cast<Integer*>(fetch(future_reg))->value();
+    }
+
+    Future* future = dynamic_cast<Future*>(fetch(future_reg));
+    if (future == nullptr) {
+        throw new Exception("wait for an object which is not a future: " + fetch(future_reg)->type());
+    }
+    shared_ptr<Future::State> state = future->state;
+    if (not state->resolved.load()) {
+        waiting = true;
+        waiting_for = WouldBlock();
+        return wait_address;
+    }
+
+    if (state->thrown != nullptr) {
+        thrown = state->thrown->copy();
+    } else if (target_reg != 0 and state->value != nullptr) {
+        place(unsigned(target_reg), state->value->copy());
+    }
+
+    return addr;
+}
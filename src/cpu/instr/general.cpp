@@ -6,8 +6,11 @@
 using namespace std;
 
 
-byte* CPU::echo(byte* addr) {
-    /*  Run echo instruction.
+byte* CPU::echo(byte* addr, const string& line_end) {
+    /*  Write register to standard output followed by given line end.
+     *
+     *  Text is written with a single operation so that output of processes
+     *  running on different threads is not interleaved within a line.
      */
     bool ref = false;
     int operand_index;
@@ -22,17 +25,21 @@ byte* CPU::echo(byte* addr) {
         operand_index = static_cast<Integer*>(fetch(operand_index))->value();
     }
 
-    cout << fetch(operand_index)->str();
+    cout << (fetch(operand_index)->str() + line_end);
 
     return addr;
 }
 
+byte* CPU::echo(byte* addr) {
+    /*  Run echo instruction.
+     */
+    return echo(addr, "");
+}
+
 byte* CPU::print(byte* addr) {
     /*  Run print instruction.
      */
-    addr = echo(addr);
-    cout << '\n';
-    return addr;
+    return echo(addr, "\n");
 }
 
 
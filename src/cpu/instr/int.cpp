@@ -408,6 +408,108 @@ byte* CPU::ieq(byte* addr) {
     return addr;
 }
 
+byte* CPU::typedIntegerOperands(byte* addr, int& destination_register, int& first, int& second) {
+    /*  Decode operands of typed integer instructions.
+     *
+     *  Assembler emits typed instructions only when it proved that both operands hold Integers so
+     *  values are read directly, without casts.
+     */
+    int* operands[] = { &destination_register, &first, &second };
+    for (int* operand : operands) {
+        bool ref = *((bool*)addr);
+        pointer::inc<bool, byte>(addr);
+        *operand = *((int*)addr);
+        pointer::inc<int, byte>(addr);
+        if (ref) {
+            *operand = static_cast<Integer*>(fetch(*operand))->value();
+        }
+    }
+    first = static_cast<Integer*>(fetch(first))->value();
+    second = static_cast<Integer*>(fetch(second))->value();
+    return addr;
+}
+
+byte* CPU::tiadd(byte* addr) {
+    /*  Run tiadd instruction.
+     */
+    int destination_register, first, second;
+    addr = typedIntegerOperands(addr, destination_register, first, second);
+    place(destination_register, new Integer(first + second));
+    return addr;
+}
+
+byte* CPU::tisub(byte* addr) {
+    /*  Run tisub instruction.
+     */
+    int destination_register, first, second;
+    addr = typedIntegerOperands(addr, destination_register, first, second);
+    place(destination_register, new Integer(first - second));
+    return addr;
+}
+
+byte* CPU::timul(byte* addr) {
+    /*  Run timul instruction.
+     */
+    int destination_register, first, second;
+    addr = typedIntegerOperands(addr, destination_register, first, second);
+    place(destination_register, new Integer(first * second));
+    return addr;
+}
+
+byte* CPU::tidiv(byte* addr) {
+    /*  Run tidiv instruction.
+     */
+    int destination_register, first, second;
+    addr = typedIntegerOperands(addr, destination_register, first, second);
+    place(destination_register, new Integer(first / second));
+    return addr;
+}
+
+byte* CPU::tilt(byte* addr) {
+    /*  Run tilt instruction.
+     */
+    int destination_register, first, second;
+    addr = typedIntegerOperands(addr, destination_register, first, second);
+    place(destination_register, new Boolean(first < second));
+    return addr;
+}
+
+byte* CPU::tilte(byte* addr) {
+    /*  Run tilte instruction.
+     */
+    int destination_register, first, second;
+    addr = typedIntegerOperands(addr, destination_register, first, second);
+    place(destination_register, new Boolean(first <= second));
+    return addr;
+}
+
+byte* CPU::tigt(byte* addr) {
+    /*  Run tigt instruction.
+     */
+    int destination_register, first, second;
+    addr = typedIntegerOperands(addr, destination_register, first, second);
+    place(destination_register, new Boolean(first > second));
+    return addr;
+}
+
+byte* CPU::tigte(byte* addr) {
+    /*  Run tigte instruction.
+     */
+    int destination_register, first, second;
+    addr = typedIntegerOperands(addr, destination_register, first, second);
+    place(destination_register, new Boolean(first >= second));
+    return addr;
+}
+
+byte* CPU::tieq(byte* addr) {
+    /*  Run tieq instruction.
+     */
+    int destination_register, first, second;
+    addr = typedIntegerOperands(addr, destination_register, first, second);
+    place(destination_register, new Boolean(first == second));
+    return addr;
+}
+
 byte* CPU::iinc(byte* addr) {
     /*  Run iinc instruction.
      */
@@ -14,6 +14,7 @@ byte* CPU::import(byte* addr) {
      */
     string module = string(addr);
     addr += module.size();
+    ensureSingleProcess("import module");
     loadForeignLibrary(module);
     return addr;
 }
@@ -23,6 +24,7 @@ byte* CPU::link(byte* addr) {
      */
     string module = string(addr);
     addr += module.size();
+    ensureSingleProcess("link module");
     loadNativeLibrary(module);
     return addr;
 }
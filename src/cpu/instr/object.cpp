@@ -43,6 +43,7 @@ byte* CPU::vmmsg(byte* addr) {
      *  To call a method using static dispatch (where a correct function is resolved during compilation) use
      *  "call" instruction.
      */
+    byte* instruction = (addr-1);
     int return_register_index;
     bool return_register_ref = false;
 
@@ -85,7 +86,7 @@ byte* CPU::vmmsg(byte* addr) {
     }
 
     auto caller = (is_native ? &CPU::callNative : &CPU::callForeign);
-    return (this->*caller)(addr, function_name, return_register_ref, return_register_index, method_name);
-
-    return addr;
+    byte* next = (this->*caller)(addr, function_name, return_register_ref, return_register_index, method_name);
+    // foreign function that would block is called again by the next tick
+    return (next ? next : instruction);
 }
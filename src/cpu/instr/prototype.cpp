@@ -106,6 +106,7 @@ byte* CPU::vmregister(byte* addr) {
         reg = static_cast<Integer*>(fetch(reg))->value();
     }
 
+    ensureSingleProcess("register prototype");
     Prototype* new_proto = static_cast<Prototype*>(fetch(reg));
     typesystem[new_proto->getTypeName()] = new_proto;
     uregset->empty(reg);
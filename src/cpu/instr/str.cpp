@@ -22,14 +22,18 @@ byte* CPU::strstore(byte* addr) {
     reg = *((int*)addr);
     pointer::inc<int, byte>(addr);
 
-    string svalue = string(addr);
-    addr += svalue.size()+1;
+    auto literal = string_literals.find(addr);
+    if (literal == string_literals.end()) {
+        string svalue = string(addr);
+        literal = string_literals.emplace(addr, pair<string, unsigned>(str::strdecode(svalue), unsigned(svalue.size()+1))).first;
+    }
+    addr += literal->second.second;
 
     if (reg_ref) {
         reg = static_cast<Integer*>(fetch(reg))->value();
     }
 
-    place(reg, new String(str::strdecode(svalue)));
+    place(reg, new String(literal->second.first));
 
     return addr;
 }
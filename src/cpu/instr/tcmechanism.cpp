@@ -30,12 +30,14 @@ byte* CPU::vmcatch(byte* addr) {
     }
 
     byte* block_address = nullptr;
-    if (block_addresses.count(catcher_block_name)) {
-        block_address = bytecode+block_addresses.at(catcher_block_name);
+    auto local = block_addresses.find(catcher_block_name);
+    if (local != block_addresses.end()) {
+        block_address = bytecode+local->second;
         jump_base = bytecode;
     } else {
-        block_address = linked_blocks.at(catcher_block_name).second;
-        jump_base = linked_modules.at(linked_blocks.at(catcher_block_name).first).second;
+        const pair<string, byte*>& linked = linked_blocks.at(catcher_block_name);
+        block_address = linked.second;
+        jump_base = linked_modules.at(linked.first).second;
     }
 
     try_frame_new->catchers[type_name] = new Catcher(type_name, catcher_block_name, block_address);
@@ -78,12 +80,14 @@ byte* CPU::vmenter(byte* addr) {
     }
 
     byte* block_address = nullptr;
-    if (block_addresses.count(block_name)) {
-        block_address = bytecode+block_addresses.at(block_name);
+    auto local = block_addresses.find(block_name);
+    if (local != block_addresses.end()) {
+        block_address = bytecode+local->second;
         jump_base = bytecode;
     } else {
-        block_address = linked_blocks.at(block_name).second;
-        jump_base = linked_modules.at(linked_blocks.at(block_name).first).second;
+        const pair<string, byte*>& linked = linked_blocks.at(block_name);
+        block_address = linked.second;
+        jump_base = linked_modules.at(linked.first).second;
     }
 
     try_frame_new->return_address = (addr+block_name.size());
@@ -0,0 +1,49 @@
+#include <viua/cpu/pool.h>
+using namespace std;
+
+
+BlockingCallPool::~BlockingCallPool() {
+    {
+        lock_guard<mutex> lck(lock);
+        stopping = true;
+    }
+    submitted.notify_all();
+    for (thread& each : threads) {
+        each.join();
+    }
+}
+
+void BlockingCallPool::submit(function<void()> call) {
+    /** Run a call on one of the threads of the pool.
+     *
+     *  New thread is started if all running threads are busy and the limit was not reached yet.
+     */
+    {
+        lock_guard<mutex> lck(lock);
+        calls.push_back(call);
+        if (idle < calls.size() and threads.size() < limit) {
+            threads.emplace_back(&BlockingCallPool::work, this);
+        }
+    }
+    submitted.notify_one();
+}
+
+void BlockingCallPool::work() {
+    /** Run submitted calls until the pool is destroyed.
+     */
+    unique_lock<mutex> lck(lock);
+    while (true) {
+        ++idle;
+        submitted.wait(lck, [this]() { return (stopping or calls.size()); });
+        --idle;
+        if (calls.size() == 0) {
+            return;
+        }
+
+        function<void()> call = calls.front();
+        calls.pop_front();
+        lck.unlock();
+        call();
+        lck.lock();
+    }
+}
@@ -0,0 +1,113 @@
+#include <sys/epoll.h>
+#include <unistd.h>
+#include <viua/include/module.h>
+#include <viua/cpu/reactor.h>
+using namespace std;
+
+
+// maximum number of events taken from epoll at once
+static const int REACTOR_MAX_EVENTS = 64;
+
+
+static uint32_t epollEvents(unsigned events) {
+    return ((events & WouldBlock::READABLE) ? uint32_t(EPOLLIN) : 0) | ((events & WouldBlock::WRITABLE) ? uint32_t(EPOLLOUT) : 0);
+}
+
+
+Reactor::Reactor(): epoll_fd(epoll_create1(EPOLL_CLOEXEC)), parked(0) {
+}
+
+Reactor::~Reactor() {
+    if (epoll_fd >= 0) {
+        close(epoll_fd);
+    }
+}
+
+bool Reactor::park(CPU* process, int fd, unsigned events) {
+    /** Suspend process until file descriptor is ready for given events.
+     *
+     *  Returns false if the descriptor cannot be waited for (e.g. it is a regular file, which is always ready)
+     *  in which case the process should simply be run again.
+     */
+    if (epoll_fd < 0) {
+        return false;
+    }
+
+    lock_guard<mutex> lck(lock);
+    vector<pair<CPU*, unsigned>>& fd_waiters = waiters[fd];
+
+    unsigned wanted = events;
+    for (const auto& each : fd_waiters) {
+        wanted |= each.second;
+    }
+
+    epoll_event event;
+    event.events = epollEvents(wanted);
+    event.data.fd = fd;
+    if (epoll_ctl(epoll_fd, (fd_waiters.size() ? EPOLL_CTL_MOD : EPOLL_CTL_ADD), fd, &event) != 0) {
+        if (fd_waiters.size() == 0) {
+            waiters.erase(fd);
+        }
+        return false;
+    }
+
+    fd_waiters.emplace_back(process, events);
+    ++parked;
+    return true;
+}
+
+vector<CPU*> Reactor::poll(int timeout) {
+    /** Wait (at most given number of milliseconds) for file descriptors to become ready.
+     *
+     *  Returns processes that should be run again.
+     *  All processes waiting for a ready descriptor are woken up; the ones whose calls would still block
+     *  park themselves again.
+     */
+    vector<CPU*> ready;
+    if (epoll_fd < 0) {
+        return ready;
+    }
+
+    epoll_event events[REACTOR_MAX_EVENTS];
+    int n = epoll_wait(epoll_fd, events, REACTOR_MAX_EVENTS, timeout);
+
+    lock_guard<mutex> lck(lock);
+    for (int i = 0; i < n; ++i) {
+        int fd = events[i].data.fd;
+        auto found = waiters.find(fd);
+        if (found == waiters.end()) {
+            continue;
+        }
+        for (const auto& each : found->second) {
+            ready.push_back(each.first);
+        }
+        parked -= unsigned(found->second.size());
+        waiters.erase(found);
+        epoll_ctl(epoll_fd, EPOLL_CTL_DEL, fd, nullptr);
+    }
+    return ready;
+}
+
+unsigned Reactor::waiting() const {
+    /** Return number of parked processes.
+     */
+    return parked.load();
+}
+
+vector<CPU*> Reactor::release() {
+    /** Stop waiting for all file descriptors.
+     *
+     *  Returns processes that were parked.
+     */
+    vector<CPU*> released;
+    lock_guard<mutex> lck(lock);
+    for (const auto& fd_waiters : waiters) {
+        for (const auto& each : fd_waiters.second) {
+            released.push_back(each.first);
+        }
+        epoll_ctl(epoll_fd, EPOLL_CTL_DEL, fd_waiters.first, nullptr);
+    }
+    waiters.clear();
+    parked = 0;
+    return released;
+}
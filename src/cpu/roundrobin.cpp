@@ -0,0 +1,31 @@
+#include <viua/cpu/roundrobin.h>
+using namespace std;
+
+
+RoundRobin& RoundRobin::add(CPU* program) {
+    /** Add a program to run.
+     *
+     *  Program must be loaded, and it must not be running.
+     */
+    programs.push_back(program);
+    return (*this);
+}
+
+CPU* RoundRobin::step() {
+    /** Run next program for one budget of instructions.
+     *
+     *  Returns the program if it finished (it is then removed from the round robin), and
+     *  null pointer otherwise.
+     */
+    if (programs.size() == 0) {
+        return nullptr;
+    }
+
+    CPU* program = programs.front();
+    programs.pop_front();
+    if (program->runFor(budget) == RUN_FINISHED) {
+        return program;
+    }
+    programs.push_back(program);
+    return nullptr;
+}
@@ -0,0 +1,216 @@
+#include <algorithm>
+#include <chrono>
+#include <thread>
+#include <viua/cpu/cpu.h>
+#include <viua/cpu/scheduler.h>
+using namespace std;
+
+
+/*  Scheduler and worker that is running on current thread.
+ *  Used to put spawned processes on the run queue of the worker that spawned them.
+ */
+static thread_local Scheduler* current_scheduler = nullptr;
+static thread_local unsigned current_worker = 0;
+
+
+Scheduler::Scheduler(unsigned workers): main_process(nullptr), alive(0) {
+    for (unsigned i = 0; i < (workers ? workers : 1); ++i) {
+        queues.emplace_back(new RunQueue());
+    }
+}
+
+Scheduler::~Scheduler() {
+    // processes are left behind only when the scheduler is destroyed before they finished
+    // (e.g. an embedder stopped running a program with CPU::runFor())
+    vector<CPU*> unfinished = reactor.release();
+    for (unique_ptr<RunQueue>& queue : queues) {
+        unfinished.insert(unfinished.end(), queue->processes.begin(), queue->processes.end());
+    }
+    for (CPU* process : unfinished) {
+        if (process != main_process) {
+            delete process;
+        }
+    }
+}
+
+void Scheduler::enqueue(unsigned worker, CPU* process) {
+    /** Put process at the back of a worker's run queue.
+     */
+    {
+        lock_guard<mutex> lck(queues[worker]->lock);
+        queues[worker]->processes.push_back(process);
+    }
+    idle.notify_one();
+}
+
+CPU* Scheduler::next(unsigned worker) {
+    /** Get next process to run on a worker.
+     *
+     *  Processes are taken from the front of worker's own queue, and
+     *  stolen from the back of other workers' queues when it is empty.
+     *  Returns null pointer if there is nothing to run.
+     */
+    for (unsigned i = 0; i < queues.size(); ++i) {
+        RunQueue& queue = *queues[(worker+i) % queues.size()];
+        lock_guard<mutex> lck(queue.lock);
+        if (queue.processes.size() == 0) {
+            continue;
+        }
+        CPU* process = nullptr;
+        if (i == 0) {
+            process = queue.processes.front();
+            queue.processes.pop_front();
+        } else {
+            process = queue.processes.back();
+            queue.processes.pop_back();
+        }
+        return process;
+    }
+    return nullptr;
+}
+
+void Scheduler::finish(CPU* process) {
+    /** Dispose of a process that stopped running.
+     */
+    if (process != main_process) {
+        string return_exception, return_message;
+        tie(ignore, return_exception, return_message) = process->exitcondition();
+        if (return_exception.size()) {
+            vector<Frame*> trace = process->trace();
+            lock_guard<mutex> lck(failures_lock);
+            failed.emplace_back((trace.size() ? trace.front()->function_name : ""), return_exception, return_message);
+        }
+        delete process;
+    }
+    if (--alive == 0) {
+        idle.notify_all();
+    }
+}
+
+unsigned Scheduler::slice(unsigned worker, CPU* process, unsigned budget) {
+    /** Run a process for at most given number of instructions.
+     *
+     *  Process is then put back on the run queue, parked in the reactor, or disposed of if it finished.
+     *  Returns number of instructions executed.
+     */
+    // process that waits for a foreign call gives up the rest of its time slice
+    bool running = true;
+    unsigned executed = 0;
+    while (running and executed < budget) {
+        running = (process->tick() != nullptr);
+        ++executed;
+        if (process->waits()) {
+            break;
+        }
+    }
+
+    if (running and process->waits() and process->waitsFor().fd >= 0 and reactor.park(process, process->waitsFor().fd, process->waitsFor().events)) {
+        // process is given back by the reactor when its file descriptor is ready
+    } else if (running) {
+        enqueue(worker, process);
+    } else {
+        finish(process);
+    }
+    return executed;
+}
+
+void Scheduler::work(unsigned worker) {
+    /** Run processes until all of them have finished.
+     */
+    current_scheduler = this;
+    current_worker = worker;
+
+    while (alive.load()) {
+        CPU* process = next(worker);
+        if (reactor.waiting() and poll_lock.try_lock()) {
+            // busy worker only checks for processes whose I/O is ready, idle one waits for them
+            vector<CPU*> ready = reactor.poll(process ? 0 : 1);
+            poll_lock.unlock();
+            for (CPU* each : ready) {
+                enqueue(worker, each);
+            }
+            if (process == nullptr) {
+                continue;
+            }
+        }
+        if (process == nullptr) {
+            unique_lock<mutex> lck(idle_lock);
+            idle.wait_for(lck, chrono::milliseconds(1));
+            continue;
+        }
+
+        slice(worker, process, PROCESS_TIME_SLICE);
+    }
+
+    current_scheduler = nullptr;
+}
+
+Scheduler& Scheduler::spawn(CPU* process) {
+    /** Add a process to run.
+     */
+    ++alive;
+    enqueue(((current_scheduler == this) ? current_worker : 0), process);
+    return (*this);
+}
+
+unsigned Scheduler::processes() const {
+    /** Return number of processes that have not finished yet.
+     */
+    return alive.load();
+}
+
+Scheduler& Scheduler::start(CPU* process) {
+    /** Add the process that starts the program, without running it.
+     */
+    main_process = process;
+    return spawn(process);
+}
+
+unsigned Scheduler::runFor(unsigned budget) {
+    /** Run processes on calling thread for at most given number of instructions.
+     *
+     *  Processes take turns in time slices as they do when run by workers.
+     *  Returns number of instructions executed; it is less than the budget only if all processes have finished, or
+     *  all processes that have not finished are waiting for I/O.
+     */
+    Scheduler* calling_scheduler = current_scheduler;
+    unsigned calling_worker = current_worker;
+    current_scheduler = this;
+    current_worker = 0;
+
+    unsigned executed = 0;
+    while (alive.load() and executed < budget) {
+        if (reactor.waiting()) {
+            for (CPU* each : reactor.poll(0)) {
+                enqueue(0, each);
+            }
+        }
+        CPU* process = next(0);
+        if (process == nullptr) {
+            break;
+        }
+        executed += slice(0, process, min(PROCESS_TIME_SLICE, (budget - executed)));
+    }
+
+    current_scheduler = calling_scheduler;
+    current_worker = calling_worker;
+    return executed;
+}
+
+void Scheduler::run(CPU* process) {
+    /** Run a process, and every process it spawns.
+     *
+     *  Calling thread is used as the first worker.
+     *  Returns after all processes have finished.
+     */
+    start(process);
+
+    vector<thread> workers;
+    for (unsigned i = 1; i < queues.size(); ++i) {
+        workers.emplace_back(&Scheduler::work, this, i);
+    }
+    work(0);
+    for (thread& each : workers) {
+        each.join();
+    }
+}
@@ -0,0 +1,324 @@
+#include <cstring>
+#include <algorithm>
+#include <sstream>
+#include <tuple>
+#include <vector>
+#include <viua/bytecode/opcodes.h>
+#include <viua/bytecode/maps.h>
+#include <viua/cpu/verifier.h>
+using namespace std;
+
+
+string verifier::operandkinds(OPCODE op) {
+    /** Return kinds of operands of given opcode.
+     *
+     *  Each character describes one operand:
+     *
+     *      r   - register index (may be dereferenced with @)
+     *      i   - immediate integer (may be taken from a register with @)
+     *      f   - immediate float
+     *      b   - immediate byte (may be taken from a register with @)
+     *      j   - raw integer (jump target or register set ID)
+     *      s   - null-terminated string
+     */
+    switch (op) {
+        case NOP:
+        case TRY:
+        case LEAVE:
+        case END:
+        case HALT:
+            return "";
+        case IZERO:
+        case IINC:
+        case IDEC:
+        case BINC:
+        case BDEC:
+        case PRINT:
+        case ECHO:
+        case BOOL:
+        case NOT:
+        case FREE:
+        case EMPTY:
+        case TMPRI:
+        case TMPRO:
+        case VEC:
+        case CLBIND:
+        case ARGC:
+        case THROW:
+        case YIELD:
+        case PULL:
+        case REGISTER:
+            return "r";
+        case ISTORE:
+        case ARG:
+            return "ri";
+        case FSTORE:
+            return "rf";
+        case BSTORE:
+            return "rb";
+        case ITOF:
+        case FTOI:
+        case STOI:
+        case STOF:
+        case VPUSH:
+        case VLEN:
+        case MOVE:
+        case COPY:
+        case REF:
+        case SWAP:
+        case ISNULL:
+        case FCALL:
+        case RESUME:
+        case WAIT:
+            return "rr";
+        case FRAME:
+            return "ii";
+        case PARAM:
+        case PAREF:
+            return "ir";
+        case VINSERT:
+        case VPOP:
+        case VAT:
+            return "rri";
+        case RESS:
+        case JUMP:
+            return "j";
+        case BRANCH:
+            return "rjj";
+        case STRSTORE:
+        case CALL:
+        case CLOSURE:
+        case FUNCTION:
+        case CLASS:
+        case PROTOTYPE:
+        case DERIVE:
+        case NEW:
+        case MSG:
+        case COROUTINE:
+            return "rs";
+        case IMPORT:
+        case LINK:
+        case ENTER:
+        case TAILCALL:
+        case SPAWN:
+            return "s";
+        case CATCH:
+            return "ss";
+        case ATTACH:
+            return "rss";
+        default:
+            return "rrr";
+    }
+}
+
+static bool isterminating(OPCODE op) {
+    return (op == END or op == HALT or op == JUMP or op == BRANCH or op == LEAVE or op == THROW or op == TAILCALL);
+}
+
+
+string verifier::verify(byte* bytecode, unsigned bytecode_size, const unordered_map<string, unsigned>& functions, const unordered_map<string, unsigned>& blocks) {
+    /** Verify bytecode of a module.
+     *
+     *  Proves that:
+     *
+     *      - every function and block consists of valid, complete instructions and
+     *        ends with an instruction that does not fall through to the next one,
+     *      - jump and branch targets land on instruction boundaries (absolute jumps may
+     *        cross function boundaries), and do not point to the jumping instruction itself,
+     *      - frames are balanced, i.e. every frame is consumed by a call before next frame is created,
+     *      - registers accessed by a function fit in the frame declared by literal local registers count
+     *        at every call site of that function.
+     *
+     *  Returns empty string if bytecode is correct, and
+     *  description of the first problem found otherwise.
+     */
+    vector<tuple<unsigned, string, bool> > entries;
+    for (auto p : functions) { entries.push_back(tuple<unsigned, string, bool>(p.second, p.first, true)); }
+    for (auto p : blocks) { entries.push_back(tuple<unsigned, string, bool>(p.second, p.first, false)); }
+    sort(entries.begin(), entries.end());
+
+    ostringstream report;
+
+    vector<bool> boundaries(bytecode_size, false);
+    vector<tuple<unsigned, unsigned> > jumps;                       // (instruction, target)
+
+    // max register used by a function, and
+    // whether the max could be established (i.e. no register was dereferenced and no ress to a non-local set)
+    map<string, tuple<int, bool> > registers_used;
+    vector<tuple<unsigned, string, int> > calls;                    // (instruction, function, local registers)
+
+    for (unsigned e = 0; e < entries.size(); ++e) {
+        unsigned begin = get<0>(entries[e]);
+        const string& name = get<1>(entries[e]);
+        bool is_function = get<2>(entries[e]);
+
+        unsigned end = bytecode_size;
+        for (unsigned n = e+1; n < entries.size(); ++n) {
+            if (get<0>(entries[n]) > begin) {
+                end = get<0>(entries[n]);
+                break;
+            }
+        }
+
+        if (begin >= end) {
+            report << (is_function ? "function" : "block") << " '" << name << "' is empty or begins outside of bytecode";
+            return report.str();
+        }
+
+        int max_register = -1;
+        bool registers_known = true;
+        bool frame_pending = false;
+        int frame_locals = -1;
+
+        OPCODE op = NOP;
+        unsigned addr = begin;
+        while (addr < end) {
+            unsigned instruction = addr;
+            boundaries[instruction] = true;
+            op = OPCODE(bytecode[addr++]);
+
+            if (OP_NAMES.count(op) == 0) {
+                report << "invalid opcode " << unsigned(op) << " at byte " << instruction << " in '" << name << "'";
+                return report.str();
+            }
+
+            string kinds = operandkinds(op);
+            vector<int> operands;
+            vector<bool> refs;
+            string callee;
+            bool truncated = false;
+            for (unsigned k = 0; k < kinds.size() and not truncated; ++k) {
+                char kind = kinds[k];
+                if (kind == 's') {
+                    byte* nul = static_cast<byte*>(memchr(bytecode+addr, 0, end-addr));
+                    if (nul == nullptr) {
+                        truncated = true;
+                        break;
+                    }
+                    if (callee.size() == 0) { callee = string(bytecode+addr); }
+                    addr = unsigned(nul-bytecode) + 1;
+                    continue;
+                }
+
+                unsigned width = 0;
+                if (kind == 'r' or kind == 'i') {
+                    width = sizeof(bool) + sizeof(int);
+                } else if (kind == 'b') {
+                    width = sizeof(bool) + sizeof(byte);
+                } else if (kind == 'f') {
+                    width = sizeof(float);
+                } else {
+                    width = sizeof(int);
+                }
+                if (end-addr < width) {
+                    truncated = true;
+                    break;
+                }
+
+                if (kind == 'r' or kind == 'i' or kind == 'b') {
+                    bool ref = *reinterpret_cast<bool*>(bytecode+addr);
+                    int value = ((kind == 'b') ? int(bytecode[addr+sizeof(bool)]) : *reinterpret_cast<int*>(bytecode+addr+sizeof(bool)));
+                    refs.push_back(ref);
+                    operands.push_back(value);
+
+                    if (ref or kind == 'r') {
+                        max_register = max(max_register, value);
+                    }
+                    if (ref and kind == 'r') {
+                        registers_known = false;
+                    }
+                } else if (kind == 'j') {
+                    refs.push_back(false);
+                    operands.push_back(*reinterpret_cast<int*>(bytecode+addr));
+                } else {
+                    refs.push_back(false);
+                    operands.push_back(0);
+                }
+                addr += width;
+            }
+            if (truncated) {
+                report << "truncated '" << OP_NAMES.at(op) << "' instruction at byte " << instruction << " in '" << name << "'";
+                return report.str();
+            }
+
+            if (op == JUMP) {
+                jumps.push_back(tuple<unsigned, unsigned>(instruction, unsigned(operands[0])));
+            } else if (op == BRANCH) {
+                jumps.push_back(tuple<unsigned, unsigned>(instruction, unsigned(operands[1])));
+                jumps.push_back(tuple<unsigned, unsigned>(instruction, unsigned(operands[2])));
+            } else if (op == RESS and operands[0] != 1) {
+                registers_known = false;
+            } else if (op == FRAME) {
+                if (frame_pending) {
+                    report << "frame at byte " << instruction << " in '" << name << "' created while last one is unused";
+                    return report.str();
+                }
+                frame_pending = true;
+                frame_locals = (refs[1] ? -1 : operands[1]);
+            } else if (op == PARAM or op == PAREF) {
+                if (not frame_pending) {
+                    report << "parameter passed without a frame at byte " << instruction << " in '" << name << "'";
+                    return report.str();
+                }
+            } else if (op == CALL or op == TAILCALL or op == SPAWN or op == COROUTINE or op == FCALL or op == MSG) {
+                if (not frame_pending) {
+                    report << "call without a frame at byte " << instruction << " in '" << name << "'";
+                    return report.str();
+                }
+                if ((op == CALL or op == TAILCALL) and functions.count(callee) and functions.at(callee) == instruction) {
+                    report << "function '" << callee << "' calls itself in its first instruction";
+                    return report.str();
+                }
+                if ((op == CALL or op == TAILCALL or op == SPAWN or op == COROUTINE) and frame_locals >= 0) {
+                    calls.push_back(tuple<unsigned, string, int>(instruction, callee, frame_locals));
+                }
+                frame_pending = false;
+            }
+        }
+
+        if (not isterminating(op)) {
+            report << (is_function ? "function" : "block") << " '" << name << "' does not end with a terminating instruction";
+            return report.str();
+        }
+        if (frame_pending) {
+            report << "unused frame at the end of '" << name << "'";
+            return report.str();
+        }
+
+        if (is_function) {
+            registers_used[name] = tuple<int, bool>(max_register, registers_known);
+        }
+    }
+
+    for (unsigned i = 0; i < jumps.size(); ++i) {
+        unsigned instruction, target;
+        tie(instruction, target) = jumps[i];
+        if (target >= bytecode_size or not boundaries[target]) {
+            report << "jump at byte " << instruction << " to byte " << target << " which is not an instruction boundary";
+            return report.str();
+        }
+        if (target == instruction) {
+            report << "jump at byte " << instruction << " to itself";
+            return report.str();
+        }
+    }
+
+    for (unsigned i = 0; i < calls.size(); ++i) {
+        unsigned instruction;
+        string callee;
+        int locals;
+        tie(instruction, callee, locals) = calls[i];
+
+        if (registers_used.count(callee) == 0 or not get<1>(registers_used.at(callee))) {
+            // function is linked from another module, or its register usage could not be established
+            continue;
+        }
+        if (get<0>(registers_used.at(callee)) >= locals) {
+            report << "function '" << callee << "' accesses register " << get<0>(registers_used.at(callee));
+            report << " but is called at byte " << instruction << " with frame of " << locals << " local registers";
+            return report.str();
+        }
+    }
+
+    return "";
+}
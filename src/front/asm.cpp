@@ -1,7 +1,10 @@
 #include <iostream>
 #include <fstream>
+#include <sstream>
+#include <algorithm>
 #include <viua/support/string.h>
 #include <viua/support/env.h>
+#include <viua/support/lz.h>
 #include <viua/version.h>
 #include <viua/cg/assembler/assembler.h>
 #include <viua/front/asm.h>
@@ -24,6 +27,30 @@ bool VERBOSE = false;
 bool DEBUG = false;
 bool SCREAM = false;
 
+// compilation cache
+bool NO_CACHE = false;
+bool CACHE_FUNCTIONS = false;
+
+// should the output be compressed?
+bool COMPRESS = false;
+
+// number of threads generating bytecode of functions and blocks
+unsigned JOBS = 1;
+
+// optimization level
+unsigned OPTIMIZE = 0;
+
+// functions and blocks which must not be removed even if they are not reachable
+vector<string> KEEP;
+
+// maximum number of instructions of inlined functions, and
+// maximum number of instructions inlining may add to a single function
+unsigned INLINE_LIMIT = 8;
+unsigned INLINE_GROWTH = 64;
+
+// profile used to lay out functions and blocks
+string PROFILE_USE = "";
+
 bool WARNING_ALL = false;
 bool ERROR_ALL = false;
 
@@ -57,6 +84,20 @@ bool usage(const char* program, bool SHOW_HELP, bool SHOW_VERSION, bool VERBOSE)
              << "    " << "    --Emissing-end       - treat missing 'end' instruction at the end of function as error\n"
              << "    " << "    --Ehalt-is-last      - treat 'halt' being used as last instruction of 'main' function as error\n"
              << "    " << "-c, --lib                - assemble as a library\n"
+             << "    " << "    --no-cache           - do not use compilation cache even if VIUACACHE is set\n"
+             << "    " << "    --cache-functions    - cache bytecode of individual functions and blocks (requires VIUACACHE)\n"
+             << "    " << "    --compress           - compress generated module (it is decompressed transparently on load)\n"
+             << "    " << "-j, --jobs <n>           - generate bytecode of functions and blocks on <n> threads (output is the same as with 1)\n"
+             << "    " << "-O0                      - do not optimize generated bytecode (default)\n"
+             << "    " << "-O1                      - apply peephole optimizations to functions and blocks, and\n"
+             << "    " << "                           remove functions and blocks that are not reachable from main function\n"
+             << "    " << "    --keep <name>        - do not remove function or block <name> even if it is not reachable\n"
+             << "    " << "                           (e.g. when it is called only by dynamically linked modules)\n"
+             << "    " << "-O2                      - apply -O1 optimizations, and inline calls to small leaf functions\n"
+             << "    " << "    --inline-limit <n>   - inline only functions of at most <n> instructions (default: 8)\n"
+             << "    " << "    --inline-growth <n>  - let inlining add at most <n> instructions to a single function (default: 64)\n"
+             << "    " << "    --profile-use <file> - lay out functions and blocks so that code executed in the profile written by\n"
+             << "    " << "                           'viua-cpu --profile <file>' is packed together\n"
              << "    " << "-E, --expand             - only expand the source code to simple form (one instruction per line)\n"
              << "    " << "                           with this option, assembler prints expanded source to standard output\n"
              << "    " << "-C, --verify             - verify source code correctness without actually compiling it\n"
@@ -95,6 +136,15 @@ int main(int argc, char* argv[]) {
         } else if (option == "--lib" or option == "-c") {
             AS_LIB = true;
             continue;
+        } else if (option == "--no-cache") {
+            NO_CACHE = true;
+            continue;
+        } else if (option == "--cache-functions") {
+            CACHE_FUNCTIONS = true;
+            continue;
+        } else if (option == "--compress") {
+            COMPRESS = true;
+            continue;
         } else if (option == "--Wall" or option == "-W") {
             WARNING_ALL = true;
             continue;
@@ -121,6 +171,46 @@ int main(int argc, char* argv[]) {
                 exit(1);
             }
             continue;
+        } else if (option == "--jobs" or option == "-j") {
+            if (i < argc-1 and str::isnum(argv[i+1], false) and stoi(argv[i+1]) > 0) {
+                JOBS = unsigned(stoi(argv[++i]));
+            } else {
+                cout << "error: option '" << argv[i] << "' requires an argument: positive number of threads" << endl;
+                exit(1);
+            }
+            continue;
+        } else if (option == "-O0" or option == "-O1" or option == "-O2") {
+            OPTIMIZE = unsigned(stoi(option.substr(2)));
+            continue;
+        } else if (option == "--keep") {
+            if (i < argc-1) {
+                KEEP.push_back(string(argv[++i]));
+            } else {
+                cout << "error: option '" << argv[i] << "' requires an argument: function or block name" << endl;
+                exit(1);
+            }
+            continue;
+        } else if (option == "--inline-limit" or option == "--inline-growth") {
+            if (i < argc-1 and str::isnum(argv[i+1], false)) {
+                unsigned n = unsigned(stoi(argv[++i]));
+                if (option == "--inline-limit") {
+                    INLINE_LIMIT = n;
+                } else {
+                    INLINE_GROWTH = n;
+                }
+            } else {
+                cout << "error: option '" << argv[i] << "' requires an argument: number of instructions" << endl;
+                exit(1);
+            }
+            continue;
+        } else if (option == "--profile-use") {
+            if (i < argc-1) {
+                PROFILE_USE = string(argv[++i]);
+            } else {
+                cout << "error: option '" << argv[i] << "' requires an argument: filename" << endl;
+                exit(1);
+            }
+            continue;
         } else if (option == "--expand" or option == "-E") {
             EXPAND_ONLY = true;
             continue;
@@ -256,7 +346,8 @@ int main(int argc, char* argv[]) {
     // VERIFY FUNCTION BODIES
     for (auto function : functions.bodies) {
         vector<string> flines = function.second;
-        if ((flines.size() == 0 or flines.back() != "end") and (function.first != "main" and flines.back() != "halt")) {
+        // functions may also end with a tail call as the called function returns in their place
+        if ((flines.size() == 0 or (flines.back() != "end" and str::chunk(flines.back()) != "tailcall")) and (function.first != "main" and flines.back() != "halt")) {
             if (ERROR_MISSING_END or ERROR_ALL) {
                 cout << "fatal: missing 'end' at the end of function '" << function.first << "'" << endl;
                 exit(1);
@@ -291,6 +382,71 @@ int main(int argc, char* argv[]) {
     flags.verbose = VERBOSE;
     flags.debug = DEBUG;
     flags.scream = SCREAM;
+    flags.cache = (NO_CACHE ? "" : cache::directory(string(VERSION) + '.' + MICRO + ' ' + COMMIT));
+    flags.cache_functions = (CACHE_FUNCTIONS and flags.cache.size());
+    flags.jobs = JOBS;
+    flags.optimize = OPTIMIZE;
+    flags.keep = KEEP;
+    flags.inline_limit = INLINE_LIMIT;
+    flags.inline_growth = INLINE_GROWTH;
+    flags.profile_use = PROFILE_USE;
+
+
+    /////////////////////////////////////
+    // LOOK UP MODULE IN COMPILATION CACHE
+    // key is computed from expanded source, contents of
+    // linked modules, and options that affect generated bytecode
+    string cache_key = "";
+    if (flags.cache.size()) {
+        vector<string> key_parts = { (AS_LIB ? "lib" : "exe"), (COMPRESS ? "compressed" : "plain"), ("O" + to_string(OPTIMIZE)) };
+        for (string name : KEEP) {
+            key_parts.push_back("keep " + name);
+        }
+        if (OPTIMIZE > 1) {
+            key_parts.push_back("inline " + to_string(INLINE_LIMIT) + ' ' + to_string(INLINE_GROWTH));
+        }
+        if (PROFILE_USE.size()) {
+            ifstream profile_in(PROFILE_USE);
+            ostringstream profile_contents;
+            profile_contents << profile_in.rdbuf();
+            key_parts.push_back("profile " + profile_contents.str());
+        }
+        key_parts.insert(key_parts.end(), expanded_lines.begin(), expanded_lines.end());
+
+        vector<string> links = assembler::ce::getlinks(ilines);
+        for (string lnk : commandline_given_links) {
+            if (find(links.begin(), links.end(), lnk) == links.end()) {
+                links.push_back(lnk);
+            }
+        }
+
+        bool cacheable = true;
+        for (string lnk : links) {
+            ifstream lib_in(lnk, ios::in | ios::binary);
+            if (!lib_in) {
+                // let the linker report the error
+                cacheable = false;
+                break;
+            }
+            ostringstream lib_contents;
+            lib_contents << lib_in.rdbuf();
+            key_parts.push_back(lnk);
+            key_parts.push_back(lib_contents.str());
+        }
+
+        string cached;
+        if (cacheable) {
+            cache_key = cache::key(key_parts);
+        }
+        if (cache_key.size() and cache::fetch(flags.cache, cache_key, cached)) {
+            if (VERBOSE or DEBUG) {
+                cout << "message: using cached bytecode: " << flags.cache << '/' << cache_key << endl;
+            }
+            ofstream out(compilename, ios::out | ios::binary);
+            out.write(cached.c_str(), static_cast<std::streamsize>(cached.size()));
+            return 0;
+        }
+    }
 
     int ret_code = 0;
     try {
@@ -300,5 +456,32 @@ int main(int argc, char* argv[]) {
         cout << "fatal: exception occured during assembling: " << e << endl;
     }
 
+    ///////////////////
+    // COMPRESS THE OUTPUT
+    if (ret_code == 0 and COMPRESS) {
+        ifstream compiled(compilename, ios::in | ios::binary);
+        ostringstream compiled_contents;
+        compiled_contents << compiled.rdbuf();
+        compiled.close();
+
+        string compressed = support::lz::compress(compiled_contents.str());
+        ofstream out(compilename, ios::out | ios::binary);
+        out.write(compressed.c_str(), static_cast<std::streamsize>(compressed.size()));
+        out.close();
+
+        if (VERBOSE or DEBUG) {
+            cout << "message: compressed " << compiled_contents.str().size() << " bytes to " << compressed.size() << " bytes" << endl;
+        }
+    }
+
+    if (ret_code == 0 and cache_key.size()) {
+        ifstream compiled(compilename, ios::in | ios::binary);
+        ostringstream compiled_contents;
+        compiled_contents << compiled.rdbuf();
+        if (cache::store(flags.cache, cache_key, compiled_contents.str()) and (VERBOSE or DEBUG)) {
+            cout << "message: stored bytecode in cache: " << flags.cache << '/' << cache_key << endl;
+        }
+    }
+
     return ret_code;
 }
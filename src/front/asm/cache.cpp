@@ -0,0 +1,112 @@
+#include <cstdint>
+#include <cstdio>
+#include <iomanip>
+#include <fstream>
+#include <sstream>
+#include <thread>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <viua/support/env.h>
+#include <viua/front/asm.h>
+using namespace std;
+
+
+namespace cache {
+    static uint64_t fnv1a(uint64_t hash, const string& data) {
+        /** 64-bit FNV-1a hash.
+         *
+         *  It is not cryptographically strong, but it is fast and good enough to
+         *  tell apart inputs of the assembler.
+         */
+        for (unsigned i = 0; i < data.size(); ++i) {
+            hash ^= uint64_t(static_cast<unsigned char>(data[i]));
+            hash *= 1099511628211ULL;
+        }
+        return hash;
+    }
+
+    string key(const vector<string>& parts) {
+        /** Compute cache key for given parts of input.
+         *
+         *  Parts are separated by a null character so that
+         *  splitting the same text differently yields different keys.
+         */
+        uint64_t hash = 14695981039346656037ULL;
+        for (unsigned i = 0; i < parts.size(); ++i) {
+            hash = fnv1a(hash, parts[i]);
+            hash = fnv1a(hash, string(1, '\0'));
+        }
+        ostringstream oss;
+        oss << hex << setw(16) << setfill('0') << hash;
+        return oss.str();
+    }
+
+    string directory(const string& salt) {
+        /** Return directory in which compiled bytecode is cached.
+         *
+         *  Cache is rooted in the directory given by VIUACACHE environment variable, and
+         *  is disabled (empty string is returned) if the variable is not set.
+         *  Entries are kept in a subdirectory specific to the assembler binary so
+         *  that a rebuilt assembler never picks bytecode generated by its older self.
+         */
+        string root = support::env::getvar("VIUACACHE");
+        if (root == "") {
+            return "";
+        }
+
+        vector<string> parts = {salt};
+        struct stat sf;
+        if (stat("/proc/self/exe", &sf) == 0) {
+            parts.push_back(to_string(sf.st_size));
+            parts.push_back(to_string(sf.st_mtime));
+        }
+
+        return (root + '/' + key(parts));
+    }
+
+    bool fetch(const string& dir, const string& key, string& blob) {
+        /** Fetch cached blob.
+         *
+         *  Returns true if the blob was found, false otherwise.
+         */
+        ifstream in(dir + '/' + key, ios::in | ios::binary);
+        if (!in) {
+            return false;
+        }
+        ostringstream oss;
+        oss << in.rdbuf();
+        blob = oss.str();
+        return true;
+    }
+
+    bool store(const string& dir, const string& key, const string& blob) {
+        /** Store blob in the cache.
+         *
+         *  Blob is first written to a temporary file which is then renamed to its
+         *  final name so concurrently running assemblers (or threads of one assembler) never see
+         *  partially written entries.
+         *  Failure to store a blob is not an error - the cache is just an optimisation.
+         */
+        string::size_type slash = dir.rfind('/');
+        if (slash != string::npos and slash != 0) {
+            mkdir(dir.substr(0, slash).c_str(), 0755);
+        }
+        mkdir(dir.c_str(), 0755);
+
+        ostringstream tmp;
+        tmp << dir << '/' << key << ".tmp." << getpid() << '.' << hash<thread::id>()(this_thread::get_id());
+
+        ofstream out(tmp.str(), ios::out | ios::binary);
+        if (!out) {
+            return false;
+        }
+        out.write(blob.c_str(), static_cast<std::streamsize>(blob.size()));
+        out.close();
+        if (!out) {
+            remove(tmp.str().c_str());
+            return false;
+        }
+
+        return (rename(tmp.str().c_str(), (dir + '/' + key).c_str()) == 0);
+    }
+}
@@ -1,6 +1,8 @@
 #include <cstdint>
 #include <iostream>
 #include <algorithm>
+#include <atomic>
+#include <thread>
 #include <fstream>
 #include <sstream>
 #include <viua/bytecode/maps.h>
@@ -8,9 +10,9 @@
 #include <viua/support/env.h>
 #include <viua/loader.h>
 #include <viua/program.h>
-#include <viua/cg/tokenizer.h>
 #include <viua/cg/assembler/assembler.h>
 #include <viua/front/asm.h>
+#include <viua/front/ir.h>
 using namespace std;
 
 
@@ -123,6 +125,15 @@ const map<string, ThreeIntopAssemblerFunction> THREE_INTOP_ASM_FUNCTIONS = {
     { "igt",  &Program::igt },
     { "igte", &Program::igte },
     { "ieq",  &Program::ieq },
+    { "tiadd", &Program::tiadd },
+    { "tisub", &Program::tisub },
+    { "timul", &Program::timul },
+    { "tidiv", &Program::tidiv },
+    { "tilt", &Program::tilt },
+    { "tilte", &Program::tilte },
+    { "tigt", &Program::tigt },
+    { "tigte", &Program::tigte },
+    { "tieq", &Program::tieq },
 
     { "fadd", &Program::fadd },
     { "fsub", &Program::fsub },
@@ -164,7 +175,7 @@ vector<string> filter(const vector<string>& lines) {
     string line;
     for (unsigned i = 0; i < lines.size(); ++i) {
         line = lines[i];
-        if (str::startswith(line, ".mark:") or str::startswith(line, ".name:") or str::startswith(line, ".main:") or str::startswith(line, ".link:") or str::startswith(line, ".signature:") or str::startswith(line, ".bsignature:") or str::startswith(line, ".type:")) {
+        if (str::startswith(line, ".mark:") or str::startswith(line, ".name:") or str::startswith(line, ".main:") or str::startswith(line, ".link:") or str::startswith(line, ".signature:") or str::startswith(line, ".bsignature:") or str::startswith(line, ".type:") or str::startswith(line, ".noinline:")) {
             /*  Lines beginning with `.mark:` are just markers placed in code and
              *  are do not produce any bytecode.
              *  Lines beginning with `.name:` are asm directives that assign human-rememberable names to
@@ -173,6 +184,7 @@ vector<string> filter(const vector<string>& lines) {
              *  blocks that will be available at runtime but may not be available during compilation.
              *  Lines beginning with `.type:` inform the assembler that definition of this type will be
              *  supplied later (either by `.class:` block, or by dynamically defining the type during runtime).
+             *  Lines beginning with `.noinline:` forbid inlining given function.
              *
              *  Assembler directives are discarded by the assembler during the bytecode-generation phase
              *  so they can be skipped in this step as fast as possible
@@ -217,395 +229,535 @@ Program& compile(Program& program, const vector<string>& lines, map<string, int>
 
         string instr;
         string operands;
-        istringstream iss(line);
 
         instr = str::chunk(line);
         operands = str::lstrip(str::sub(line, instr.size()));
 
-        vector<string> tokens = tokenize(operands);
-
         if (DEBUG and SCREAM) {
             cout << "[asm] compiling line: `" << line << "`" << endl;
         }
 
-        if (line == "nop") {
-            program.nop();
-        } else if (str::startswith(line, "izero")) {
-            string regno_chnk;
-            regno_chnk = str::chunk(operands);
-            program.izero(assembler::operands::getint(resolveregister(regno_chnk, names)));
-        } else if (str::startswith(line, "istore")) {
-            string regno_chnk, number_chnk;
-            tie(regno_chnk, number_chnk) = assembler::operands::get2(operands);
-            program.istore(assembler::operands::getint(resolveregister(regno_chnk, names)), assembler::operands::getint(resolveregister(number_chnk, names)));
-        } else if (str::startswith(line, "iadd")) {
-            assemble_three_intop_instruction(program, names, "iadd", operands);
-        } else if (str::startswith(line, "isub")) {
-            assemble_three_intop_instruction(program, names, "isub", operands);
-        } else if (str::startswith(line, "imul")) {
-            assemble_three_intop_instruction(program, names, "imul", operands);
-        } else if (str::startswith(line, "idiv")) {
-            assemble_three_intop_instruction(program, names, "idiv", operands);
-        } else if (str::startswithchunk(line, "ilt")) {
-            assemble_three_intop_instruction(program, names, "ilt", operands);
-        } else if (str::startswithchunk(line, "ilte")) {
-            assemble_three_intop_instruction(program, names, "ilte", operands);
-        } else if (str::startswith(line, "igte")) {
-            assemble_three_intop_instruction(program, names, "igte", operands);
-        } else if (str::startswith(line, "igt")) {
-            assemble_three_intop_instruction(program, names, "igt", operands);
-        } else if (str::startswith(line, "ieq")) {
-            assemble_three_intop_instruction(program, names, "ieq", operands);
-        } else if (str::startswith(line, "iinc")) {
-            string regno_chnk;
-            regno_chnk = str::chunk(operands);
-            program.iinc(assembler::operands::getint(resolveregister(regno_chnk, names)));
-        } else if (str::startswith(line, "idec")) {
-            string regno_chnk;
-            regno_chnk = str::chunk(operands);
-            program.idec(assembler::operands::getint(resolveregister(regno_chnk, names)));
-        } else if (str::startswith(line, "fstore")) {
-            string regno_chnk, float_chnk;
-            tie(regno_chnk, float_chnk) = assembler::operands::get2(operands);
-            program.fstore(assembler::operands::getint(resolveregister(regno_chnk, names)), stod(float_chnk));
-        } else if (str::startswith(line, "fadd")) {
-            assemble_three_intop_instruction(program, names, "fadd", operands);
-        } else if (str::startswith(line, "fsub")) {
-            assemble_three_intop_instruction(program, names, "fsub", operands);
-        } else if (str::startswith(line, "fmul")) {
-            assemble_three_intop_instruction(program, names, "fmul", operands);
-        } else if (str::startswith(line, "fdiv")) {
-            assemble_three_intop_instruction(program, names, "fdiv", operands);
-        } else if (str::startswithchunk(line, "flt")) {
-            assemble_three_intop_instruction(program, names, "flt", operands);
-        } else if (str::startswithchunk(line, "flte")) {
-            assemble_three_intop_instruction(program, names, "flte", operands);
-        } else if (str::startswithchunk(line, "fgt")) {
-            assemble_three_intop_instruction(program, names, "fgt", operands);
-        } else if (str::startswithchunk(line, "fgte")) {
-            assemble_three_intop_instruction(program, names, "fgte", operands);
-        } else if (str::startswith(line, "feq")) {
-            assemble_three_intop_instruction(program, names, "feq", operands);
-        } else if (str::startswith(line, "bstore")) {
-            string regno_chnk, byte_chnk;
-            tie(regno_chnk, byte_chnk) = assembler::operands::get2(operands);
-            program.bstore(assembler::operands::getint(resolveregister(regno_chnk, names)), assembler::operands::getbyte(resolveregister(byte_chnk, names)));
-        } else if (str::startswith(line, "itof")) {
-            string a_chnk, b_chnk;
-            tie(a_chnk, b_chnk) = assembler::operands::get2(operands);
-            if (b_chnk.size() == 0) { b_chnk = a_chnk; }
-            program.itof(assembler::operands::getint(resolveregister(a_chnk, names)), assembler::operands::getint(resolveregister(b_chnk, names)));
-        } else if (str::startswith(line, "ftoi")) {
-            string a_chnk, b_chnk;
-            tie(a_chnk, b_chnk) = assembler::operands::get2(operands);
-            if (b_chnk.size() == 0) { b_chnk = a_chnk; }
-            program.ftoi(assembler::operands::getint(resolveregister(a_chnk, names)), assembler::operands::getint(resolveregister(b_chnk, names)));
-        } else if (str::startswith(line, "stoi")) {
-            string a_chnk, b_chnk;
-            tie(a_chnk, b_chnk) = assembler::operands::get2(operands);
-            if (b_chnk.size() == 0) { b_chnk = a_chnk; }
-            program.stoi(assembler::operands::getint(resolveregister(a_chnk, names)), assembler::operands::getint(resolveregister(b_chnk, names)));
-        } else if (str::startswith(line, "stof")) {
-            string a_chnk, b_chnk;
-            tie(a_chnk, b_chnk) = assembler::operands::get2(operands);
-            if (b_chnk.size() == 0) { b_chnk = a_chnk; }
-            program.stof(assembler::operands::getint(resolveregister(a_chnk, names)), assembler::operands::getint(resolveregister(b_chnk, names)));
-        } else if (str::startswith(line, "strstore")) {
-            string reg_chnk, str_chnk;
-            reg_chnk = str::chunk(operands);
-            operands = str::lstrip(str::sub(operands, reg_chnk.size()));
-            str_chnk = str::extract(operands);
-            program.strstore(assembler::operands::getint(resolveregister(reg_chnk, names)), str_chnk);
-        } else if (str::startswith(line, "vec")) {
-            string regno_chnk;
-            regno_chnk = str::chunk(operands);
-            program.vec(assembler::operands::getint(resolveregister(regno_chnk, names)));
-        } else if (str::startswith(line, "vinsert")) {
-            string vec, src, pos;
-            tie(vec, src, pos) = assembler::operands::get3(operands, false);
-            if (pos == "") { pos = "0"; }
-            program.vinsert(assembler::operands::getint(resolveregister(vec, names)), assembler::operands::getint(resolveregister(src, names)), assembler::operands::getint(resolveregister(pos, names)));
-        } else if (str::startswith(line, "vpush")) {
-            string regno_chnk, number_chnk;
-            tie(regno_chnk, number_chnk) = assembler::operands::get2(operands);
-            program.vpush(assembler::operands::getint(resolveregister(regno_chnk, names)), assembler::operands::getint(resolveregister(number_chnk, names)));
-        } else if (str::startswith(line, "vpop")) {
-            string vec, dst, pos;
-            tie(vec, dst, pos) = assembler::operands::get3(operands, false);
-            if (dst == "") { dst = "0"; }
-            if (pos == "") { pos = "-1"; }
-            program.vpop(assembler::operands::getint(resolveregister(vec, names)), assembler::operands::getint(resolveregister(dst, names)), assembler::operands::getint(resolveregister(pos, names)));
-        } else if (str::startswith(line, "vat")) {
-            string vec, dst, pos;
-            tie(vec, dst, pos) = assembler::operands::get3(operands, false);
-            if (pos == "") { pos = "-1"; }
-            program.vat(assembler::operands::getint(resolveregister(vec, names)), assembler::operands::getint(resolveregister(dst, names)), assembler::operands::getint(resolveregister(pos, names)));
-        } else if (str::startswith(line, "vlen")) {
-            string regno_chnk, number_chnk;
-            tie(regno_chnk, number_chnk) = assembler::operands::get2(operands);
-            program.vlen(assembler::operands::getint(resolveregister(regno_chnk, names)), assembler::operands::getint(resolveregister(number_chnk, names)));
-        } else if (str::startswith(line, "not")) {
-            string regno_chnk;
-            regno_chnk = str::chunk(operands);
-            program.lognot(assembler::operands::getint(resolveregister(regno_chnk, names)));
-        } else if (str::startswith(line, "and")) {
-            assemble_three_intop_instruction(program, names, "and", operands);
-        } else if (str::startswith(line, "or")) {
-            assemble_three_intop_instruction(program, names, "or", operands);
-        } else if (str::startswith(line, "move")) {
-            string a_chnk, b_chnk;
-            tie(a_chnk, b_chnk) = assembler::operands::get2(operands);
-            program.move(assembler::operands::getint(resolveregister(a_chnk, names)), assembler::operands::getint(resolveregister(b_chnk, names)));
-        } else if (str::startswith(line, "copy")) {
-            string a_chnk, b_chnk;
-            tie(a_chnk, b_chnk) = assembler::operands::get2(operands);
-            program.copy(assembler::operands::getint(resolveregister(a_chnk, names)), assembler::operands::getint(resolveregister(b_chnk, names)));
-        } else if (str::startswith(line, "ref")) {
-            string a_chnk, b_chnk;
-            tie(a_chnk, b_chnk) = assembler::operands::get2(operands);
-            program.ref(assembler::operands::getint(resolveregister(a_chnk, names)), assembler::operands::getint(resolveregister(b_chnk, names)));
-        } else if (str::startswith(line, "swap")) {
-            string a_chnk, b_chnk;
-            tie(a_chnk, b_chnk) = assembler::operands::get2(operands);
-            program.swap(assembler::operands::getint(resolveregister(a_chnk, names)), assembler::operands::getint(resolveregister(b_chnk, names)));
-        } else if (str::startswith(line, "free")) {
-            string regno_chnk;
-            regno_chnk = str::chunk(operands);
-            program.free(assembler::operands::getint(resolveregister(regno_chnk, names)));
-        } else if (str::startswith(line, "empty")) {
-            string regno_chnk;
-            regno_chnk = str::chunk(operands);
-            program.empty(assembler::operands::getint(resolveregister(regno_chnk, names)));
-        } else if (str::startswith(line, "isnull")) {
-            string a_chnk, b_chnk;
-            tie(a_chnk, b_chnk) = assembler::operands::get2(operands);
-            program.isnull(assembler::operands::getint(resolveregister(a_chnk, names)), assembler::operands::getint(resolveregister(b_chnk, names)));
-        } else if (str::startswith(line, "ress")) {
-            program.ress(operands);
-        } else if (str::startswith(line, "tmpri")) {
-            string regno_chnk;
-            regno_chnk = str::chunk(operands);
-            program.tmpri(assembler::operands::getint(resolveregister(regno_chnk, names)));
-        } else if (str::startswith(line, "tmpro")) {
-            string regno_chnk;
-            regno_chnk = str::chunk(operands);
-            program.tmpro(assembler::operands::getint(resolveregister(regno_chnk, names)));
-        } else if (str::startswith(line, "print")) {
-            string regno_chnk;
-            regno_chnk = str::chunk(operands);
-            program.print(assembler::operands::getint(resolveregister(regno_chnk, names)));
-        } else if (str::startswith(line, "echo")) {
-            string regno_chnk;
-            regno_chnk = str::chunk(operands);
-            program.echo(assembler::operands::getint(resolveregister(regno_chnk, names)));
-        } else if (str::startswith(line, "clbind")) {
-            string regno_chnk;
-            regno_chnk = str::chunk(operands);
-            program.clbind(assembler::operands::getint(resolveregister(regno_chnk, names)));
-        } else if (str::startswith(line, "closure")) {
-            string fn_name, reg;
-            tie(reg, fn_name) = assembler::operands::get2(operands);
-            program.closure(assembler::operands::getint(resolveregister(reg, names)), fn_name);
-        } else if (str::startswith(line, "function")) {
-            string fn_name, reg;
-            tie(reg, fn_name) = assembler::operands::get2(operands);
-            program.function(assembler::operands::getint(resolveregister(reg, names)), fn_name);
-        } else if (str::startswith(line, "fcall")) {
-            string a_chnk, b_chnk;
-            tie(a_chnk, b_chnk) = assembler::operands::get2(operands);
-            program.fcall(assembler::operands::getint(resolveregister(a_chnk, names)), assembler::operands::getint(resolveregister(b_chnk, names)));
-        } else if (str::startswith(line, "frame")) {
-            string a_chnk, b_chnk;
-            tie(a_chnk, b_chnk) = assembler::operands::get2(operands);
-            if (a_chnk.size() == 0) { a_chnk = "0"; }
-            if (b_chnk.size() == 0) { b_chnk = "16"; }  // default number of local registers
-            program.frame(assembler::operands::getint(resolveregister(a_chnk, names)), assembler::operands::getint(resolveregister(b_chnk, names)));
-        } else if (str::startswith(line, "param")) {
-            string a_chnk, b_chnk;
-            tie(a_chnk, b_chnk) = assembler::operands::get2(operands);
-            program.param(assembler::operands::getint(resolveregister(a_chnk, names)), assembler::operands::getint(resolveregister(b_chnk, names)));
-        } else if (str::startswith(line, "paref")) {
-            string a_chnk, b_chnk;
-            tie(a_chnk, b_chnk) = assembler::operands::get2(operands);
-            program.paref(assembler::operands::getint(resolveregister(a_chnk, names)), assembler::operands::getint(resolveregister(b_chnk, names)));
-        } else if (str::startswithchunk(line, "arg")) {
-            string a_chnk, b_chnk;
-            tie(a_chnk, b_chnk) = assembler::operands::get2(operands);
-            program.arg(assembler::operands::getint(resolveregister(a_chnk, names)), assembler::operands::getint(resolveregister(b_chnk, names)));
-        } else if (str::startswith(line, "argc")) {
-            string regno_chnk;
-            regno_chnk = str::chunk(operands);
-            program.argc(assembler::operands::getint(resolveregister(regno_chnk, names)));
-        } else if (str::startswith(line, "call")) {
-            /** Full form of call instruction has two operands: function name and return value register index.
-             *  If call is given only one operand - it means it is the instruction index and returned value is discarded.
-             *  To explicitly state that return value should be discarderd 0 can be supplied as second operand.
-             */
-            /** Why is the function supplied as a *string* and not direct instruction pointer?
-             *  That would be faster - c'mon couldn't assembler just calculate offsets and insert them?
-             *
-             *  Nope.
-             *
-             *  Yes, it *would* be faster if calls were just precalculated jumps.
-             *  However, by them being strings we get plenty of flexibility, good-quality stack traces, and
-             *  a place to put plenty of debugging info.
-             *  All that at a cost of just one map lookup; the overhead is minimal and gains are big.
-             *  What's not to love?
-             *
-             *  Of course, you, my dear reader, are free to take this code (it's GPL after all!) and
-             *  modify it to suit your particular needs - in that case that would be calculating call jumps
-             *  at compile time and exchanging CALL instructions with JUMP instructions.
-             *
-             *  Good luck with debugging your code, then.
-             */
-            string fn_name, reg;
-            tie(reg, fn_name) = assembler::operands::get2(operands);
+        OPCODE op = NOP;
+        try {
+            op = Program::schema(instr).opcode;
+        } catch (const std::out_of_range& e) {
+            throw ("unimplemented instruction: " + instr);
+        }
 
-            // if second operand is empty, fill it with zero
-            // which means that return value will be discarded
-            if (fn_name == "") {
-                fn_name = reg;
-                reg = "0";
+        switch (op) {
+            case NOP:
+                program.nop();
+                break;
+            case IZERO: {
+                string regno_chnk;
+                regno_chnk = str::chunk(operands);
+                program.izero(assembler::operands::getint(resolveregister(regno_chnk, names)));
+                break;
             }
-
-            program.call(assembler::operands::getint(resolveregister(reg, names)), fn_name);
-        } else if (str::startswith(line, "branch")) {
-            /*  If branch is given three operands, it means its full, three-operands form is being used.
-             *  Otherwise, it is short, two-operands form instruction and assembler should fill third operand accordingly.
-             *
-             *  In case of short-form `branch` instruction:
-             *
-             *      * first operand is index of the register to check,
-             *      * second operand is the address to which to jump if register is true,
-             *      * third operand is assumed to be the *next instruction*, i.e. instruction after the branch instruction,
-             *
-             *  In full (with three operands) form of `branch` instruction:
-             *
-             *      * third operands is the address to which to jump if register is false,
-             */
-            string condition, if_true, if_false;
-            tie(condition, if_true, if_false) = assembler::operands::get3(operands, false);
-
-            int addrt_target, addrf_target;
-            enum JUMPTYPE addrt_jump_type, addrf_jump_type;
-            tie(addrt_target, addrt_jump_type) = resolvejump(if_true, marks, i);
-            if (if_false != "") {
-                tie(addrf_target, addrf_jump_type) = resolvejump(if_false, marks, i);
-            } else {
-                addrf_jump_type = JMP_RELATIVE;
-                addrf_target = instruction+1;
+            case ISTORE: {
+                string regno_chnk, number_chnk;
+                tie(regno_chnk, number_chnk) = assembler::operands::get2(operands);
+                program.istore(assembler::operands::getint(resolveregister(regno_chnk, names)), assembler::operands::getint(resolveregister(number_chnk, names)));
+                break;
             }
-
-            if (DEBUG) {
-                if (addrt_jump_type == JMP_TO_BYTE) {
-                    cout << line << " => truth jump to byte";
-                } else if (addrt_jump_type == JMP_ABSOLUTE) {
-                    cout << line << " => truth absolute jump";
-                } else {
-                    cout << line << " => truth relative jump";
+            case IINC: {
+                string regno_chnk;
+                regno_chnk = str::chunk(operands);
+                program.iinc(assembler::operands::getint(resolveregister(regno_chnk, names)));
+                break;
+            }
+            case IDEC: {
+                string regno_chnk;
+                regno_chnk = str::chunk(operands);
+                program.idec(assembler::operands::getint(resolveregister(regno_chnk, names)));
+                break;
+            }
+            case FSTORE: {
+                string regno_chnk, float_chnk;
+                tie(regno_chnk, float_chnk) = assembler::operands::get2(operands);
+                program.fstore(assembler::operands::getint(resolveregister(regno_chnk, names)), stod(float_chnk));
+                break;
+            }
+            case BSTORE: {
+                string regno_chnk, byte_chnk;
+                tie(regno_chnk, byte_chnk) = assembler::operands::get2(operands);
+                program.bstore(assembler::operands::getint(resolveregister(regno_chnk, names)), assembler::operands::getbyte(resolveregister(byte_chnk, names)));
+                break;
+            }
+            case ITOF: {
+                string a_chnk, b_chnk;
+                tie(a_chnk, b_chnk) = assembler::operands::get2(operands);
+                if (b_chnk.size() == 0) { b_chnk = a_chnk; }
+                program.itof(assembler::operands::getint(resolveregister(a_chnk, names)), assembler::operands::getint(resolveregister(b_chnk, names)));
+                break;
+            }
+            case FTOI: {
+                string a_chnk, b_chnk;
+                tie(a_chnk, b_chnk) = assembler::operands::get2(operands);
+                if (b_chnk.size() == 0) { b_chnk = a_chnk; }
+                program.ftoi(assembler::operands::getint(resolveregister(a_chnk, names)), assembler::operands::getint(resolveregister(b_chnk, names)));
+                break;
+            }
+            case STOI: {
+                string a_chnk, b_chnk;
+                tie(a_chnk, b_chnk) = assembler::operands::get2(operands);
+                if (b_chnk.size() == 0) { b_chnk = a_chnk; }
+                program.stoi(assembler::operands::getint(resolveregister(a_chnk, names)), assembler::operands::getint(resolveregister(b_chnk, names)));
+                break;
+            }
+            case STOF: {
+                string a_chnk, b_chnk;
+                tie(a_chnk, b_chnk) = assembler::operands::get2(operands);
+                if (b_chnk.size() == 0) { b_chnk = a_chnk; }
+                program.stof(assembler::operands::getint(resolveregister(a_chnk, names)), assembler::operands::getint(resolveregister(b_chnk, names)));
+                break;
+            }
+            case STRSTORE: {
+                string reg_chnk, str_chnk;
+                reg_chnk = str::chunk(operands);
+                operands = str::lstrip(str::sub(operands, reg_chnk.size()));
+                str_chnk = str::extract(operands);
+                program.strstore(assembler::operands::getint(resolveregister(reg_chnk, names)), str_chnk);
+                break;
+            }
+            case VEC: {
+                string regno_chnk;
+                regno_chnk = str::chunk(operands);
+                program.vec(assembler::operands::getint(resolveregister(regno_chnk, names)));
+                break;
+            }
+            case VINSERT: {
+                string vec, src, pos;
+                tie(vec, src, pos) = assembler::operands::get3(operands, false);
+                if (pos == "") { pos = "0"; }
+                program.vinsert(assembler::operands::getint(resolveregister(vec, names)), assembler::operands::getint(resolveregister(src, names)), assembler::operands::getint(resolveregister(pos, names)));
+                break;
+            }
+            case VPUSH: {
+                string regno_chnk, number_chnk;
+                tie(regno_chnk, number_chnk) = assembler::operands::get2(operands);
+                program.vpush(assembler::operands::getint(resolveregister(regno_chnk, names)), assembler::operands::getint(resolveregister(number_chnk, names)));
+                break;
+            }
+            case VPOP: {
+                string vec, dst, pos;
+                tie(vec, dst, pos) = assembler::operands::get3(operands, false);
+                if (dst == "") { dst = "0"; }
+                if (pos == "") { pos = "-1"; }
+                program.vpop(assembler::operands::getint(resolveregister(vec, names)), assembler::operands::getint(resolveregister(dst, names)), assembler::operands::getint(resolveregister(pos, names)));
+                break;
+            }
+            case VAT: {
+                string vec, dst, pos;
+                tie(vec, dst, pos) = assembler::operands::get3(operands, false);
+                if (pos == "") { pos = "-1"; }
+                program.vat(assembler::operands::getint(resolveregister(vec, names)), assembler::operands::getint(resolveregister(dst, names)), assembler::operands::getint(resolveregister(pos, names)));
+                break;
+            }
+            case VLEN: {
+                string regno_chnk, number_chnk;
+                tie(regno_chnk, number_chnk) = assembler::operands::get2(operands);
+                program.vlen(assembler::operands::getint(resolveregister(regno_chnk, names)), assembler::operands::getint(resolveregister(number_chnk, names)));
+                break;
+            }
+            case NOT: {
+                string regno_chnk;
+                regno_chnk = str::chunk(operands);
+                program.lognot(assembler::operands::getint(resolveregister(regno_chnk, names)));
+                break;
+            }
+            case MOVE: {
+                string a_chnk, b_chnk;
+                tie(a_chnk, b_chnk) = assembler::operands::get2(operands);
+                program.move(assembler::operands::getint(resolveregister(a_chnk, names)), assembler::operands::getint(resolveregister(b_chnk, names)));
+                break;
+            }
+            case COPY: {
+                string a_chnk, b_chnk;
+                tie(a_chnk, b_chnk) = assembler::operands::get2(operands);
+                program.copy(assembler::operands::getint(resolveregister(a_chnk, names)), assembler::operands::getint(resolveregister(b_chnk, names)));
+                break;
+            }
+            case REF: {
+                string a_chnk, b_chnk;
+                tie(a_chnk, b_chnk) = assembler::operands::get2(operands);
+                program.ref(assembler::operands::getint(resolveregister(a_chnk, names)), assembler::operands::getint(resolveregister(b_chnk, names)));
+                break;
+            }
+            case SWAP: {
+                string a_chnk, b_chnk;
+                tie(a_chnk, b_chnk) = assembler::operands::get2(operands);
+                program.swap(assembler::operands::getint(resolveregister(a_chnk, names)), assembler::operands::getint(resolveregister(b_chnk, names)));
+                break;
+            }
+            case FREE: {
+                string regno_chnk;
+                regno_chnk = str::chunk(operands);
+                program.free(assembler::operands::getint(resolveregister(regno_chnk, names)));
+                break;
+            }
+            case EMPTY: {
+                string regno_chnk;
+                regno_chnk = str::chunk(operands);
+                program.empty(assembler::operands::getint(resolveregister(regno_chnk, names)));
+                break;
+            }
+            case ISNULL: {
+                string a_chnk, b_chnk;
+                tie(a_chnk, b_chnk) = assembler::operands::get2(operands);
+                program.isnull(assembler::operands::getint(resolveregister(a_chnk, names)), assembler::operands::getint(resolveregister(b_chnk, names)));
+                break;
+            }
+            case RESS:
+                program.ress(operands);
+                break;
+            case TMPRI: {
+                string regno_chnk;
+                regno_chnk = str::chunk(operands);
+                program.tmpri(assembler::operands::getint(resolveregister(regno_chnk, names)));
+                break;
+            }
+            case TMPRO: {
+                string regno_chnk;
+                regno_chnk = str::chunk(operands);
+                program.tmpro(assembler::operands::getint(resolveregister(regno_chnk, names)));
+                break;
+            }
+            case PRINT: {
+                string regno_chnk;
+                regno_chnk = str::chunk(operands);
+                program.print(assembler::operands::getint(resolveregister(regno_chnk, names)));
+                break;
+            }
+            case ECHO: {
+                string regno_chnk;
+                regno_chnk = str::chunk(operands);
+                program.echo(assembler::operands::getint(resolveregister(regno_chnk, names)));
+                break;
+            }
+            case CLBIND: {
+                string regno_chnk;
+                regno_chnk = str::chunk(operands);
+                program.clbind(assembler::operands::getint(resolveregister(regno_chnk, names)));
+                break;
+            }
+            case CLOSURE: {
+                string fn_name, reg;
+                tie(reg, fn_name) = assembler::operands::get2(operands);
+                program.closure(assembler::operands::getint(resolveregister(reg, names)), fn_name);
+                break;
+            }
+            case FUNCTION: {
+                string fn_name, reg;
+                tie(reg, fn_name) = assembler::operands::get2(operands);
+                program.function(assembler::operands::getint(resolveregister(reg, names)), fn_name);
+                break;
+            }
+            case FCALL: {
+                string a_chnk, b_chnk;
+                tie(a_chnk, b_chnk) = assembler::operands::get2(operands);
+                program.fcall(assembler::operands::getint(resolveregister(a_chnk, names)), assembler::operands::getint(resolveregister(b_chnk, names)));
+                break;
+            }
+            case FRAME: {
+                string a_chnk, b_chnk;
+                tie(a_chnk, b_chnk) = assembler::operands::get2(operands);
+                if (a_chnk.size() == 0) { a_chnk = "0"; }
+                if (b_chnk.size() == 0) { b_chnk = "16"; }  // default number of local registers
+                program.frame(assembler::operands::getint(resolveregister(a_chnk, names)), assembler::operands::getint(resolveregister(b_chnk, names)));
+                break;
+            }
+            case PARAM: {
+                string a_chnk, b_chnk;
+                tie(a_chnk, b_chnk) = assembler::operands::get2(operands);
+                program.param(assembler::operands::getint(resolveregister(a_chnk, names)), assembler::operands::getint(resolveregister(b_chnk, names)));
+                break;
+            }
+            case PAREF: {
+                string a_chnk, b_chnk;
+                tie(a_chnk, b_chnk) = assembler::operands::get2(operands);
+                program.paref(assembler::operands::getint(resolveregister(a_chnk, names)), assembler::operands::getint(resolveregister(b_chnk, names)));
+                break;
+            }
+            case ARG: {
+                string a_chnk, b_chnk;
+                tie(a_chnk, b_chnk) = assembler::operands::get2(operands);
+                program.arg(assembler::operands::getint(resolveregister(a_chnk, names)), assembler::operands::getint(resolveregister(b_chnk, names)));
+                break;
+            }
+            case ARGC: {
+                string regno_chnk;
+                regno_chnk = str::chunk(operands);
+                program.argc(assembler::operands::getint(resolveregister(regno_chnk, names)));
+                break;
+            }
+            case CALL: {
+                /** Full form of call instruction has two operands: function name and return value register index.
+                 *  If call is given only one operand - it means it is the instruction index and returned value is discarded.
+                 *  To explicitly state that return value should be discarderd 0 can be supplied as second operand.
+                 */
+                /** Why is the function supplied as a *string* and not direct instruction pointer?
+                 *  That would be faster - c'mon couldn't assembler just calculate offsets and insert them?
+                 *
+                 *  Nope.
+                 *
+                 *  Yes, it *would* be faster if calls were just precalculated jumps.
+                 *  However, by them being strings we get plenty of flexibility, good-quality stack traces, and
+                 *  a place to put plenty of debugging info.
+                 *  All that at a cost of just one map lookup; the overhead is minimal and gains are big.
+                 *  What's not to love?
+                 *
+                 *  Of course, you, my dear reader, are free to take this code (it's GPL after all!) and
+                 *  modify it to suit your particular needs - in that case that would be calculating call jumps
+                 *  at compile time and exchanging CALL instructions with JUMP instructions.
+                 *
+                 *  Good luck with debugging your code, then.
+                 */
+                string fn_name, reg;
+                tie(reg, fn_name) = assembler::operands::get2(operands);
+
+                // if second operand is empty, fill it with zero
+                // which means that return value will be discarded
+                if (fn_name == "") {
+                    fn_name = reg;
+                    reg = "0";
                 }
-                cout << ": " << addrt_target << endl;
 
-                if (addrf_jump_type == JMP_TO_BYTE) {
-                    cout << line << " => false jump to byte";
-                } else if (addrf_jump_type == JMP_ABSOLUTE) {
-                    cout << line << " => false absolute jump";
+                program.call(assembler::operands::getint(resolveregister(reg, names)), fn_name);
+                break;
+            }
+            case TAILCALL: {
+                program.tailcall(str::chunk(operands));
+                break;
+            }
+            case SPAWN: {
+                program.spawn(str::chunk(operands));
+                break;
+            }
+            case COROUTINE: {
+                string fn_name, reg;
+                tie(reg, fn_name) = assembler::operands::get2(operands);
+                program.coroutine(assembler::operands::getint(resolveregister(reg, names)), fn_name);
+                break;
+            }
+            case RESUME: {
+                string a_chnk, b_chnk;
+                tie(a_chnk, b_chnk) = assembler::operands::get2(operands);
+                program.resume(assembler::operands::getint(resolveregister(a_chnk, names)), assembler::operands::getint(resolveregister(b_chnk, names)));
+                break;
+            }
+            case WAIT: {
+                string a_chnk, b_chnk;
+                tie(a_chnk, b_chnk) = assembler::operands::get2(operands);
+                program.wait(assembler::operands::getint(resolveregister(a_chnk, names)), assembler::operands::getint(resolveregister(b_chnk, names)));
+                break;
+            }
+            case YIELD: {
+                string regno_chnk;
+                regno_chnk = str::chunk(operands);
+                program.yield(assembler::operands::getint(resolveregister(regno_chnk, names)));
+                break;
+            }
+            case BRANCH: {
+                /*  If branch is given three operands, it means its full, three-operands form is being used.
+                 *  Otherwise, it is short, two-operands form instruction and assembler should fill third operand accordingly.
+                 *
+                 *  In case of short-form `branch` instruction:
+                 *
+                 *      * first operand is index of the register to check,
+                 *      * second operand is the address to which to jump if register is true,
+                 *      * third operand is assumed to be the *next instruction*, i.e. instruction after the branch instruction,
+                 *
+                 *  In full (with three operands) form of `branch` instruction:
+                 *
+                 *      * third operands is the address to which to jump if register is false,
+                 */
+                string condition, if_true, if_false;
+                tie(condition, if_true, if_false) = assembler::operands::get3(operands, false);
+
+                int addrt_target, addrf_target;
+                enum JUMPTYPE addrt_jump_type, addrf_jump_type;
+                tie(addrt_target, addrt_jump_type) = resolvejump(if_true, marks, i);
+                if (if_false != "") {
+                    tie(addrf_target, addrf_jump_type) = resolvejump(if_false, marks, i);
                 } else {
-                    cout << line << " => false relative jump";
+                    addrf_jump_type = JMP_RELATIVE;
+                    addrf_target = instruction+1;
                 }
-                cout << ": " << addrf_target << endl;
-            }
 
-            program.branch(assembler::operands::getint(resolveregister(condition, names)), addrt_target, addrt_jump_type, addrf_target, addrf_jump_type);
-        } else if (str::startswith(line, "jump")) {
-            /*  Jump instruction can be written in two forms:
-             *
-             *      * `jump <index>`
-             *      * `jump :<marker>`
-             *
-             *  Assembler must distinguish between these two forms, and so it does.
-             *  Here, we use a function from string support lib to determine
-             *  if the jump is numeric, and thus an index, or
-             *  a string - in which case we consider it a marker jump.
-             *
-             *  If it is a marker jump, assembler will look the marker up in a map and
-             *  if it is not found throw an exception about unrecognised marker being used.
-             */
-            int jump_target;
-            enum JUMPTYPE jump_type;
-            tie(jump_target, jump_type) = resolvejump(operands, marks, i);
+                if (DEBUG) {
+                    if (addrt_jump_type == JMP_TO_BYTE) {
+                        cout << line << " => truth jump to byte";
+                    } else if (addrt_jump_type == JMP_ABSOLUTE) {
+                        cout << line << " => truth absolute jump";
+                    } else {
+                        cout << line << " => truth relative jump";
+                    }
+                    cout << ": " << addrt_target << endl;
+
+                    if (addrf_jump_type == JMP_TO_BYTE) {
+                        cout << line << " => false jump to byte";
+                    } else if (addrf_jump_type == JMP_ABSOLUTE) {
+                        cout << line << " => false absolute jump";
+                    } else {
+                        cout << line << " => false relative jump";
+                    }
+                    cout << ": " << addrf_target << endl;
+                }
 
-            if (DEBUG) {
-                if (jump_type == JMP_TO_BYTE) {
-                    cout << line << " => false jump to byte";
-                } else if (jump_type == JMP_ABSOLUTE) {
-                    cout << line << " => false absolute jump";
-                } else {
-                    cout << line << " => false relative jump";
+                program.branch(assembler::operands::getint(resolveregister(condition, names)), addrt_target, addrt_jump_type, addrf_target, addrf_jump_type);
+                break;
+            }
+            case JUMP: {
+                /*  Jump instruction can be written in two forms:
+                 *
+                 *      * `jump <index>`
+                 *      * `jump :<marker>`
+                 *
+                 *  Assembler must distinguish between these two forms, and so it does.
+                 *  Here, we use a function from string support lib to determine
+                 *  if the jump is numeric, and thus an index, or
+                 *  a string - in which case we consider it a marker jump.
+                 *
+                 *  If it is a marker jump, assembler will look the marker up in a map and
+                 *  if it is not found throw an exception about unrecognised marker being used.
+                 */
+                int jump_target;
+                enum JUMPTYPE jump_type;
+                tie(jump_target, jump_type) = resolvejump(operands, marks, i);
+
+                if (DEBUG) {
+                    if (jump_type == JMP_TO_BYTE) {
+                        cout << line << " => false jump to byte";
+                    } else if (jump_type == JMP_ABSOLUTE) {
+                        cout << line << " => false absolute jump";
+                    } else {
+                        cout << line << " => false relative jump";
+                    }
+                    cout << ": " << jump_target << endl;
                 }
-                cout << ": " << jump_target << endl;
-            }
-
-            program.jump(jump_target, jump_type);
-        } else if (str::startswith(line, "try")) {
-            program.vmtry();
-        } else if (str::startswith(line, "catch")) {
-            string type_chnk, catcher_chnk;
-            type_chnk = str::extract(operands);
-            operands = str::lstrip(str::sub(operands, type_chnk.size()));
-            catcher_chnk = str::chunk(operands);
-            program.vmcatch(type_chnk, catcher_chnk);
-        } else if (str::startswith(line, "pull")) {
-            string regno_chnk;
-            regno_chnk = str::chunk(operands);
-            program.pull(assembler::operands::getint(resolveregister(regno_chnk, names)));
-        } else if (str::startswith(line, "enter")) {
-            string block_name = str::chunk(operands);
-            program.vmenter(block_name);
-        } else if (str::startswith(line, "throw")) {
-            string regno_chnk;
-            regno_chnk = str::chunk(operands);
-            program.vmthrow(assembler::operands::getint(resolveregister(regno_chnk, names)));
-        } else if (str::startswith(line, "leave")) {
-            program.leave();
-        } else if (str::startswith(line, "import")) {
-            string str_chnk;
-            str_chnk = str::extract(operands);
-            program.import(str_chnk);
-        } else if (str::startswith(line, "link")) {
-            string str_chnk;
-            str_chnk = str::chunk(operands);
-            program.link(str_chnk);
-        } else if (str::startswith(line, "class")) {
-            string class_name, reg;
-            tie(reg, class_name) = assembler::operands::get2(operands);
-            program.vmclass(assembler::operands::getint(resolveregister(reg, names)), class_name);
-        } else if (str::startswith(line, "derive")) {
-            string base_class_name, reg;
-            tie(reg, base_class_name) = assembler::operands::get2(operands);
-            program.vmderive(assembler::operands::getint(resolveregister(reg, names)), base_class_name);
-        } else if (str::startswith(line, "attach")) {
-            string function_name, method_name, reg;
-            tie(reg, function_name, method_name) = assembler::operands::get3(operands);
-            program.vmattach(assembler::operands::getint(resolveregister(reg, names)), function_name, method_name);
-        } else if (str::startswith(line, "register")) {
-            string regno_chnk;
-            regno_chnk = str::chunk(operands);
-            program.vmregister(assembler::operands::getint(resolveregister(regno_chnk, names)));
-        } else if (str::startswith(line, "new")) {
-            string class_name, reg;
-            tie(reg, class_name) = assembler::operands::get2(operands);
-            program.vmnew(assembler::operands::getint(resolveregister(reg, names)), class_name);
-        } else if (str::startswith(line, "msg")) {
-            string reg, mtd;
-            tie(reg, mtd) = assembler::operands::get2(operands);
-            program.vmmsg(assembler::operands::getint(resolveregister(reg, names)), mtd);
-        } else if (str::startswith(line, "end")) {
-            program.end();
-        } else if (str::startswith(line, "halt")) {
-            program.halt();
-        } else {
-            throw ("unimplemented instruction: " + instr);
+
+                program.jump(jump_target, jump_type);
+                break;
+            }
+            case TRY:
+                program.vmtry();
+                break;
+            case CATCH: {
+                string type_chnk, catcher_chnk;
+                type_chnk = str::extract(operands);
+                operands = str::lstrip(str::sub(operands, type_chnk.size()));
+                catcher_chnk = str::chunk(operands);
+                program.vmcatch(type_chnk, catcher_chnk);
+                break;
+            }
+            case PULL: {
+                string regno_chnk;
+                regno_chnk = str::chunk(operands);
+                program.pull(assembler::operands::getint(resolveregister(regno_chnk, names)));
+                break;
+            }
+            case ENTER: {
+                string block_name = str::chunk(operands);
+                program.vmenter(block_name);
+                break;
+            }
+            case THROW: {
+                string regno_chnk;
+                regno_chnk = str::chunk(operands);
+                program.vmthrow(assembler::operands::getint(resolveregister(regno_chnk, names)));
+                break;
+            }
+            case LEAVE:
+                program.leave();
+                break;
+            case IMPORT: {
+                string str_chnk;
+                str_chnk = str::extract(operands);
+                program.import(str_chnk);
+                break;
+            }
+            case LINK: {
+                string str_chnk;
+                str_chnk = str::chunk(operands);
+                program.link(str_chnk);
+                break;
+            }
+            case CLASS: {
+                string class_name, reg;
+                tie(reg, class_name) = assembler::operands::get2(operands);
+                program.vmclass(assembler::operands::getint(resolveregister(reg, names)), class_name);
+                break;
+            }
+            case DERIVE: {
+                string base_class_name, reg;
+                tie(reg, base_class_name) = assembler::operands::get2(operands);
+                program.vmderive(assembler::operands::getint(resolveregister(reg, names)), base_class_name);
+                break;
+            }
+            case ATTACH: {
+                string function_name, method_name, reg;
+                tie(reg, function_name, method_name) = assembler::operands::get3(operands);
+                program.vmattach(assembler::operands::getint(resolveregister(reg, names)), function_name, method_name);
+                break;
+            }
+            case REGISTER: {
+                string regno_chnk;
+                regno_chnk = str::chunk(operands);
+                program.vmregister(assembler::operands::getint(resolveregister(regno_chnk, names)));
+                break;
+            }
+            case NEW: {
+                string class_name, reg;
+                tie(reg, class_name) = assembler::operands::get2(operands);
+                program.vmnew(assembler::operands::getint(resolveregister(reg, names)), class_name);
+                break;
+            }
+            case MSG: {
+                string reg, mtd;
+                tie(reg, mtd) = assembler::operands::get2(operands);
+                program.vmmsg(assembler::operands::getint(resolveregister(reg, names)), mtd);
+                break;
+            }
+            case END:
+                program.end();
+                break;
+            case HALT:
+                program.halt();
+                break;
+            case IADD:
+            case ISUB:
+            case IMUL:
+            case IDIV:
+            case ILT:
+            case ILTE:
+            case IGT:
+            case IGTE:
+            case IEQ:
+            case TIADD:
+            case TISUB:
+            case TIMUL:
+            case TIDIV:
+            case TILT:
+            case TILTE:
+            case TIGT:
+            case TIGTE:
+            case TIEQ:
+            case FADD:
+            case FSUB:
+            case FMUL:
+            case FDIV:
+            case FLT:
+            case FLTE:
+            case FGT:
+            case FGTE:
+            case FEQ:
+            case AND:
+            case OR:
+                assemble_three_intop_instruction(program, names, instr, operands);
+                break;
+            default:
+                throw ("unimplemented instruction: " + instr);
         }
         ++instruction;
     }
@@ -630,8 +782,8 @@ void assemble(Program& program, const vector<string>& lines) {
 }
 
 
-map<string, uint16_t> mapInvokableAddresses(uint16_t& starting_instruction, const vector<string>& names, const map<string, vector<string> >& sources) {
-    map<string, uint16_t> addresses;
+map<string, uint32_t> mapInvokableAddresses(uint32_t& starting_instruction, const vector<string>& names, const map<string, vector<string> >& sources) {
+    map<string, uint32_t> addresses;
     for (string name : names) {
         addresses[name] = starting_instruction;
         try {
@@ -686,10 +838,171 @@ vector<string> expandSource(const vector<string>& lines, map<unsigned, unsigned>
     return asm_lines;
 }
 
+bool fetchCachedInvocable(const compilationflags_t& flags, const vector<string>& lines, Program& program, vector<unsigned>& jumps, vector<unsigned>& jumps_absolute) {
+    /** Fetch bytecode of a function (or block) from compilation cache.
+     *
+     *  Cached bytecode is stored before jumps are calculated so it does not depend on
+     *  the offset at which the function is placed in the module.
+     *  Cache entry layout is:
+     *
+     *      <size> <bytecode> <number of jumps> <jumps...> <number of absolute jumps> <absolute jumps...>
+     *
+     *  with all numbers stored as unsigned integers.
+     */
+    if (not flags.cache_functions) {
+        return false;
+    }
+
+    vector<string> key_parts = {"invocable"};
+    key_parts.insert(key_parts.end(), lines.begin(), lines.end());
+
+    string blob;
+    if (not cache::fetch(flags.cache, cache::key(key_parts), blob)) {
+        return false;
+    }
+
+    const char* ptr = blob.c_str();
+    const char* blob_end = ptr+blob.size();
+
+    unsigned size = 0;
+    if (ptr+sizeof(unsigned) > blob_end) { return false; }
+    size = *((unsigned*)ptr);
+    ptr += sizeof(unsigned);
+    if (int(size) != program.size() or ptr+size > blob_end) { return false; }
+    const char* code = ptr;
+    ptr += size;
+
+    vector<unsigned> cached_jumps[2];
+    for (unsigned i = 0; i < 2; ++i) {
+        if (ptr+sizeof(unsigned) > blob_end) { return false; }
+        unsigned count = *((unsigned*)ptr);
+        ptr += sizeof(unsigned);
+        if (ptr+(count*sizeof(unsigned)) > blob_end) { return false; }
+        for (unsigned j = 0; j < count; ++j) {
+            cached_jumps[i].push_back(*((unsigned*)ptr));
+            ptr += sizeof(unsigned);
+        }
+    }
+
+    byte* bytecode = new byte[size];
+    for (unsigned i = 0; i < size; ++i) {
+        bytecode[i] = byte(code[i]);
+    }
+    program.fill(bytecode);
+    jumps = cached_jumps[0];
+    jumps_absolute = cached_jumps[1];
+
+    return true;
+}
+
+void storeCachedInvocable(const compilationflags_t& flags, const vector<string>& lines, Program& program, const vector<unsigned>& jumps, const vector<unsigned>& jumps_absolute) {
+    /** Store bytecode of a function (or block) in compilation cache.
+     *
+     *  Must be called before jumps are calculated.
+     */
+    if (not flags.cache_functions) {
+        return;
+    }
+
+    vector<string> key_parts = {"invocable"};
+    key_parts.insert(key_parts.end(), lines.begin(), lines.end());
+
+    string blob;
+    unsigned size = unsigned(program.size());
+    blob.append((const char*)&size, sizeof(unsigned));
+
+    byte* bytecode = program.bytecode();
+    blob.append((const char*)bytecode, size);
+    delete[] bytecode;
+
+    for (const vector<unsigned>* jmps : {&jumps, &jumps_absolute}) {
+        unsigned count = unsigned(jmps->size());
+        blob.append((const char*)&count, sizeof(unsigned));
+        for (unsigned jmp : *jmps) {
+            blob.append((const char*)&jmp, sizeof(unsigned));
+        }
+    }
+
+    cache::store(flags.cache, cache::key(key_parts), blob);
+}
+
+struct invocablebytecode_t {
+    // whether size of the invocable was calculated
+    bool counted;
+    // whether the bytecode was fetched from compilation cache
+    bool cached;
+    int size;
+    byte* bytecode;
+    vector<unsigned> jumps;
+    vector<unsigned> jumps_absolute;
+    // message describing why bytecode could not be generated, empty on success
+    string error;
+};
+
+invocablebytecode_t assembleInvocable(const compilationflags_t& flags, const string& kind, const string& name, const vector<string>& body) {
+    /** Generate bytecode of a single function or block.
+     *
+     *  Relative jumps are calculated as if the invocable was placed at the beginning of the module
+     *  and must be offset when the bytecode is placed in the module.
+     *  Errors are not reported but returned, so that they are reported in the same order as
+     *  when invocables are assembled one after another.
+     *
+     *  This function does not modify any shared state so it may be
+     *  run for different invocables on several threads at once.
+     */
+    invocablebytecode_t result = {false, false, 0, nullptr, {}, {}, ""};
+
+    uint32_t fun_bytes = 0;
+    try {
+        fun_bytes = Program::countBytes(name == ENTRY_FUNCTION_NAME ? filter(body) : body);
+    } catch (const string& e) {
+        result.error = "fatal: error during " + kind + " size count (pre-assembling): " + e;
+        return result;
+    } catch (const std::out_of_range& e) {
+        result.error = e.what();
+        return result;
+    }
+    result.counted = true;
+    result.size = int(fun_bytes);
+
+    Program func(result.size);
+    func.setdebug(flags.debug).setscream(flags.scream);
+    if (fetchCachedInvocable(flags, body, func, result.jumps, result.jumps_absolute)) {
+        result.cached = true;
+    } else {
+        string prefix = (flags.debug ? "\n" : "");
+        try {
+            assemble(func, body);
+        } catch (const string& e) {
+            result.error = prefix + "fatal: error during assembling: " + e;
+            return result;
+        } catch (const char*& e) {
+            result.error = prefix + "fatal: error during assembling: " + e;
+            return result;
+        } catch (const std::out_of_range& e) {
+            result.error = prefix + "[asm] fatal: could not assemble " + kind + " '" + name + "' (" + e.what() + ')';
+            return result;
+        }
+
+        result.jumps = func.jumps();
+        result.jumps_absolute = func.jumpsAbsolute();
+        storeCachedInvocable(flags, body, func, result.jumps, result.jumps_absolute);
+    }
+
+    vector<tuple<int, int> > local_jumps;
+    for (unsigned jmp : result.jumps) {
+        local_jumps.push_back(tuple<int, int>(jmp, 0));
+    }
+    func.calculateJumps(local_jumps);
+
+    result.bytecode = func.bytecode();
+    return result;
+}
+
 int generate(const vector<string>& expanded_lines, const map<unsigned, unsigned>& expanded_lines_to_source_lines, vector<string>& ilines, invocables_t& functions, invocables_t& blocks, string& filename, string& compilename, const vector<string>& commandline_given_links, const compilationflags_t& flags) {
     //////////////////////////////
     // SETUP INITIAL BYTECODE SIZE
-    uint16_t bytes = 0;
+    uint32_t bytes = 0;
 
 
     /////////////////////////
@@ -740,17 +1053,164 @@ int generate(const vector<string>& expanded_lines, const map<unsigned, unsigned>
     }
 
 
+    ///////////////////////
+    // LOAD LINKED MODULES
+    vector<string> links = assembler::ce::getlinks(ilines);
+    for (string lnk : commandline_given_links) {
+        if (find(links.begin(), links.end(), lnk) == links.end()) {
+            links.push_back(lnk);
+        }
+    }
+
+    vector<linkedmodule_t> linked_modules;
+    for (string lnk : links) {
+        if (DEBUG or VERBOSE) {
+            cout << "[loader] message: linking with: '" << lnk << "\'" << endl;
+        }
+
+        Loader loader(lnk);
+        loader.load();
+
+        linkedmodule_t module;
+        module.path = lnk;
+        module.size = loader.getBytecodeSize();
+        module.bytecode = loader.getBytecode();
+        module.jumps = loader.getJumps();
+        module.functions = loader.getFunctions();
+        module.function_addresses = loader.getFunctionAddresses();
+        module.function_registers = loader.getFunctionRegisters();
+        module.block_addresses = loader.getBlockAddresses();
+        linked_modules.push_back(module);
+    }
+
+
+    //////////////////////////////////////////////
+    // CHECK IF NO FUNCTION IS DEFINED MORE THAN ONCE
+    map<string, string> function_modules;
+    for (string name : functions.names) {
+        function_modules[name] = filename;
+    }
+    for (const linkedmodule_t& module : linked_modules) {
+        for (string name : module.functions) {
+            if (function_modules.count(name)) {
+                cout << "fatal: function '" << name << "' is defined in both '" << function_modules.at(name) << "' and '" << module.path << "'" << endl;
+                return 1;
+            }
+            function_modules[name] = module.path;
+        }
+    }
+
+
+    ///////////////////////////////////
+    // INLINE CALLS TO SMALL FUNCTIONS
+    if (flags.optimize > 1 and not flags.as_lib) {
+        unsigned inlined = inliner::expand(functions, blocks, ilines, flags.inline_limit, flags.inline_growth);
+        if (VERBOSE or DEBUG) {
+            cout << "message: inlined " << inlined << " call(s)" << endl;
+        }
+    }
+
+
+    ///////////////////////////////////////////
+    // OPTIMIZE FUNCTIONS IN SSA FORM
+    if (flags.optimize > 1 and not flags.as_lib) {
+        ir::report_t report = ir::optimize(functions, flags.as_lib);
+        if (VERBOSE or DEBUG) {
+            cout << "message: constant propagation: folded " << report.folded << " instruction(s)" << endl;
+            cout << "message: copy propagation: replaced " << report.propagated << " operand(s)" << endl;
+            cout << "message: dead code elimination: removed " << report.eliminated << " instruction(s)" << endl;
+        }
+    }
+
+
+    ////////////////////////////
+    // ELIMINATE UNREACHABLE CODE
+    vector<string> eliminated_functions;
+    if (flags.optimize > 0 and not flags.as_lib) {
+        reachability::report_t eliminated = reachability::eliminate(functions, blocks, filter(ilines), main_function, flags.keep, linked_modules);
+        eliminated_functions = eliminated.functions;
+        if (VERBOSE or DEBUG) {
+            cout << "message: unreachable code elimination: removed " << eliminated.functions.size() << " function(s) and " << eliminated.blocks.size() << " block(s)" << endl;
+            cout << "message: unreachable code elimination: bytecode size " << eliminated.bytes_before << " -> " << eliminated.bytes_after << " bytes" << endl;
+        }
+    }
+
+
+    ///////////////////////////////
+    // OPTIMIZE FUNCTIONS AND BLOCKS
+    if (flags.optimize > 0) {
+        map<string, unsigned> rewrites = peephole::optimize(functions, blocks, flags.as_lib);
+        if (VERBOSE or DEBUG) {
+            for (const string& rule : peephole::rules()) {
+                cout << "message: peephole rule " << rule << ": " << rewrites.at(rule) << " rewrite(s)" << endl;
+            }
+        }
+    }
+
+
+    ////////////////////////////////////////////////
+    // SPECIALIZE INSTRUCTIONS FOR INFERRED TYPES
+    if (flags.optimize > 1 and not flags.as_lib) {
+        unsigned specialized = typeinference::specialize(functions, flags.as_lib);
+        if (VERBOSE or DEBUG) {
+            cout << "message: type inference: specialized " << specialized << " instruction(s)" << endl;
+        }
+    }
+
+
+    ////////////////////////////////////////////////
+    // COMPUTE REGISTER SET SIZES REQUIRED BY FUNCTIONS
+    map<string, unsigned> function_registers;
+    if (flags.optimize > 0) {
+        unsigned renumbered = liveness::renumber(functions, flags.as_lib);
+        if (VERBOSE or DEBUG) {
+            cout << "message: registers renumbered in " << renumbered << " function(s)" << endl;
+        }
+    }
+    function_registers = liveness::registers(functions, blocks);
+    if (flags.optimize > 0) {
+        unsigned shrunk = liveness::frames(functions, blocks, function_registers);
+        if (VERBOSE or DEBUG) {
+            cout << "message: frames shrunk: " << shrunk << endl;
+        }
+    }
+    if (DEBUG) {
+        for (auto fn : function_registers) {
+            cout << "debug: function '" << fn.first << "' requires " << fn.second << " local register(s)" << endl;
+        }
+    }
+
+
+    /////////////////////////////////////////
+    // LAY OUT FUNCTIONS AND BLOCKS BY PROFILE
+    if (flags.profile_use.size()) {
+        layout::profile_t profile;
+        if (not layout::load(flags.profile_use, profile)) {
+            cout << "fatal: could not read profile: " << flags.profile_use << endl;
+            return 1;
+        }
+        layout::report_t arranged = layout::arrange(functions, blocks, profile);
+        if (not arranged.arranged) {
+            cout << "warning: functions and blocks are laid out in source order: " << arranged.reason << endl;
+        } else if (VERBOSE or DEBUG) {
+            cout << "message: profile-guided layout: " << arranged.hot_functions << " hot function(s) and " << arranged.hot_blocks << " hot block(s)" << endl;
+        }
+    }
+
+
     /////////////////////////////////
     // MAP FUNCTIONS TO ADDRESSES AND
     // MAP blocks.bodies TO ADDRESSES AND
     // SET STARTING INSTRUCTION
-    uint16_t starting_instruction = 0;  // the bytecode offset to first executable instruction
-    map<string, uint16_t> function_addresses;
-    map<string, uint16_t> block_addresses;
+    uint32_t starting_instruction = 0;  // the bytecode offset to first executable instruction
+    map<string, uint32_t> function_addresses;
+    map<string, uint32_t> block_addresses;
     try {
         block_addresses = mapInvokableAddresses(starting_instruction, blocks.names, blocks.bodies);
         function_addresses = mapInvokableAddresses(starting_instruction, functions.names, functions.bodies);
-        bytes = Program::countBytes(ilines);
+        // bodies of functions and blocks may have been changed by optimizations so
+        // they are counted separately from the entry function
+        bytes = starting_instruction + Program::countBytes(filter(ilines));
     } catch (const string& e) {
         cout << "error: bytecode size calculation failed: " << e << endl;
         return 1;
@@ -768,7 +1228,12 @@ int generate(const vector<string>& expanded_lines, const map<unsigned, unsigned>
         // entry function sets global stuff (FIXME: not really)
         ilines.insert(ilines.begin(), "ress local");
         // append entry function instructions...
-        ilines.push_back("frame 1");
+        // main function may require more registers than the default frame provides (e.g. after inlining)
+        if (function_registers.count(main_function) and function_registers.at(main_function) > 16) {
+            ilines.push_back("frame 1 " + to_string(function_registers.at(main_function)));
+        } else {
+            ilines.push_back("frame 1");
+        }
         ilines.push_back("param 0 1");
         // this must not be hardcoded because we have '.main:' assembler instruction
         // we also save return value in 1 register since 0 means "drop return value"
@@ -790,49 +1255,37 @@ int generate(const vector<string>& expanded_lines, const map<unsigned, unsigned>
 
     /////////////////////////////////////////////////////////
     // GATHER LINKS, GET THEIR SIZES AND ADJUST BYTECODE SIZE
-    vector<string> links = assembler::ce::getlinks(ilines);
-    vector<tuple<string, uint16_t, char*> > linked_libs_bytecode;
+    vector<tuple<string, uint32_t, char*> > linked_libs_bytecode;
     vector<string> linked_function_names;
     vector<string> linked_block_names;
     map<string, vector<unsigned> > linked_libs_jumptables;
-    uint16_t current_link_offset = bytes;
-
-    for (string lnk : commandline_given_links) {
-        if (find(links.begin(), links.end(), lnk) == links.end()) {
-            links.push_back(lnk);
-        }
-    }
-
-    for (string lnk : links) {
-        if (DEBUG or VERBOSE) {
-            cout << "[loader] message: linking with: '" << lnk << "\'" << endl;
-        }
-
-        Loader loader(lnk);
-        loader.load();
+    uint32_t current_link_offset = bytes;
 
-        vector<unsigned> lib_jumps = loader.getJumps();
+    for (const linkedmodule_t& module : linked_modules) {
         if (DEBUG) {
-            cout << "[loader] entries in jump table: " << lib_jumps.size() << endl;
-            for (unsigned i = 0; i < lib_jumps.size(); ++i) {
-                cout << "  jump at byte: " << lib_jumps[i] << endl;
+            cout << "[loader] entries in jump table: " << module.jumps.size() << endl;
+            for (unsigned i = 0; i < module.jumps.size(); ++i) {
+                cout << "  jump at byte: " << module.jumps[i] << endl;
             }
         }
 
-        linked_libs_jumptables[lnk] = lib_jumps;
+        linked_libs_jumptables[module.path] = module.jumps;
 
-        map<string, uint16_t> fn_addresses = loader.getFunctionAddresses();
-        vector<string> fn_names = loader.getFunctions();
-        for (string fn : fn_names) {
-            function_addresses[fn] = fn_addresses.at(fn) + current_link_offset;
+        // each module is written right after the previous one
+        for (string fn : module.functions) {
+            function_addresses[fn] = module.function_addresses.at(fn) + bytes;
             linked_function_names.push_back(fn);
             if (DEBUG) {
-                cout << "  \"" << fn << "\": entry point at byte: " << current_link_offset << '+' << fn_addresses.at(fn) << endl;
+                cout << "  \"" << fn << "\": entry point at byte: " << bytes << '+' << module.function_addresses.at(fn) << endl;
             }
         }
 
-        linked_libs_bytecode.push_back( tuple<string, uint16_t, char*>(lnk, loader.getBytecodeSize(), loader.getBytecode()) );
-        bytes += loader.getBytecodeSize();
+        for (auto fn : module.function_registers) {
+            function_registers[fn.first] = fn.second;
+        }
+
+        linked_libs_bytecode.push_back( tuple<string, uint32_t, char*>(module.path, module.size, module.bytecode) );
+        bytes += module.size;
     }
 
 
@@ -844,12 +1297,15 @@ int generate(const vector<string>& expanded_lines, const map<unsigned, unsigned>
     /////////////////////////////////////////////////////////////////////////
     // AFTER HAVING OBTAINED LINKED NAMES, IT IS POSSIBLE TO VERIFY CALLS AND
     // CALLABLE (FUNCTIONS, CLOSURES, ETC.) CREATIONS
+    // functions removed as unreachable are still defined (and can be referenced by other unreachable code)
+    vector<string> defined_function_names = functions.names;
+    defined_function_names.insert(defined_function_names.end(), eliminated_functions.begin(), eliminated_functions.end());
     string report;
-    if ((report = assembler::verify::functionCallsAreDefined(expanded_lines, expanded_lines_to_source_lines, functions.names, functions.signatures)).size()) {
+    if ((report = assembler::verify::functionCallsAreDefined(expanded_lines, expanded_lines_to_source_lines, defined_function_names, functions.signatures)).size()) {
         cout << report << endl;
         exit(1);
     }
-    if ((report = assembler::verify::callableCreations(expanded_lines, expanded_lines_to_source_lines, functions.names, functions.signatures)).size()) {
+    if ((report = assembler::verify::callableCreations(expanded_lines, expanded_lines_to_source_lines, defined_function_names, functions.signatures)).size()) {
         cout << report << endl;
         exit(1);
     }
@@ -890,152 +1346,100 @@ int generate(const vector<string>& expanded_lines, const map<unsigned, unsigned>
     // THIS MUST BE GENERATED HERE TO OBTAIN FILL JUMP TABLE
     map<string, tuple<int, byte*> > functions_bytecode;
     map<string, tuple<int, byte*> > block_bodies_bytecode;
-    int functions_section_size = 0;
-    int block_bodies_section_size = 0;
+    int bytecode_size_so_far = 0;
 
     vector<tuple<int, int> > jump_positions;
 
+    // blocks come first, then functions
+    vector<tuple<bool, string> > invocables;
     for (string name : blocks.names) {
         // do not generate bytecode for blocks.bodies that were linked
         if (find(linked_block_names.begin(), linked_block_names.end(), name) != linked_block_names.end()) { continue; }
+        invocables.push_back(tuple<bool, string>(true, name));
+    }
+    for (string name : functions.names) {
+        // do not generate bytecode for functions that were linked
+        if (find(linked_function_names.begin(), linked_function_names.end(), name) != linked_function_names.end()) { continue; }
+        invocables.push_back(tuple<bool, string>(false, name));
+    }
+
+    vector<invocablebytecode_t> generated(invocables.size());
+    auto generateInvocable = [&](unsigned i) {
+        bool is_block = get<0>(invocables[i]);
+        const string& name = get<1>(invocables[i]);
+        generated[i] = assembleInvocable(flags, (is_block ? "block" : "function"), name, (is_block ? blocks : functions).bodies.at(name));
+    };
+    auto placeInvocable = [&](unsigned i) {
+        /*  Bytecode of invocables is placed in the module in order, so
+         *  the output does not depend on the order in which it was generated.
+         */
+        bool is_block = get<0>(invocables[i]);
+        const string& name = get<1>(invocables[i]);
+        invocablebytecode_t& result = generated[i];
 
         if (VERBOSE or DEBUG) {
-            cout << "[asm] message: generating bytecode for block \"" << name << '"';
-        }
-        uint16_t fun_bytes = 0;
-        try {
-            fun_bytes = Program::countBytes(blocks.bodies.at(name));
-            if (VERBOSE or DEBUG) {
-                cout << " (" << fun_bytes << " bytes at byte " << block_bodies_section_size << ')' << endl;
+            cout << "[asm] message: generating bytecode for " << (is_block ? "block" : "function") << " \"" << name << '"';
+            if (result.counted) {
+                cout << " (" << result.size << " bytes at byte " << bytecode_size_so_far << ')' << endl;
             }
-        } catch (const string& e) {
-            cout << "fatal: error during block size count (pre-assembling): " << e << endl;
-            exit(1);
-        } catch (const std::out_of_range& e) {
-            cout << e.what() << endl;
-            exit(1);
         }
-
-        Program func(fun_bytes);
-        func.setdebug(DEBUG).setscream(SCREAM);
-        try {
-            assemble(func, blocks.bodies.at(name));
-        } catch (const string& e) {
-            cout << (DEBUG ? "\n" : "") << "fatal: error during assembling: " << e << endl;
-            exit(1);
-        } catch (const char*& e) {
-            cout << (DEBUG ? "\n" : "") << "fatal: error during assembling: " << e << endl;
-            exit(1);
-        } catch (const std::out_of_range& e) {
-            cout << (DEBUG ? "\n" : "") << "[asm] fatal: could not assemble block '" << name << "' (" << e.what() << ')' << endl;
+        if (result.error.size()) {
+            cout << result.error << endl;
             exit(1);
         }
-
-        vector<unsigned> jumps = func.jumps();
-        vector<unsigned> jumps_absolute = func.jumpsAbsolute();
-
-        vector<tuple<int, int> > local_jumps;
-        for (unsigned i = 0; i < jumps.size(); ++i) {
-            unsigned jmp = jumps[i];
-            local_jumps.push_back(tuple<int, int>(jmp, block_bodies_section_size));
+        if ((VERBOSE or DEBUG) and result.cached) {
+            cout << "[asm] message: using cached bytecode for " << (is_block ? "block" : "function") << " \"" << name << '"' << endl;
         }
-        func.calculateJumps(local_jumps);
 
-        byte* btcode = func.bytecode();
+        // relative jumps were calculated as if the invocable was placed at the beginning of the module
+        for (unsigned jmp : result.jumps) {
+            *((int*)(result.bytecode+jmp)) += bytecode_size_so_far;
+        }
 
         // store generated bytecode fragment for future use (we must not yet write it to the file to conform to bytecode format)
-        block_bodies_bytecode[name] = tuple<int, byte*>(func.size(), btcode);
+        (is_block ? block_bodies_bytecode : functions_bytecode)[name] = tuple<int, byte*>(result.size, result.bytecode);
 
-        // extend jump table with jumps from current block
-        for (unsigned i = 0; i < jumps.size(); ++i) {
-            unsigned jmp = jumps[i];
+        // extend jump table with jumps from current invocable
+        for (unsigned jmp : result.jumps) {
             if (DEBUG) {
-                cout << "[asm] debug: pushed relative jump to jump table: " << jmp << '+' << block_bodies_section_size << endl;
+                cout << "[asm] debug: pushed relative jump to jump table: " << jmp << '+' << bytecode_size_so_far << endl;
             }
-            jump_table.push_back(jmp+block_bodies_section_size);
+            jump_table.push_back(jmp+unsigned(bytecode_size_so_far));
         }
 
-        for (unsigned i = 0; i < jumps_absolute.size(); ++i) {
+        for (unsigned jmp : result.jumps_absolute) {
             if (DEBUG) {
-                cout << "[asm] debug: pushed absolute jump to jump table: " << jumps_absolute[i] << "+0" << endl;
+                cout << "[asm] debug: pushed absolute jump to jump table: " << jmp << "+0" << endl;
             }
-            jump_positions.push_back(tuple<int, int>(jumps_absolute[i]+block_bodies_section_size, 0));
+            jump_positions.push_back(tuple<int, int>(int(jmp)+bytecode_size_so_far, 0));
         }
 
-        block_bodies_section_size += func.size();
-    }
-
-    // functions section size, must be offset by the size of block section
-    functions_section_size = block_bodies_section_size;
-
-    for (string name : functions.names) {
-        // do not generate bytecode for functions that were linked
-        if (find(linked_function_names.begin(), linked_function_names.end(), name) != linked_function_names.end()) { continue; }
-
-        if (VERBOSE or DEBUG) {
-            cout << "[asm] message: generating bytecode for function \"" << name << '"';
-        }
-        uint16_t fun_bytes = 0;
-        try {
-            fun_bytes = Program::countBytes(name == ENTRY_FUNCTION_NAME ? filter(functions.bodies.at(name)) : functions.bodies.at(name));
-            if (VERBOSE or DEBUG) {
-                cout << " (" << fun_bytes << " bytes at byte " << functions_section_size << ')' << endl;
-            }
-        } catch (const string& e) {
-            cout << "fatal: error during function size count (pre-assembling): " << e << endl;
-            exit(1);
-        } catch (const std::out_of_range& e) {
-            cout << e.what() << endl;
-            exit(1);
-        }
+        bytecode_size_so_far += result.size;
+    };
 
-        Program func(fun_bytes);
-        func.setdebug(DEBUG).setscream(SCREAM);
-        try {
-            assemble(func, functions.bodies.at(name));
-        } catch (const string& e) {
-            cout << (DEBUG ? "\n" : "") << "fatal: error during assembling: " << e << endl;
-            exit(1);
-        } catch (const char*& e) {
-            cout << (DEBUG ? "\n" : "") << "fatal: error during assembling: " << e << endl;
-            exit(1);
-        } catch (const std::out_of_range& e) {
-            cout << (DEBUG ? "\n" : "") << "[asm] fatal: could not assemble function '" << name << "' (" << e.what() << ')' << endl;
-            exit(1);
+    // debugging output of the generator would be garbled if it was run on several threads
+    unsigned jobs = (DEBUG ? 1 : min(flags.jobs, unsigned(invocables.size())));
+    if (jobs <= 1) {
+        for (unsigned i = 0; i < invocables.size(); ++i) {
+            generateInvocable(i);
+            placeInvocable(i);
         }
-
-        vector<unsigned> jumps = func.jumps();
-        vector<unsigned> jumps_absolute = func.jumpsAbsolute();
-
-        vector<tuple<int, int> > local_jumps;
-        for (unsigned i = 0; i < jumps.size(); ++i) {
-            unsigned jmp = jumps[i];
-            local_jumps.push_back(tuple<int, int>(jmp, functions_section_size));
+    } else {
+        atomic<unsigned> next(0);
+        vector<thread> workers;
+        for (unsigned j = 0; j < jobs; ++j) {
+            workers.push_back(thread([&]() {
+                for (unsigned i = next++; i < invocables.size(); i = next++) {
+                    generateInvocable(i);
+                }
+            }));
         }
-        func.calculateJumps(local_jumps);
-
-        byte* btcode = func.bytecode();
-
-        // store generated bytecode fragment for future use (we must not yet write it to the file to conform to bytecode format)
-        functions_bytecode[name] = tuple<int, byte*>(func.size(), btcode);
-
-        // extend jump table with jumps from current function
-        for (unsigned i = 0; i < jumps.size(); ++i) {
-            unsigned jmp = jumps[i];
-            if (DEBUG) {
-                cout << "[asm] debug: pushed relative jump to jump table: " << jmp << '+' << functions_section_size << endl;
-            }
-            jump_table.push_back(jmp+functions_section_size);
+        for (thread& worker : workers) {
+            worker.join();
         }
-
-        for (unsigned i = 0; i < jumps_absolute.size(); ++i) {
-            if (DEBUG) {
-                cout << "[asm] debug: pushed absolute jump to jump table: " << jumps_absolute[i] << "+0" << endl;
-            }
-            jump_positions.push_back(tuple<int, int>(jumps_absolute[i]+functions_section_size, 0));
+        for (unsigned i = 0; i < invocables.size(); ++i) {
+            placeInvocable(i);
         }
-
-        functions_section_size += func.size();
     }
 
 
@@ -1073,18 +1477,18 @@ int generate(const vector<string>& expanded_lines, const map<unsigned, unsigned>
 
     ////////////////////////////
     // PREPARE BLOCK IDS SECTION
-    uint16_t block_ids_section_size = 0;
+    uint32_t block_ids_section_size = 0;
     for (string name : blocks.names) { block_ids_section_size += name.size(); }
-    // we need to insert address (uint16_t) after every block
-    block_ids_section_size += sizeof(uint16_t) * blocks.names.size();
+    // we need to insert address (uint32_t) after every block
+    block_ids_section_size += sizeof(uint32_t) * blocks.names.size();
     // for null characters after block names
     block_ids_section_size += blocks.names.size();
 
     /////////////////////////////////////////////
     // WRITE OUT BLOCK IDS SECTION
     // THIS ALSO INCLUDES IDS OF LINKED blocks.bodies
-    out.write((const char*)&block_ids_section_size, sizeof(uint16_t));
-    uint16_t block_bodies_size_so_far = 0;
+    out.write((const char*)&block_ids_section_size, sizeof(uint32_t));
+    uint32_t block_bodies_size_so_far = 0;
     for (string name : blocks.names) {
         if (DEBUG) {
             cout << "[asm:write] writing block '" << name << "' to block address table";
@@ -1104,11 +1508,11 @@ int generate(const vector<string>& expanded_lines, const map<unsigned, unsigned>
         // ...requires terminating null character
         out.put('\0');
         // mapped address must come after name
-        out.write((const char*)&block_bodies_size_so_far, sizeof(uint16_t));
+        out.write((const char*)&block_bodies_size_so_far, sizeof(uint32_t));
         // blocks.bodies size must be incremented by the actual size of block's bytecode size
         // to give correct offset for next block
         try {
-            block_bodies_size_so_far += Program::countBytes(blocks.bodies.at(name));
+            block_bodies_size_so_far += get<0>(block_bodies_bytecode.at(name));
         } catch (const std::out_of_range& e) {
             cout << "fatal: could not find block '" << name << "' during address table write" << endl;
             exit(1);
@@ -1118,10 +1522,10 @@ int generate(const vector<string>& expanded_lines, const map<unsigned, unsigned>
 
     ///////////////////////////////
     // PREPARE FUNCTION IDS SECTION
-    uint16_t function_ids_section_size = 0;
+    uint32_t function_ids_section_size = 0;
     for (string name : functions.names) { function_ids_section_size += name.size(); }
-    // we need to insert address (uint16_t) after every function
-    function_ids_section_size += sizeof(uint16_t) * functions.names.size();
+    // we need to insert address (uint32_t) after every function
+    function_ids_section_size += sizeof(uint32_t) * functions.names.size();
     // for null characters after function names
     function_ids_section_size += functions.names.size();
 
@@ -1129,8 +1533,8 @@ int generate(const vector<string>& expanded_lines, const map<unsigned, unsigned>
     /////////////////////////////////////////////
     // WRITE OUT FUNCTION IDS SECTION
     // THIS ALSO INCLUDES IDS OF LINKED FUNCTIONS
-    out.write((const char*)&function_ids_section_size, sizeof(uint16_t));
-    uint16_t functions_size_so_far = block_bodies_size_so_far;
+    out.write((const char*)&function_ids_section_size, sizeof(uint32_t));
+    uint32_t functions_size_so_far = block_bodies_size_so_far;
     if (DEBUG) {
         cout << "[asm:write] function addresses are offset by " << functions_size_so_far << " bytes (size of the block address table)" << endl;
     }
@@ -1153,11 +1557,11 @@ int generate(const vector<string>& expanded_lines, const map<unsigned, unsigned>
         // ...requires terminating null character
         out.put('\0');
         // mapped address must come after name
-        out.write((const char*)&functions_size_so_far, sizeof(uint16_t));
+        out.write((const char*)&functions_size_so_far, sizeof(uint32_t));
         // functions size must be incremented by the actual size of function's bytecode size
         // to give correct offset for next function
         try {
-            functions_size_so_far += Program::countBytes(functions.bodies.at(name));
+            functions_size_so_far += get<0>(functions_bytecode.at(name));
         } catch (const std::out_of_range& e) {
             cout << "fatal: could not find function '" << name << "' during address table write" << endl;
             exit(1);
@@ -1171,14 +1575,33 @@ int generate(const vector<string>& expanded_lines, const map<unsigned, unsigned>
         // ...requires terminating null character
         out.put('\0');
         // mapped address must come after name
-        uint16_t address = function_addresses[name];
-        out.write((const char*)&address, sizeof(uint16_t));
+        uint32_t address = function_addresses[name];
+        out.write((const char*)&address, sizeof(uint32_t));
+    }
+
+
+    //////////////////////////////////////
+    // WRITE OUT REGISTER SET SIZES SECTION
+    // THIS ALSO INCLUDES SIZES FOR LINKED FUNCTIONS
+    uint32_t registers_section_size = 0;
+    for (auto fn : function_registers) {
+        registers_section_size += uint32_t(fn.first.size() + 1 + sizeof(uint32_t));
+    }
+    out.write((const char*)&registers_section_size, sizeof(uint32_t));
+    for (auto fn : function_registers) {
+        out.write(fn.first.c_str(), fn.first.size());
+        out.put('\0');
+        uint32_t registers_count = fn.second;
+        out.write((const char*)&registers_count, sizeof(uint32_t));
     }
 
 
     //////////////////////
     // WRITE BYTECODE SIZE
-    out.write((const char*)&bytes, 16);
+    // the field is 16 bytes wide but only its beginning holds the size, and
+    // the rest must be zeroed or the output would not be reproducible
+    uint64_t bytecode_size_field[2] = {bytes, 0};
+    out.write((const char*)bytecode_size_field, 16);
 
     byte* program_bytecode = new byte[bytes];
     int program_bytecode_used = 0;
@@ -1237,11 +1660,11 @@ int generate(const vector<string>& expanded_lines, const map<unsigned, unsigned>
 
     ////////////////////////////////////
     // WRITE STATICALLY LINKED LIBRARIES
-    uint16_t bytes_offset = current_link_offset;
-    for (tuple<string, uint16_t, char*> lnk : linked_libs_bytecode) {
+    uint32_t bytes_offset = current_link_offset;
+    for (tuple<string, uint32_t, char*> lnk : linked_libs_bytecode) {
         string lib_name;
         byte* linked_bytecode;
-        uint16_t linked_size;
+        uint32_t linked_size;
         tie(lib_name, linked_size, linked_bytecode) = lnk;
 
         if (VERBOSE or DEBUG) {
@@ -1270,6 +1693,7 @@ int generate(const vector<string>& expanded_lines, const map<unsigned, unsigned>
             program_bytecode[program_bytecode_used+i] = linked_bytecode[i];
         }
         program_bytecode_used += linked_size;
+        bytes_offset += linked_size;
     }
 
     out.write((const char*)program_bytecode, bytes);
@@ -0,0 +1,468 @@
+#include <algorithm>
+#include <map>
+#include <set>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <viua/support/string.h>
+#include <viua/cg/assembler/assembler.h>
+#include <viua/cpu/verifier.h>
+#include <viua/program.h>
+#include <viua/front/asm.h>
+using namespace std;
+
+
+/*  Function inliner.
+ *
+ *  Substitutes bodies of small leaf functions into call sites in expanded bodies of other functions
+ *  (one instruction per line), i.e. replaces
+ *
+ *      frame 2; istore 1 20; param 0 1; param 1 2; call 3 sum
+ *
+ *  with the body of `sum` whose registers are renamed into a range of free registers of the caller,
+ *  `arg` instructions are translated into copies of registers given to `param`, `argc` into `istore` of
+ *  the number of parameters, and `end` into a copy of the returned value to the return register of the call.
+ *  Registers of the inlined body still holding objects when it ends are freed, so the renamed registers are empty
+ *  whenever the body is entered (exactly as registers of a new frame would be) and may be reused by all inlined bodies.
+ *
+ *  Only straight-line functions consisting of instructions which create, read, or move objects between
+ *  registers (and ending with a single `end`) are inlined; they never call other functions nor create closures so
+ *  they cannot be recursive.
+ *  Functions longer than the limit, closures, and functions listed in `.noinline: <name>` directives are never inlined.
+ *  Inlining is iterated, so functions which became leaves after calls in them were inlined are inlined too.
+ *
+ *  Calls are only inlined into functions whose registers are all known (see liveness analysis), which do not
+ *  use `ress` nor `try`, and do not use numeric, relative, absolute nor byte jumps (their targets would move).
+ *  A call is inlined only if its frame is created by a literal `frame` instruction in the same basic block,
+ *  parameters are passed with `param` (not `paref`), and registers given to `param` are not touched before the call.
+ *  Each function may grow by at most given number of instructions.
+ */
+namespace inliner {
+    // instructions which may appear in inlined functions
+    static const set<string> INLINABLE = {
+        "nop", "izero", "istore", "iinc", "idec",
+        "iadd", "isub", "imul", "idiv", "ilt", "ilte", "igt", "igte", "ieq",
+        "fstore", "fadd", "fsub", "fmul", "fdiv", "flt", "flte", "fgt", "fgte", "feq",
+        "bstore", "strstore", "itof", "ftoi", "stoi", "stof",
+        "not", "and", "or", "isnull", "vec", "print", "echo",
+        "copy", "move", "swap", "free", "empty",
+        "arg", "argc", "end",
+    };
+
+    // instructions creating fresh object in the register given as their first operand
+    static const set<string> PRODUCERS = {
+        "izero", "istore",
+        "iadd", "isub", "imul", "idiv", "ilt", "ilte", "igt", "igte", "ieq",
+        "fstore", "fadd", "fsub", "fmul", "fdiv", "flt", "flte", "fgt", "fgte", "feq",
+        "bstore", "strstore", "itof", "ftoi", "stoi", "stof",
+        "not", "and", "or", "isnull", "vec",
+        "copy", "arg", "argc",
+    };
+
+
+    struct callee_t {
+        vector<string> lines;
+        map<string, int> names;
+
+        // number of instructions (without the final end)
+        unsigned size;
+
+        // registers used by the function, in ascending order
+        vector<unsigned> registers;
+        // registers holding objects when the function ends
+        set<unsigned> occupied;
+        // parameters read by arg instructions
+        set<unsigned> parameters;
+    };
+
+    struct site_t {
+        unsigned frame;
+        unsigned call;
+
+        unsigned arguments;
+        map<unsigned, unsigned> parameters;
+        // register receiving the returned value (0 if the value is dropped)
+        unsigned result;
+    };
+
+
+    static string mnemonic(const string& line) {
+        return str::chunk(line);
+    }
+
+    static vector<string> operands(const string& line) {
+        return str::chunks(str::sub(line, str::chunk(line).size()));
+    }
+
+    static string kinds(const string& line, unsigned operands_count) {
+        /** Return kinds of operands of an instruction up to the first string operand.
+         *
+         *  Throws std::out_of_range for unknown instructions.
+         */
+        string instr = mnemonic(line);
+        string k = verifier::operandkinds(Program::schema(instr).opcode);
+        k = k.substr(0, k.find('s'));
+
+        // short form of call does not have the return value register
+        if ((instr == "call" or instr == "msg") and operands_count == 1) {
+            k = "";
+        }
+        return k.substr(0, min(k.size(), string::size_type(operands_count)));
+    }
+
+    static bool resolve(const string& token, const map<string, int>& names, unsigned& reg) {
+        if (str::isnum(token, false)) {
+            reg = unsigned(stoul(token));
+            return true;
+        }
+        if (names.count(token)) {
+            reg = unsigned(names.at(token));
+            return true;
+        }
+        return false;
+    }
+
+    static bool registers(const string& line, const map<string, int>& names, vector<unsigned>& regs) {
+        /** Find registers used by an instruction.
+         *
+         *  Returns false if any of them could not be established.
+         */
+        vector<string> ops = operands(line);
+        string k;
+        try {
+            k = kinds(line, unsigned(ops.size()));
+        } catch (const std::out_of_range& e) {
+            return false;
+        }
+        for (unsigned i = 0; i < ops.size(); ++i) {
+            if (ops[i][0] == '@') { return false; }
+        }
+        for (unsigned i = 0; i < k.size(); ++i) {
+            if (k[i] != 'r') { continue; }
+            unsigned reg = 0;
+            if (not resolve(ops[i], names, reg)) { return false; }
+            regs.push_back(reg);
+        }
+        return true;
+    }
+
+    static string rename(const string& line, const map<string, int>& names, const map<unsigned, unsigned>& mapping) {
+        /** Rewrite register operands of an instruction according to the mapping.
+         *
+         *  Operands following the register operands are copied verbatim.
+         */
+        string instr = mnemonic(line);
+        string rest = str::lstrip(str::sub(line, instr.size()));
+        string k = kinds(line, unsigned(operands(line).size()));
+
+        ostringstream oss;
+        oss << instr;
+        for (unsigned i = 0; i < k.size(); ++i) {
+            string token = str::chunk(rest);
+            rest = str::lstrip(str::sub(rest, token.size()));
+            unsigned reg = 0;
+            if (k[i] == 'r' and resolve(token, names, reg)) {
+                token = to_string(mapping.at(reg));
+            }
+            oss << ' ' << token;
+        }
+        if (rest.size()) {
+            oss << ' ' << rest;
+        }
+        return oss.str();
+    }
+
+    static bool analyse(const vector<string>& lines, unsigned limit, callee_t& callee) {
+        /** Check if a function can be inlined, and
+         *  find registers and parameters it uses.
+         */
+        callee.lines = lines;
+        callee.names = assembler::ce::getnames(lines);
+        callee.size = 0;
+
+        set<unsigned> used = { 0 };
+        for (unsigned i = 0; i < lines.size(); ++i) {
+            const string& line = lines[i];
+            if (str::startswith(line, ".name:")) {
+                unsigned reg = 0;
+                if (not resolve(operands(line).at(0), callee.names, reg)) { return false; }
+                used.insert(reg);
+                continue;
+            }
+            if (str::startswith(line, ".")) {
+                return false;
+            }
+
+            string instr = mnemonic(line);
+            if (INLINABLE.count(instr) == 0) {
+                return false;
+            }
+            if (instr == "end") {
+                if (i != lines.size()-1) { return false; }
+                continue;
+            }
+            if (++callee.size > limit) {
+                return false;
+            }
+
+            vector<unsigned> regs;
+            if (not registers(line, callee.names, regs)) {
+                return false;
+            }
+            used.insert(regs.begin(), regs.end());
+
+            if (instr == "arg") {
+                if (not str::isnum(operands(line).at(1), false)) {
+                    return false;
+                }
+                callee.parameters.insert(unsigned(stoul(operands(line).at(1))));
+            }
+
+            // track which registers hold objects
+            if (PRODUCERS.count(instr)) {
+                callee.occupied.insert(regs.at(0));
+            } else if (instr == "move") {
+                bool occupied = callee.occupied.count(regs.at(1));
+                if (occupied) { callee.occupied.insert(regs.at(0)); } else { callee.occupied.erase(regs.at(0)); }
+                callee.occupied.erase(regs.at(1));
+            } else if (instr == "swap") {
+                bool a = callee.occupied.count(regs.at(0));
+                bool b = callee.occupied.count(regs.at(1));
+                if (b) { callee.occupied.insert(regs.at(0)); } else { callee.occupied.erase(regs.at(0)); }
+                if (a) { callee.occupied.insert(regs.at(1)); } else { callee.occupied.erase(regs.at(1)); }
+            } else if (instr == "free" or instr == "empty") {
+                callee.occupied.erase(regs.at(0));
+            }
+        }
+
+        if (lines.size() == 0 or mnemonic(lines.back()) != "end") {
+            return false;
+        }
+        callee.registers.assign(used.begin(), used.end());
+        return true;
+    }
+
+    static bool inlinable_into(const vector<string>& lines) {
+        /** Check if calls in a function can be inlined.
+         */
+        for (const string& line : lines) {
+            string instr = mnemonic(line);
+            if (instr == "ress" or instr == "try") {
+                return false;
+            }
+            if (instr == "jump" or instr == "branch") {
+                vector<string> ops = operands(line);
+                for (unsigned i = (instr == "branch" ? 1 : 0); i < ops.size(); ++i) {
+                    const string& target = ops[i];
+                    if (str::isnum(target, false) or target[0] == '.' or target[0] == '+' or target[0] == '-' or target.substr(0, 2) == "0x") {
+                        return false;
+                    }
+                }
+            }
+        }
+        return true;
+    }
+
+    static bool site(const vector<string>& lines, const map<string, int>& names, unsigned frame, site_t& s) {
+        /** Find call consuming a frame, and
+         *  parameters passed to it.
+         */
+        s.frame = frame;
+        s.result = 0;
+
+        vector<string> frame_ops = operands(lines[frame]);
+        if (frame_ops.size() == 0 or not str::isnum(frame_ops[0], false)) {
+            return false;
+        }
+        s.arguments = unsigned(stoul(frame_ops[0]));
+
+        set<unsigned> sources;
+        for (unsigned i = frame+1; i < lines.size(); ++i) {
+            const string& line = lines[i];
+            if (str::startswith(line, ".name:")) {
+                continue;
+            }
+            if (str::startswith(line, ".")) {
+                return false;
+            }
+
+            string instr = mnemonic(line);
+            if (instr == "tailcall" or instr == "spawn") {
+                return false;
+            }
+            if (instr == "call") {
+                vector<string> ops = operands(line);
+                if (ops.size() == 0 or ops.size() > 2) {
+                    return false;
+                }
+                if (ops.size() == 2 and not resolve(ops[0], names, s.result)) {
+                    return false;
+                }
+                s.call = i;
+                return true;
+            }
+
+            vector<unsigned> regs;
+            if (not registers(line, names, regs)) {
+                return false;
+            }
+            if (instr == "param") {
+                if (not str::isnum(operands(line).at(0), false)) {
+                    return false;
+                }
+                unsigned parameter = unsigned(stoul(operands(line).at(0)));
+                if (parameter >= s.arguments) {
+                    return false;
+                }
+                s.parameters[parameter] = regs.at(0);
+                sources.insert(regs.at(0));
+                continue;
+            }
+            // arg and argc read parameters of the caller so they are not affected by the frame
+            if (INLINABLE.count(instr) == 0 or instr == "end") {
+                return false;
+            }
+            for (unsigned reg : regs) {
+                if (sources.count(reg)) { return false; }
+            }
+        }
+        return false;
+    }
+
+    static vector<string> substitute(const callee_t& callee, const site_t& s, unsigned base) {
+        /** Return body of a function with registers renamed to start at base, to be put in place of a call.
+         */
+        map<unsigned, unsigned> mapping;
+        for (unsigned i = 0; i < callee.registers.size(); ++i) {
+            mapping[callee.registers[i]] = (base + i);
+        }
+
+        vector<string> body;
+        for (const string& line : callee.lines) {
+            if (str::startswith(line, ".")) {
+                continue;
+            }
+
+            string instr = mnemonic(line);
+            vector<string> ops = operands(line);
+            unsigned reg = 0;
+            if (instr == "arg") {
+                resolve(ops[0], callee.names, reg);
+                body.push_back("copy " + to_string(mapping.at(reg)) + ' ' + to_string(s.parameters.at(unsigned(stoul(ops[1])))));
+            } else if (instr == "argc") {
+                resolve(ops[0], callee.names, reg);
+                body.push_back("istore " + to_string(mapping.at(reg)) + ' ' + to_string(s.arguments));
+            } else if (instr == "end") {
+                if (s.result) {
+                    body.push_back("copy " + to_string(s.result) + ' ' + to_string(mapping.at(0)));
+                }
+                for (unsigned r : callee.occupied) {
+                    body.push_back("free " + to_string(mapping.at(r)));
+                }
+            } else {
+                body.push_back(rename(line, callee.names, mapping));
+            }
+        }
+        return body;
+    }
+
+
+    unsigned expand(invocables_t& functions, const invocables_t& blocks, const vector<string>& lines, unsigned limit, unsigned growth) {
+        /** Inline calls to small leaf functions.
+         *
+         *  Returns number of inlined calls.
+         */
+        set<string> noinline;
+        for (const string& line : lines) {
+            if (str::startswith(line, ".noinline:")) {
+                noinline.insert(str::chunk(str::sub(line, str::chunk(line).size())));
+            }
+        }
+
+        set<string> targets;
+        for (const auto& function : functions.bodies) {
+            for (const string& line : function.second) {
+                if (mnemonic(line) == "closure" or mnemonic(line) == "function") {
+                    vector<string> ops = operands(line);
+                    if (ops.size() == 2) { targets.insert(ops[1]); }
+                }
+            }
+        }
+
+        map<string, unsigned> budget;
+        for (const auto& function : functions.bodies) {
+            budget[function.first] = growth;
+        }
+
+        unsigned inlined = 0;
+        bool changed = true;
+        while (changed) {
+            changed = false;
+
+            map<string, callee_t> callees;
+            for (const auto& function : functions.bodies) {
+                callee_t callee;
+                if (noinline.count(function.first) == 0 and targets.count(function.first) == 0 and analyse(function.second, limit, callee)) {
+                    callees[function.first] = callee;
+                }
+            }
+            if (callees.size() == 0) {
+                break;
+            }
+
+            map<string, unsigned> sizes = liveness::registers(functions, blocks);
+            for (auto& function : functions.bodies) {
+                if (sizes.count(function.first) == 0 or not inlinable_into(function.second)) {
+                    continue;
+                }
+
+                vector<string>& body = function.second;
+                map<string, int> names = assembler::ce::getnames(body);
+                for (unsigned i = 0; i < body.size(); ++i) {
+                    if (mnemonic(body[i]) != "frame") {
+                        continue;
+                    }
+
+                    site_t s;
+                    if (not site(body, names, i, s)) {
+                        continue;
+                    }
+                    vector<string> ops = operands(body[s.call]);
+                    auto callee = callees.find(ops.back());
+                    if (callee == callees.end() or callee->first == function.first) {
+                        continue;
+                    }
+
+                    const callee_t& c = callee->second;
+                    bool supplied = true;
+                    for (unsigned parameter : c.parameters) {
+                        if (s.parameters.count(parameter) == 0) { supplied = false; }
+                    }
+                    if (not supplied or (s.result and c.occupied.count(0) == 0) or c.size > budget.at(function.first)) {
+                        continue;
+                    }
+
+                    vector<string> substituted = substitute(c, s, sizes.at(function.first));
+                    vector<string> rewritten(body.begin(), body.begin()+s.frame);
+                    for (unsigned j = s.frame+1; j < s.call; ++j) {
+                        if (mnemonic(body[j]) != "param") {
+                            rewritten.push_back(body[j]);
+                        }
+                    }
+                    unsigned resume = unsigned(rewritten.size() + substituted.size());
+                    rewritten.insert(rewritten.end(), substituted.begin(), substituted.end());
+                    rewritten.insert(rewritten.end(), body.begin()+s.call+1, body.end());
+                    body = rewritten;
+
+                    budget[function.first] -= c.size;
+                    ++inlined;
+                    changed = true;
+
+                    // continue after the inlined body
+                    i = resume-1;
+                }
+            }
+        }
+        return inlined;
+    }
+}
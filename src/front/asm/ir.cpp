@@ -0,0 +1,683 @@
+#include <algorithm>
+#include <map>
+#include <set>
+#include <string>
+#include <vector>
+#include <viua/support/string.h>
+#include <viua/cg/assembler/assembler.h>
+#include <viua/cpu/verifier.h>
+#include <viua/program.h>
+#include <viua/front/ir.h>
+using namespace std;
+
+
+/*  Intermediate representation of function bodies.
+ *
+ *  Expanded body of a function (one instruction per line) is parsed into basic blocks linked into
+ *  a control-flow graph by `jump` and `branch` instructions (targets given as marks, numeric or relative
+ *  indexes are all resolved to blocks), and register usage is converted to SSA form: every write to a register
+ *  creates its new version, and versions merging at joins of the graph are described by phi nodes.
+ *  Instructions are not renamed; the SSA form only tells which write each read sees, and
+ *  lowering emits the (possibly rewritten) instructions with their original registers, and
+ *  marks for every block that is a jump target.
+ *
+ *  Only functions consisting of instructions with known effect on registers are converted; functions
+ *  using `@` operands, absolute or byte jumps, blocks (`enter`, `try`, `catch`), register sets (`ress`),
+ *  closures, or falling through to the next function are rejected by ir::build().
+ *
+ *  Registers written by `arg` or `call` may hold references (and writing to them would rebind the
+ *  reference instead of replacing the object), so they, and registers objects are moved between them and,
+ *  are "untracked" and must not be reasoned about by optimizations.
+ */
+namespace ir {
+    /*  Roles of operands:
+     *
+     *      d   - register is set to a fresh object
+     *      w   - register is set to an object moved from another register (possibly none)
+     *      u   - register is only read (may be replaced with another register holding equal object)
+     *      r   - register is read (but identity of the object or the register matters)
+     *      m   - register is read and its object is modified in place
+     *      k   - register is read and emptied
+     *      x   - register is read and set to an object moved from another register (possibly none)
+     *      l   - literal
+     *      t   - jump target
+     */
+    static const map<string, string> ROLES = {
+        { "nop", "" },
+        { "izero", "d" }, { "istore", "dl" }, { "iinc", "m" }, { "idec", "m" },
+        { "iadd", "duu" }, { "isub", "duu" }, { "imul", "duu" }, { "idiv", "duu" },
+        { "ilt", "duu" }, { "ilte", "duu" }, { "igt", "duu" }, { "igte", "duu" }, { "ieq", "duu" },
+        { "tiadd", "duu" }, { "tisub", "duu" }, { "timul", "duu" }, { "tidiv", "duu" },
+        { "tilt", "duu" }, { "tilte", "duu" }, { "tigt", "duu" }, { "tigte", "duu" }, { "tieq", "duu" },
+        { "fstore", "dl" },
+        { "fadd", "duu" }, { "fsub", "duu" }, { "fmul", "duu" }, { "fdiv", "duu" },
+        { "flt", "duu" }, { "flte", "duu" }, { "fgt", "duu" }, { "fgte", "duu" }, { "feq", "duu" },
+        { "bstore", "dl" }, { "strstore", "d" },
+        { "itof", "du" }, { "ftoi", "du" }, { "stoi", "du" }, { "stof", "du" },
+        { "not", "m" }, { "and", "duu" }, { "or", "duu" }, { "isnull", "dr" },
+        { "vec", "d" }, { "vlen", "dr" }, { "print", "u" }, { "echo", "u" },
+        { "copy", "du" }, { "move", "wk" }, { "swap", "xx" }, { "free", "k" }, { "empty", "k" },
+        { "arg", "dl" }, { "argc", "d" },
+        { "frame", "ll" }, { "param", "lr" }, { "call", "d" }, { "tailcall", "" }, { "spawn", "" },
+        { "jump", "t" }, { "branch", "utt" },
+        { "end", "" }, { "halt", "" }, { "throw", "r" },
+    };
+
+    static bool terminating(const string& instr) {
+        return (instr == "end" or instr == "tailcall" or instr == "halt" or instr == "throw" or instr == "jump");
+    }
+
+    static bool reads(char role) {
+        return (role == 'u' or role == 'r' or role == 'm' or role == 'k' or role == 'x');
+    }
+
+    static bool writes(char role) {
+        return (role == 'd' or role == 'w' or role == 'm' or role == 'k' or role == 'x');
+    }
+
+    static bool numeric(const string& mark) {
+        // marks with names which look like numeric jumps cannot be used as jump targets
+        return (str::isnum(mark) or mark[0] == '+' or mark[0] == '.' or mark.substr(0, 2) == "0x");
+    }
+
+
+    string roles(const string& instr, unsigned operands_count) {
+        /** Return roles of operands of an instruction.
+         *
+         *  Throws std::out_of_range for instructions with unknown effect on registers.
+         */
+        string r = ROLES.at(instr);
+        if (instr == "call" and operands_count == 0) {
+            r = "";
+        }
+        if (operands_count > r.size()) {
+            throw std::out_of_range(instr);
+        }
+        return r.substr(0, operands_count);
+    }
+
+    static bool parse(const string& line, const map<string, int>& names, instruction_t& instruction) {
+        /** Parse an instruction.
+         *
+         *  Register operands are resolved to indexes.
+         *  Returns false if the instruction is not supported.
+         */
+        instruction.mnemonic = str::chunk(line);
+        string rest = str::lstrip(str::sub(line, instruction.mnemonic.size()));
+
+        unsigned tokens = unsigned(str::chunks(rest).size());
+        string kinds;
+        try {
+            kinds = verifier::operandkinds(Program::schema(instruction.mnemonic).opcode);
+        } catch (const std::out_of_range& e) {
+            return false;
+        }
+        // operands following the first string operand are copied verbatim
+        unsigned count = min(tokens, unsigned(kinds.find('s') == string::npos ? kinds.size() : kinds.find('s')));
+        if (instruction.mnemonic == "call" and tokens == 1) {
+            // short form of call does not have the return value register
+            count = 0;
+        }
+
+        for (unsigned i = 0; i < count; ++i) {
+            string token = str::chunk(rest);
+            rest = str::lstrip(str::sub(rest, token.size()));
+            instruction.operands.push_back(token);
+        }
+        instruction.tail = rest;
+
+        try {
+            instruction.roles = roles(instruction.mnemonic, count);
+        } catch (const std::out_of_range& e) {
+            return false;
+        }
+
+        for (unsigned i = 0; i < instruction.operands.size(); ++i) {
+            string& token = instruction.operands[i];
+            if (token[0] == '@') {
+                return false;
+            }
+            char role = instruction.roles[i];
+            if (role == 'l' or role == 't') {
+                continue;
+            }
+            if (names.count(token)) {
+                token = to_string(names.at(token));
+            } else if (not str::isnum(token, false)) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    static bool target(const string& token, unsigned index, unsigned count, const map<string, unsigned>& marks, unsigned& t) {
+        /** Resolve jump target to index of an instruction.
+         */
+        long target_index = 0;
+        if (str::isnum(token, false)) {
+            target_index = stol(token);
+        } else if (token[0] == '+' and str::isnum(str::sub(token, 1), false)) {
+            target_index = long(index) + stol(str::sub(token, 1));
+        } else if (token[0] == '-' and str::isnum(str::sub(token, 1), false)) {
+            target_index = long(index) - stol(str::sub(token, 1));
+        } else if (token[0] == '.' or token.substr(0, 2) == "0x" or marks.count(token) == 0) {
+            return false;
+        } else {
+            target_index = long(marks.at(token));
+        }
+        if (target_index < 0 or target_index >= long(count)) {
+            return false;
+        }
+        t = unsigned(target_index);
+        return true;
+    }
+
+
+    bool build(const vector<string>& lines, function_t& function) {
+        /** Build IR of a function from its expanded body.
+         *
+         *  Returns false if the function cannot be represented.
+         */
+        map<string, int> names = assembler::ce::getnames(lines);
+
+        vector<instruction_t> instructions;
+        map<unsigned, vector<string>> instruction_marks;
+        map<string, unsigned> marks;
+        for (const string& line : lines) {
+            if (str::startswith(line, ".name:")) {
+                function.directives.push_back(line);
+                continue;
+            }
+            if (str::startswith(line, ".mark:")) {
+                string mark = str::chunk(str::sub(line, 6));
+                marks[mark] = unsigned(instructions.size());
+                instruction_marks[unsigned(instructions.size())].push_back(mark);
+                continue;
+            }
+            if (str::startswith(line, ".")) {
+                return false;
+            }
+
+            instruction_t instruction;
+            if (not parse(line, names, instruction)) {
+                return false;
+            }
+            instructions.push_back(instruction);
+        }
+        if (instructions.size() == 0 or not terminating(instructions.back().mnemonic)) {
+            return false;
+        }
+
+        // resolve jump targets to instructions, and
+        // find leaders of basic blocks
+        vector<vector<unsigned>> targets(instructions.size());
+        set<unsigned> leaders = { 0 };
+        for (unsigned i = 0; i < instructions.size(); ++i) {
+            const instruction_t& instruction = instructions[i];
+            if (instruction_marks.count(i)) {
+                leaders.insert(i);
+            }
+            for (unsigned k = 0; k < instruction.operands.size(); ++k) {
+                if (instruction.roles[k] != 't') {
+                    continue;
+                }
+                unsigned t = 0;
+                if (not target(instruction.operands[k], i, unsigned(instructions.size()), marks, t)) {
+                    return false;
+                }
+                targets[i].push_back(t);
+                leaders.insert(t);
+            }
+            if (instruction.mnemonic == "branch") {
+                if (instruction.operands.size() < 2) {
+                    return false;
+                }
+                if (instruction.operands.size() == 2) {
+                    if (i+1 >= instructions.size()) {
+                        return false;
+                    }
+                    targets[i].push_back(i+1);
+                }
+            }
+            if (terminating(instruction.mnemonic) or instruction.mnemonic == "branch") {
+                if (i+1 < instructions.size()) {
+                    leaders.insert(i+1);
+                }
+            }
+        }
+
+        map<unsigned, unsigned> block_of;
+        for (unsigned leader : leaders) {
+            unsigned b = unsigned(block_of.size());
+            block_of[leader] = b;
+        }
+        function.blocks.resize(leaders.size());
+        for (unsigned i = 0, b = 0; i < instructions.size(); ++i) {
+            if (block_of.count(i)) {
+                b = block_of.at(i);
+                if (instruction_marks.count(i)) {
+                    function.blocks[b].marks = instruction_marks.at(i);
+                }
+            }
+            for (unsigned t : targets[i]) {
+                instructions[i].targets.push_back(block_of.at(t));
+            }
+            function.blocks[b].instructions.push_back(instructions[i]);
+        }
+
+        // find registers which may hold references
+        bool changed = true;
+        for (const block_t& block : function.blocks) {
+            for (const instruction_t& instruction : block.instructions) {
+                if ((instruction.mnemonic == "arg" or instruction.mnemonic == "call") and instruction.operands.size()) {
+                    function.untracked.insert(unsigned(stoul(instruction.operands[0])));
+                }
+            }
+        }
+        while (changed) {
+            changed = false;
+            for (const block_t& block : function.blocks) {
+                for (const instruction_t& instruction : block.instructions) {
+                    if (instruction.mnemonic != "move" and instruction.mnemonic != "swap") {
+                        continue;
+                    }
+                    unsigned a = unsigned(stoul(instruction.operands.at(0))), b = unsigned(stoul(instruction.operands.at(1)));
+                    if (function.untracked.count(a) != function.untracked.count(b)) {
+                        function.untracked.insert(a);
+                        function.untracked.insert(b);
+                        changed = true;
+                    }
+                }
+            }
+        }
+
+        link(function);
+        return true;
+    }
+
+    void link(function_t& function) {
+        /** Compute edges of control-flow graph, and
+         *  find blocks reachable from the entry block.
+         */
+        for (unsigned b = 0; b < function.blocks.size(); ++b) {
+            block_t& block = function.blocks[b];
+            block.successors.clear();
+            block.predecessors.clear();
+            block.reachable = false;
+
+            const instruction_t& last = block.instructions.back();
+            if (last.mnemonic == "jump" or last.mnemonic == "branch") {
+                for (unsigned t : last.targets) {
+                    if (find(block.successors.begin(), block.successors.end(), t) == block.successors.end()) {
+                        block.successors.push_back(t);
+                    }
+                }
+            } else if (not terminating(last.mnemonic)) {
+                block.successors.push_back(b+1);
+            }
+        }
+
+        vector<unsigned> pending = { 0 };
+        while (pending.size()) {
+            unsigned b = pending.back();
+            pending.pop_back();
+            if (function.blocks[b].reachable) {
+                continue;
+            }
+            function.blocks[b].reachable = true;
+            pending.insert(pending.end(), function.blocks[b].successors.begin(), function.blocks[b].successors.end());
+        }
+
+        for (unsigned b = 0; b < function.blocks.size(); ++b) {
+            if (not function.blocks[b].reachable) {
+                continue;
+            }
+            for (unsigned s : function.blocks[b].successors) {
+                function.blocks[s].predecessors.push_back(b);
+            }
+        }
+    }
+
+    void prune(function_t& function) {
+        /** Remove blocks not reachable from the entry block.
+         */
+        map<unsigned, unsigned> renumbered;
+        vector<block_t> blocks;
+        for (unsigned b = 0; b < function.blocks.size(); ++b) {
+            if (function.blocks[b].reachable) {
+                renumbered[b] = unsigned(blocks.size());
+                blocks.push_back(function.blocks[b]);
+            }
+        }
+        for (block_t& block : blocks) {
+            for (instruction_t& instruction : block.instructions) {
+                for (unsigned& t : instruction.targets) {
+                    t = renumbered.at(t);
+                }
+            }
+        }
+        function.blocks = blocks;
+        link(function);
+    }
+
+
+    static vector<unsigned> postorder(const function_t& function) {
+        vector<unsigned> order;
+        vector<bool> visited(function.blocks.size(), false);
+        // (block, index of next successor to visit)
+        vector<pair<unsigned, unsigned>> stack = { { 0, 0 } };
+        visited[0] = true;
+        while (stack.size()) {
+            unsigned b = stack.back().first;
+            unsigned& next = stack.back().second;
+            if (next < function.blocks[b].successors.size()) {
+                unsigned s = function.blocks[b].successors[next++];
+                if (not visited[s]) {
+                    visited[s] = true;
+                    stack.push_back({ s, 0 });
+                }
+            } else {
+                order.push_back(b);
+                stack.pop_back();
+            }
+        }
+        return order;
+    }
+
+    static void dominators(function_t& function) {
+        /** Compute immediate dominators of reachable blocks.
+         *
+         *  Uses the iterative algorithm of Cooper, Harvey and Kennedy.
+         */
+        vector<unsigned> order = postorder(function);
+        vector<unsigned> position(function.blocks.size(), 0);
+        for (unsigned i = 0; i < order.size(); ++i) {
+            position[order[i]] = i;
+        }
+
+        const unsigned undefined = unsigned(function.blocks.size());
+        for (block_t& block : function.blocks) {
+            block.idom = undefined;
+        }
+        function.blocks[0].idom = 0;
+
+        bool changed = true;
+        while (changed) {
+            changed = false;
+            for (auto it = order.rbegin(); it != order.rend(); ++it) {
+                unsigned b = *it;
+                if (b == 0) {
+                    continue;
+                }
+                unsigned idom = undefined;
+                for (unsigned p : function.blocks[b].predecessors) {
+                    if (function.blocks[p].idom == undefined) {
+                        continue;
+                    }
+                    if (idom == undefined) {
+                        idom = p;
+                        continue;
+                    }
+                    unsigned x = p, y = idom;
+                    while (x != y) {
+                        while (position[x] < position[y]) { x = function.blocks[x].idom; }
+                        while (position[y] < position[x]) { y = function.blocks[y].idom; }
+                    }
+                    idom = x;
+                }
+                if (function.blocks[b].idom != idom) {
+                    function.blocks[b].idom = idom;
+                    changed = true;
+                }
+            }
+        }
+    }
+
+    static void rename(function_t& function, unsigned b, const vector<vector<unsigned>>& children, map<unsigned, vector<unsigned>>& stacks, map<unsigned, unsigned>& counters) {
+        block_t& block = function.blocks[b];
+        vector<unsigned> pushed;
+
+        for (phi_t& phi : block.phis) {
+            phi.version = ++counters[phi.reg];
+            stacks[phi.reg].push_back(phi.version);
+            pushed.push_back(phi.reg);
+            function.definitions[value_t(phi.reg, phi.version)] = pair<unsigned, int>(b, -1);
+        }
+
+        for (unsigned i = 0; i < block.instructions.size(); ++i) {
+            instruction_t& instruction = block.instructions[i];
+            instruction.uses.clear();
+            instruction.defs.clear();
+            for (unsigned k = 0; k < instruction.operands.size(); ++k) {
+                if (reads(instruction.roles[k])) {
+                    unsigned reg = unsigned(stoul(instruction.operands[k]));
+                    instruction.uses.push_back(access_t{ int(k), reg, (stacks[reg].size() ? stacks[reg].back() : 0) });
+                }
+            }
+            if (instruction.mnemonic == "end" or instruction.mnemonic == "halt") {
+                instruction.uses.push_back(access_t{ -1, 0, (stacks[0].size() ? stacks[0].back() : 0) });
+            }
+            for (unsigned k = 0; k < instruction.operands.size(); ++k) {
+                if (writes(instruction.roles[k])) {
+                    unsigned reg = unsigned(stoul(instruction.operands[k]));
+                    unsigned version = ++counters[reg];
+                    instruction.defs.push_back(access_t{ int(k), reg, version });
+                    stacks[reg].push_back(version);
+                    pushed.push_back(reg);
+                    function.definitions[value_t(reg, version)] = pair<unsigned, int>(b, int(i));
+                }
+            }
+        }
+
+        for (unsigned s : block.successors) {
+            block_t& successor = function.blocks[s];
+            for (unsigned j = 0; j < successor.predecessors.size(); ++j) {
+                if (successor.predecessors[j] != b) {
+                    continue;
+                }
+                for (phi_t& phi : successor.phis) {
+                    phi.operands[j] = (stacks[phi.reg].size() ? stacks[phi.reg].back() : 0);
+                }
+            }
+        }
+
+        for (unsigned child : children[b]) {
+            rename(function, child, children, stacks, counters);
+        }
+
+        for (unsigned reg : pushed) {
+            stacks[reg].pop_back();
+        }
+    }
+
+    void ssa(function_t& function) {
+        /** Convert register usage of reachable blocks to SSA form.
+         */
+        dominators(function);
+
+        // dominance frontiers
+        vector<set<unsigned>> frontiers(function.blocks.size());
+        for (unsigned b = 0; b < function.blocks.size(); ++b) {
+            const block_t& block = function.blocks[b];
+            if (not block.reachable or block.predecessors.size() < 2) {
+                continue;
+            }
+            for (unsigned p : block.predecessors) {
+                unsigned runner = p;
+                while (runner != block.idom) {
+                    frontiers[runner].insert(b);
+                    runner = function.blocks[runner].idom;
+                }
+            }
+        }
+
+        // place phi nodes
+        map<unsigned, set<unsigned>> sites;
+        for (unsigned b = 0; b < function.blocks.size(); ++b) {
+            function.blocks[b].phis.clear();
+            if (not function.blocks[b].reachable) {
+                continue;
+            }
+            for (const instruction_t& instruction : function.blocks[b].instructions) {
+                for (unsigned k = 0; k < instruction.operands.size(); ++k) {
+                    if (writes(instruction.roles[k])) {
+                        sites[unsigned(stoul(instruction.operands[k]))].insert(b);
+                    }
+                }
+            }
+        }
+        for (const auto& site : sites) {
+            set<unsigned> placed;
+            vector<unsigned> pending(site.second.begin(), site.second.end());
+            while (pending.size()) {
+                unsigned b = pending.back();
+                pending.pop_back();
+                for (unsigned f : frontiers[b]) {
+                    if (placed.count(f)) {
+                        continue;
+                    }
+                    placed.insert(f);
+                    function.blocks[f].phis.push_back(phi_t{ site.first, 0, vector<unsigned>(function.blocks[f].predecessors.size(), 0) });
+                    if (site.second.count(f) == 0) {
+                        pending.push_back(f);
+                    }
+                }
+            }
+        }
+
+        // rename registers walking the dominator tree
+        vector<vector<unsigned>> children(function.blocks.size());
+        for (unsigned b = 1; b < function.blocks.size(); ++b) {
+            if (function.blocks[b].reachable) {
+                children[function.blocks[b].idom].push_back(b);
+            }
+        }
+        map<unsigned, vector<unsigned>> stacks;
+        map<unsigned, unsigned> counters;
+        function.definitions.clear();
+        rename(function, 0, children, stacks, counters);
+    }
+
+    unsigned reaching(const function_t& function, unsigned b, unsigned index, unsigned reg) {
+        /** Return version of a register seen by index-th instruction of a block.
+         */
+        while (true) {
+            const block_t& block = function.blocks[b];
+            for (unsigned i = index; i > 0; --i) {
+                const vector<access_t>& defs = block.instructions[i-1].defs;
+                for (auto def = defs.rbegin(); def != defs.rend(); ++def) {
+                    if (def->reg == reg) {
+                        return def->version;
+                    }
+                }
+            }
+            for (const phi_t& phi : block.phis) {
+                if (phi.reg == reg) {
+                    return phi.version;
+                }
+            }
+            if (b == 0) {
+                return 0;
+            }
+            b = block.idom;
+            index = unsigned(function.blocks[b].instructions.size());
+        }
+    }
+
+    const instruction_t* definition(const function_t& function, const value_t& value) {
+        /** Return instruction defining given value, or
+         *  null pointer if the value is defined by a phi node or is the initial (empty) value of the register.
+         */
+        auto site = function.definitions.find(value);
+        if (site == function.definitions.end() or site->second.second < 0) {
+            return nullptr;
+        }
+        return &function.blocks[site->second.first].instructions[unsigned(site->second.second)];
+    }
+
+
+    set<string> closures(const invocables_t& functions) {
+        /** Return names of functions used as closures.
+         *
+         *  Closures run on registers captured from the frame in which they were created, so
+         *  they cannot be represented.
+         */
+        set<string> names;
+        for (const auto& each : functions.bodies) {
+            for (const string& line : each.second) {
+                vector<string> operands = str::chunks(str::sub(line, str::chunk(line).size()));
+                if (str::chunk(line) == "closure" and operands.size() == 2) {
+                    names.insert(operands[1]);
+                }
+            }
+        }
+        return names;
+    }
+
+    vector<string> lower(const function_t& function) {
+        /** Lower IR of a function back to expanded body.
+         */
+        set<unsigned> targeted;
+        for (const block_t& block : function.blocks) {
+            for (const instruction_t& instruction : block.instructions) {
+                targeted.insert(instruction.targets.begin(), instruction.targets.end());
+            }
+            if (block.successors.size() == 1 and not terminating(block.instructions.back().mnemonic) and block.instructions.back().mnemonic != "branch") {
+                targeted.insert(block.successors[0]);
+            }
+        }
+
+        vector<string> labels;
+        for (unsigned b = 0; b < function.blocks.size(); ++b) {
+            string label = ("__ir_" + to_string(b));
+            for (const string& mark : function.blocks[b].marks) {
+                if (not numeric(mark)) {
+                    label = mark;
+                    break;
+                }
+            }
+            labels.push_back(label);
+        }
+
+        vector<string> lines = function.directives;
+        for (unsigned b = 0; b < function.blocks.size(); ++b) {
+            const block_t& block = function.blocks[b];
+            for (const string& mark : block.marks) {
+                lines.push_back(".mark: " + mark);
+            }
+            if (targeted.count(b) and find(block.marks.begin(), block.marks.end(), labels[b]) == block.marks.end()) {
+                lines.push_back(".mark: " + labels[b]);
+            }
+
+            for (const instruction_t& instruction : block.instructions) {
+                vector<string> operands;
+                unsigned t = 0;
+                for (unsigned k = 0; k < instruction.operands.size(); ++k) {
+                    operands.push_back(instruction.roles[k] == 't' ? labels[instruction.targets.at(t++)] : instruction.operands[k]);
+                }
+                if (instruction.mnemonic == "branch") {
+                    operands.resize(1);
+                    operands.push_back(labels[instruction.targets.at(0)]);
+                    if (instruction.targets.at(1) != b+1) {
+                        operands.push_back(labels[instruction.targets.at(1)]);
+                    }
+                }
+
+                string line = instruction.mnemonic;
+                if (operands.size()) {
+                    line += (' ' + str::join(operands, ' '));
+                }
+                if (instruction.tail.size()) {
+                    line += (' ' + instruction.tail);
+                }
+                lines.push_back(line);
+            }
+
+            const instruction_t& last = block.instructions.back();
+            if (not terminating(last.mnemonic) and last.mnemonic != "branch" and block.successors.size() and block.successors[0] != b+1) {
+                lines.push_back("jump " + labels[block.successors[0]]);
+            }
+        }
+        return lines;
+    }
+}
@@ -0,0 +1,411 @@
+#include <limits>
+#include <map>
+#include <set>
+#include <string>
+#include <vector>
+#include <viua/support/string.h>
+#include <viua/front/ir.h>
+using namespace std;
+
+
+/*  Optimization passes built on the SSA form of functions.
+ *
+ *  - constant propagation: tracks integer constants through registers (including phi nodes whose all inputs
+ *    are the same constant), folds integer arithmetic on them into `istore`, and
+ *    replaces branches on constant conditions with jumps,
+ *  - copy propagation: replaces reads of copies with reads of the original register if
+ *    it still holds the copied object,
+ *  - dead code elimination: removes instructions producing values that are never used, and
+ *    blocks that cannot be reached.
+ *
+ *  Passes run at -O2, only for functions that ir::build() can represent.
+ */
+namespace ir {
+    static const set<string> ARITHMETIC = {
+        "iadd", "isub", "imul", "idiv",
+    };
+    static const set<string> COMPARISONS = {
+        "ilt", "ilte", "igt", "igte", "ieq",
+    };
+    // instructions which only create an object in their first operand
+    static const set<string> REMOVABLE = {
+        "nop", "izero", "istore", "fstore", "bstore", "strstore", "vec",
+    };
+
+    struct constants_t {
+        map<value_t, long long> integers;
+        map<value_t, bool> booleans;
+
+        bool truth(const value_t& value, bool& result) const {
+            if (integers.count(value)) {
+                result = (integers.at(value) != 0);
+                return true;
+            }
+            if (booleans.count(value)) {
+                result = booleans.at(value);
+                return true;
+            }
+            return false;
+        }
+    };
+
+    static value_t value(const access_t& access) {
+        return value_t(access.reg, access.version);
+    }
+
+    static bool compute(const string& instr, long long a, long long b, long long& result) {
+        if (instr == "iadd") {
+            result = (a + b);
+        } else if (instr == "isub") {
+            result = (a - b);
+        } else if (instr == "imul") {
+            result = (a * b);
+        } else if (instr == "idiv") {
+            if (b == 0) {
+                return false;
+            }
+            result = (a / b);
+        } else if (instr == "ilt") {
+            result = (a < b);
+        } else if (instr == "ilte") {
+            result = (a <= b);
+        } else if (instr == "igt") {
+            result = (a > b);
+        } else if (instr == "igte") {
+            result = (a >= b);
+        } else if (instr == "ieq") {
+            result = (a == b);
+        } else {
+            return false;
+        }
+        // integers are stored as int by the CPU
+        return (result >= numeric_limits<int>::min() and result <= numeric_limits<int>::max());
+    }
+
+    static constants_t constants(const function_t& function) {
+        /** Find values of registers that are known at compile time.
+         */
+        constants_t known;
+        bool changed = true;
+        while (changed) {
+            changed = false;
+            for (const block_t& block : function.blocks) {
+                if (not block.reachable) {
+                    continue;
+                }
+                for (const phi_t& phi : block.phis) {
+                    value_t defined(phi.reg, phi.version);
+                    if (function.untracked.count(phi.reg) or known.integers.count(defined) or phi.operands.empty()) {
+                        continue;
+                    }
+                    bool constant = true;
+                    for (unsigned version : phi.operands) {
+                        value_t v(phi.reg, version);
+                        constant = (constant and known.integers.count(v) and known.integers.at(v) == known.integers.at(value_t(phi.reg, phi.operands[0])));
+                    }
+                    if (constant) {
+                        known.integers[defined] = known.integers.at(value_t(phi.reg, phi.operands[0]));
+                        changed = true;
+                    }
+                }
+
+                for (const instruction_t& instruction : block.instructions) {
+                    if (instruction.defs.size() != 1 or function.untracked.count(instruction.defs[0].reg)) {
+                        continue;
+                    }
+                    value_t defined = value(instruction.defs[0]);
+                    if (known.integers.count(defined) or known.booleans.count(defined)) {
+                        continue;
+                    }
+
+                    const string& instr = instruction.mnemonic;
+                    long long result = 0;
+                    bool truth = false;
+                    if (instr == "izero") {
+                        known.integers[defined] = 0;
+                    } else if (instr == "istore" and str::isnum(instruction.operands[1])) {
+                        try {
+                            known.integers[defined] = stoi(instruction.operands[1]);
+                        } catch (const std::out_of_range& e) {
+                            continue;
+                        }
+                    } else if (instr == "bstore" and str::isnum(instruction.operands[1], false)) {
+                        // byte is not an integer, but its value as a branch condition is known
+                        known.booleans[defined] = (stoi(instruction.operands[1]) != 0);
+                    } else if ((instr == "iinc" or instr == "idec") and known.integers.count(value(instruction.uses[0]))) {
+                        result = known.integers.at(value(instruction.uses[0])) + (instr == "iinc" ? 1 : -1);
+                        if (result < numeric_limits<int>::min() or result > numeric_limits<int>::max()) {
+                            continue;
+                        }
+                        known.integers[defined] = result;
+                    } else if (instr == "copy" and known.integers.count(value(instruction.uses[0]))) {
+                        known.integers[defined] = known.integers.at(value(instruction.uses[0]));
+                    } else if (instr == "copy" and known.booleans.count(value(instruction.uses[0]))) {
+                        known.booleans[defined] = known.booleans.at(value(instruction.uses[0]));
+                    } else if (instr == "not" and known.truth(value(instruction.uses[0]), truth)) {
+                        known.booleans[defined] = not truth;
+                    } else if ((ARITHMETIC.count(instr) or COMPARISONS.count(instr)) and instruction.uses.size() == 2 and
+                               known.integers.count(value(instruction.uses[0])) and known.integers.count(value(instruction.uses[1]))) {
+                        if (not compute(instr, known.integers.at(value(instruction.uses[0])), known.integers.at(value(instruction.uses[1])), result)) {
+                            continue;
+                        }
+                        if (ARITHMETIC.count(instr)) {
+                            known.integers[defined] = result;
+                        } else {
+                            known.booleans[defined] = (result != 0);
+                        }
+                    } else {
+                        continue;
+                    }
+                    changed = true;
+                }
+            }
+        }
+        return known;
+    }
+
+
+    unsigned propagateConstants(function_t& function) {
+        /** Fold arithmetic on constants, and branches on constant conditions.
+         *
+         *  Returns number of folded instructions.
+         */
+        constants_t known = constants(function);
+
+        unsigned folded = 0;
+        bool branches = false;
+        for (block_t& block : function.blocks) {
+            if (not block.reachable) {
+                continue;
+            }
+            for (instruction_t& instruction : block.instructions) {
+                bool truth = false;
+                if (ARITHMETIC.count(instruction.mnemonic) and instruction.defs.size() == 1 and known.integers.count(value(instruction.defs[0]))) {
+                    instruction.mnemonic = "istore";
+                    instruction.operands = { instruction.operands[0], to_string(known.integers.at(value(instruction.defs[0]))) };
+                    instruction.roles = roles("istore", 2);
+                    ++folded;
+                } else if (instruction.mnemonic == "branch" and known.truth(value(instruction.uses[0]), truth)) {
+                    unsigned target = instruction.targets.at(truth ? 0 : 1);
+                    instruction.mnemonic = "jump";
+                    instruction.operands = { "" };
+                    instruction.roles = roles("jump", 1);
+                    instruction.targets = { target };
+                    ++folded;
+                    branches = true;
+                }
+            }
+        }
+
+        if (branches) {
+            link(function);
+        }
+        if (folded) {
+            ssa(function);
+        }
+        return folded;
+    }
+
+    unsigned propagateCopies(function_t& function) {
+        /** Replace reads of copies with reads of copied registers.
+         *
+         *  A read of register B, whose value was set by `copy B A`, is replaced with a read of A if
+         *  A still holds the same version at the point of the read.
+         *  Returns number of replaced operands.
+         */
+        unsigned propagated = 0;
+        bool changed = true;
+        while (changed) {
+            changed = false;
+            for (unsigned b = 0; b < function.blocks.size(); ++b) {
+                block_t& block = function.blocks[b];
+                if (not block.reachable) {
+                    continue;
+                }
+                for (unsigned i = 0; i < block.instructions.size(); ++i) {
+                    instruction_t& instruction = block.instructions[i];
+                    for (access_t& use : instruction.uses) {
+                        if (use.operand < 0 or instruction.roles[unsigned(use.operand)] != 'u' or function.untracked.count(use.reg)) {
+                            continue;
+                        }
+                        const instruction_t* source = definition(function, value(use));
+                        if (source == nullptr or source->mnemonic != "copy") {
+                            continue;
+                        }
+                        const access_t& original = source->uses.at(0);
+                        if (original.reg == use.reg or function.untracked.count(original.reg)) {
+                            continue;
+                        }
+                        if (reaching(function, b, i, original.reg) != original.version) {
+                            continue;
+                        }
+                        instruction.operands[unsigned(use.operand)] = to_string(original.reg);
+                        use.reg = original.reg;
+                        use.version = original.version;
+                        ++propagated;
+                        changed = true;
+                    }
+                }
+            }
+        }
+        if (propagated) {
+            ssa(function);
+        }
+        return propagated;
+    }
+
+    static bool removable(const function_t& function, const constants_t& known, const instruction_t& instruction) {
+        for (const access_t& def : instruction.defs) {
+            if (function.untracked.count(def.reg)) {
+                return false;
+            }
+        }
+        const string& instr = instruction.mnemonic;
+        if (REMOVABLE.count(instr)) {
+            return true;
+        }
+        if (instr == "copy") {
+            // copy throws if the source register is empty, so
+            // it is removable only if the source is known to hold an object
+            const instruction_t* source = definition(function, value(instruction.uses.at(0)));
+            if (source == nullptr) {
+                return false;
+            }
+            for (const access_t& def : source->defs) {
+                if (def.reg == instruction.uses[0].reg and def.version == instruction.uses[0].version) {
+                    char role = source->roles[unsigned(def.operand)];
+                    return (role == 'd' or role == 'm');
+                }
+            }
+            return false;
+        }
+        if (ARITHMETIC.count(instr) or COMPARISONS.count(instr)) {
+            // arithmetic may throw, unless its operands are known
+            return (known.integers.count(value(instruction.defs.at(0))) or known.booleans.count(value(instruction.defs.at(0))));
+        }
+        return false;
+    }
+
+    unsigned eliminateDeadCode(function_t& function) {
+        /** Remove unreachable blocks, and instructions producing values which are never used.
+         *
+         *  Returns number of removed instructions.
+         */
+        unsigned eliminated = 0;
+        for (const block_t& block : function.blocks) {
+            if (not block.reachable) {
+                eliminated += unsigned(block.instructions.size());
+            }
+        }
+        if (eliminated) {
+            prune(function);
+            ssa(function);
+        }
+
+        constants_t known = constants(function);
+
+        set<pair<unsigned, unsigned>> live;
+        set<value_t> used;
+        vector<value_t> pending;
+        for (unsigned b = 0; b < function.blocks.size(); ++b) {
+            for (unsigned i = 0; i < function.blocks[b].instructions.size(); ++i) {
+                const instruction_t& instruction = function.blocks[b].instructions[i];
+                if (removable(function, known, instruction)) {
+                    continue;
+                }
+                live.insert({ b, i });
+                for (const access_t& use : instruction.uses) {
+                    pending.push_back(value(use));
+                }
+            }
+        }
+        while (pending.size()) {
+            value_t v = pending.back();
+            pending.pop_back();
+            if (used.count(v) or v.second == 0) {
+                continue;
+            }
+            used.insert(v);
+
+            const pair<unsigned, int>& site = function.definitions.at(v);
+            if (site.second < 0) {
+                for (const phi_t& phi : function.blocks[site.first].phis) {
+                    if (phi.reg == v.first and phi.version == v.second) {
+                        for (unsigned version : phi.operands) {
+                            pending.push_back(value_t(phi.reg, version));
+                        }
+                    }
+                }
+                continue;
+            }
+            if (live.insert({ site.first, unsigned(site.second) }).second) {
+                for (const access_t& use : function.blocks[site.first].instructions[unsigned(site.second)].uses) {
+                    pending.push_back(value(use));
+                }
+            }
+        }
+
+        unsigned removed = 0;
+        for (unsigned b = 0; b < function.blocks.size(); ++b) {
+            vector<instruction_t> kept;
+            for (unsigned i = 0; i < function.blocks[b].instructions.size(); ++i) {
+                if (live.count({ b, i })) {
+                    kept.push_back(function.blocks[b].instructions[i]);
+                }
+            }
+            unsigned count = unsigned(function.blocks[b].instructions.size() - kept.size());
+            if (kept.empty()) {
+                // blocks must not be empty, they keep their marks and fall through to the next block
+                kept.push_back(instruction_t{ "nop", {}, "", "", {}, {}, {} });
+                if (function.blocks[b].instructions.size() == 1 and function.blocks[b].instructions[0].mnemonic == "nop") {
+                    count = 0;
+                }
+            }
+            removed += count;
+            function.blocks[b].instructions = kept;
+        }
+        if (removed) {
+            ssa(function);
+        }
+        return (eliminated + removed);
+    }
+
+
+    report_t optimize(invocables_t& functions, bool as_lib) {
+        /** Optimize functions using their SSA form.
+         *
+         *  Bodies of functions are replaced only if any of the passes changed them.
+         *  Libraries are not optimized, as their functions may be called by code that
+         *  was not available at compile time and inspect frames in ways passes do not anticipate.
+         */
+        report_t report = { 0, 0, 0, 0 };
+        if (as_lib) {
+            return report;
+        }
+
+        set<string> closures = ir::closures(functions);
+
+        for (auto& each : functions.bodies) {
+            if (closures.count(each.first)) {
+                continue;
+            }
+            function_t function;
+            if (not build(each.second, function)) {
+                continue;
+            }
+            ssa(function);
+
+            unsigned folded = propagateConstants(function);
+            unsigned propagated = propagateCopies(function);
+            unsigned eliminated = eliminateDeadCode(function);
+            if (folded or propagated or eliminated) {
+                each.second = lower(function);
+                ++report.functions;
+                report.folded += folded;
+                report.propagated += propagated;
+                report.eliminated += eliminated;
+            }
+        }
+        return report;
+    }
+}
@@ -0,0 +1,122 @@
+#include <algorithm>
+#include <fstream>
+#include <map>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <viua/support/string.h>
+#include <viua/front/asm.h>
+using namespace std;
+
+
+/*  Profile-guided layout of functions and blocks.
+ *
+ *  Functions and blocks are placed in the module in source order unless a profile written by
+ *  `viua-cpu --profile <file>` is given with `--profile-use <file>`.
+ *  Profile lists number of instructions executed in each function and block, and code is laid out so that
+ *  hot (i.e. executed) code is packed together:
+ *
+ *      cold blocks | hot blocks (ascending) | hot functions (descending) | cold functions
+ *
+ *  Blocks always come before functions in bytecode so cold blocks (e.g. `catch` handlers that were never
+ *  executed) are moved to the very beginning of the module, away from the hottest code.
+ *  Relative order of cold code is not changed.
+ *
+ *  Layout is not changed if any function or block falls through to the next one (i.e. it does not end with
+ *  a terminating instruction), or if absolute (`.<index>`) or byte (`0x<offset>`) jumps are used, as the
+ *  code would change its meaning when moved.
+ *  Addresses of functions and blocks, and the jump table are computed after the layout is decided.
+ */
+namespace layout {
+    static bool terminating(const string& instr) {
+        return (instr == "end" or instr == "tailcall" or instr == "halt" or instr == "jump" or instr == "leave" or instr == "throw");
+    }
+
+    static bool movable(const vector<string>& body) {
+        /** Return true if a body can be moved in the module without changing its meaning.
+         */
+        auto last = find_if(body.rbegin(), body.rend(), [](const string& line) { return not str::startswith(line, "."); });
+        if (last == body.rend() or not terminating(str::chunk(*last))) {
+            return false;
+        }
+        for (const string& line : body) {
+            string instr = str::chunk(line);
+            if (instr != "jump" and instr != "branch") {
+                continue;
+            }
+            vector<string> ops = str::chunks(str::sub(line, instr.size()));
+            for (unsigned i = (instr == "jump" ? 0 : 1); i < ops.size(); ++i) {
+                if (ops[i][0] == '.' or str::startswith(ops[i], "0x")) {
+                    return false;
+                }
+            }
+        }
+        return true;
+    }
+
+    static vector<string> arrange(const invocables_t& invocables, const map<string, uint64_t>& counts, bool hot_last, unsigned& hot_count) {
+        /** Return names of functions or blocks with hot ones packed at the beginning (or at the end).
+         */
+        vector<string> hot, cold;
+        for (const string& name : invocables.names) {
+            bool hot_code = (invocables.bodies.count(name) and counts.count(name) and counts.at(name) > 0);
+            (hot_code ? hot : cold).push_back(name);
+        }
+        stable_sort(hot.begin(), hot.end(), [&counts, hot_last](const string& a, const string& b) {
+            return (hot_last ? counts.at(a) < counts.at(b) : counts.at(a) > counts.at(b));
+        });
+        hot_count = unsigned(hot.size());
+
+        vector<string> names = (hot_last ? cold : hot);
+        const vector<string>& rest = (hot_last ? hot : cold);
+        names.insert(names.end(), rest.begin(), rest.end());
+        return names;
+    }
+
+    bool load(const string& path, profile_t& profile) {
+        /** Load profile written by the CPU.
+         *
+         *  Each line of the profile is: <function|block> <name> <entries> <executed instructions>
+         *  Returns false if the profile cannot be read.
+         */
+        ifstream in(path);
+        if (not in) {
+            return false;
+        }
+        string line;
+        while (getline(in, line)) {
+            vector<string> fields = str::chunks(line);
+            if (fields.size() == 0) {
+                continue;
+            }
+            if (fields.size() != 4 or (fields[0] != "function" and fields[0] != "block") or not (str::isnum(fields[2], false) and str::isnum(fields[3], false))) {
+                return false;
+            }
+            (fields[0] == "block" ? profile.blocks : profile.functions)[fields[1]] += stoull(fields[3]);
+        }
+        return true;
+    }
+
+    report_t arrange(invocables_t& functions, invocables_t& blocks, const profile_t& profile) {
+        /** Lay out functions and blocks according to a profile.
+         */
+        report_t report;
+        report.arranged = false;
+        report.hot_functions = 0;
+        report.hot_blocks = 0;
+
+        for (const invocables_t* invocables : { &functions, &blocks }) {
+            for (const auto& each : invocables->bodies) {
+                if (not movable(each.second)) {
+                    report.reason = ("'" + each.first + "' falls through to the next function or uses absolute jumps");
+                    return report;
+                }
+            }
+        }
+
+        functions.names = arrange(functions, profile.functions, false, report.hot_functions);
+        blocks.names = arrange(blocks, profile.blocks, true, report.hot_blocks);
+        report.arranged = true;
+        return report;
+    }
+}
@@ -0,0 +1,302 @@
+#include <algorithm>
+#include <map>
+#include <set>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <viua/support/string.h>
+#include <viua/cg/assembler/assembler.h>
+#include <viua/cpu/verifier.h>
+#include <viua/program.h>
+#include <viua/front/asm.h>
+using namespace std;
+
+
+/*  Register liveness analysis.
+ *
+ *  Finds registers used by expanded bodies of functions and blocks (one instruction per line) to
+ *  compute the size of local register set each function requires.
+ *  The sizes are recorded in the module so that the CPU can allocate frames of exactly this size
+ *  instead of the size requested by the caller.
+ *
+ *  Size of register set a function requires is established only when all its registers are known, i.e.
+ *  the function does not use `@` operands, and does not create closures nor is a closure itself (closures
+ *  capture registers of the frame in which they are created, and run on them).
+ *  Functions entering blocks (with `enter` or `catch`) require registers used by the blocks as well, as
+ *  blocks run on registers of the function that entered them.
+ *
+ *  With optimizations enabled registers used by each function are renumbered so that they form a dense
+ *  range starting at 0 (the return value register, which is never moved), and frames created just before
+ *  calls to local functions are shrunk to the size the called function requires.
+ *  Functions exported from libraries, and functions using `ress`, `try`, `enter` or `catch` are never renumbered.
+ */
+namespace liveness {
+    struct usage_t {
+        // whether all registers used by the body are known
+        bool known;
+        // whether registers of the body may be renumbered
+        bool renumberable;
+        set<unsigned> registers;
+        set<string> entered;
+    };
+
+
+    static string mnemonic(const string& line) {
+        return str::chunk(line);
+    }
+
+    static vector<string> operands(const string& line) {
+        return str::chunks(str::sub(line, str::chunk(line).size()));
+    }
+
+    static string kinds(const string& line, unsigned operands_count) {
+        /** Return kinds of operands of an instruction up to the first string operand.
+         *
+         *  Throws std::out_of_range for unknown instructions.
+         */
+        string instr = mnemonic(line);
+        string k = verifier::operandkinds(Program::schema(instr).opcode);
+        k = k.substr(0, k.find('s'));
+
+        // short form of call does not have the return value register
+        if ((instr == "call" or instr == "msg") and operands_count == 1) {
+            k = "";
+        }
+        return k.substr(0, min(k.size(), string::size_type(operands_count)));
+    }
+
+    static usage_t usage(const vector<string>& lines) {
+        /** Find registers used by a body of a function or a block.
+         */
+        usage_t u;
+        u.known = true;
+        u.renumberable = true;
+        u.registers.insert(0);
+
+        map<string, int> names = assembler::ce::getnames(lines);
+        for (const string& line : lines) {
+            if (str::startswith(line, ".name:")) {
+                u.registers.insert(unsigned(names.at(operands(line).at(1))));
+                continue;
+            }
+            if (str::startswith(line, ".")) {
+                continue;
+            }
+
+            string instr = mnemonic(line);
+            vector<string> ops = operands(line);
+            string k;
+            try {
+                k = kinds(line, unsigned(ops.size()));
+            } catch (const std::out_of_range& e) {
+                u.known = false;
+                return u;
+            }
+
+            if (instr == "closure" or instr == "clbind") {
+                u.known = false;
+                return u;
+            }
+            if (instr == "ress" or instr == "try" or instr == "enter" or instr == "catch") {
+                u.renumberable = false;
+            }
+            if (instr == "enter" and ops.size() == 1) {
+                u.entered.insert(ops[0]);
+            } else if (instr == "catch" and ops.size() == 2) {
+                u.entered.insert(ops[1]);
+            }
+
+            for (unsigned i = 0; i < ops.size(); ++i) {
+                if (ops[i][0] == '@') {
+                    u.known = false;
+                    return u;
+                }
+            }
+            for (unsigned i = 0; i < k.size(); ++i) {
+                if (k[i] != 'r') {
+                    continue;
+                }
+                if (str::isnum(ops[i], false)) {
+                    u.registers.insert(unsigned(stoul(ops[i])));
+                } else if (names.count(ops[i])) {
+                    u.registers.insert(unsigned(names.at(ops[i])));
+                } else {
+                    u.known = false;
+                    return u;
+                }
+            }
+        }
+        return u;
+    }
+
+    static string rewrite(const string& line, const string& k, const map<unsigned, unsigned>& mapping) {
+        /** Rewrite register operands of an instruction (given by their kinds) according to the mapping.
+         *
+         *  Operands following the register operands are copied verbatim.
+         */
+        string instr = mnemonic(line);
+        string rest = str::lstrip(str::sub(line, instr.size()));
+
+        ostringstream oss;
+        oss << instr;
+        for (unsigned i = 0; i < k.size(); ++i) {
+            string token = str::chunk(rest);
+            rest = str::lstrip(str::sub(rest, token.size()));
+            if (k[i] == 'r' and str::isnum(token, false)) {
+                token = to_string(mapping.at(unsigned(stoul(token))));
+            }
+            oss << ' ' << token;
+        }
+        if (rest.size()) {
+            oss << ' ' << rest;
+        }
+        return oss.str();
+    }
+
+    static vector<string> renumber(const vector<string>& lines, const set<unsigned>& used) {
+        /** Renumber registers of a body so that they form a dense range.
+         *
+         *  Order of registers is preserved so register 0 is never moved.
+         */
+        map<unsigned, unsigned> mapping;
+        for (unsigned r : used) {
+            unsigned next = unsigned(mapping.size());
+            mapping[r] = next;
+        }
+
+        vector<string> renumbered;
+        for (const string& line : lines) {
+            if (str::startswith(line, ".name:")) {
+                renumbered.push_back(rewrite(line, "r", mapping));
+            } else if (str::startswith(line, ".")) {
+                renumbered.push_back(line);
+            } else {
+                renumbered.push_back(rewrite(line, kinds(line, unsigned(operands(line).size())), mapping));
+            }
+        }
+        return renumbered;
+    }
+
+    static set<string> closures(const invocables_t& functions) {
+        set<string> targets;
+        for (const auto& function : functions.bodies) {
+            for (const string& line : function.second) {
+                if (mnemonic(line) == "closure") {
+                    vector<string> ops = operands(line);
+                    if (ops.size() == 2) { targets.insert(ops[1]); }
+                }
+            }
+        }
+        return targets;
+    }
+
+
+    unsigned renumber(invocables_t& functions, bool as_lib) {
+        /** Renumber registers of functions of a module.
+         *
+         *  Returns number of functions whose register sets were reduced.
+         */
+        if (as_lib) {
+            return 0;
+        }
+
+        set<string> targets = closures(functions);
+        unsigned renumbered = 0;
+        for (auto& function : functions.bodies) {
+            if (targets.count(function.first)) {
+                continue;
+            }
+            usage_t u = usage(function.second);
+            if (not u.known or not u.renumberable or *u.registers.rbegin() < u.registers.size()) {
+                continue;
+            }
+            function.second = renumber(function.second, u.registers);
+            ++renumbered;
+        }
+        return renumbered;
+    }
+
+    map<string, unsigned> registers(const invocables_t& functions, const invocables_t& blocks) {
+        /** Compute sizes of local register sets required by functions of a module.
+         *
+         *  Functions for which the size could not be established are not included in the result.
+         */
+        set<string> targets = closures(functions);
+
+        map<string, usage_t> block_usage;
+        for (const auto& block : blocks.bodies) {
+            block_usage[block.first] = usage(block.second);
+        }
+
+        map<string, unsigned> sizes;
+        for (const auto& function : functions.bodies) {
+            if (targets.count(function.first)) {
+                continue;
+            }
+            usage_t u = usage(function.second);
+
+            // blocks run on registers of the function that entered them
+            set<string> visited;
+            vector<string> pending(u.entered.begin(), u.entered.end());
+            while (u.known and pending.size()) {
+                string block = pending.back();
+                pending.pop_back();
+                if (visited.count(block)) {
+                    continue;
+                }
+                visited.insert(block);
+
+                if (block_usage.count(block) == 0 or not block_usage.at(block).known) {
+                    u.known = false;
+                    break;
+                }
+                const usage_t& b = block_usage.at(block);
+                u.registers.insert(b.registers.begin(), b.registers.end());
+                pending.insert(pending.end(), b.entered.begin(), b.entered.end());
+            }
+
+            if (u.known) {
+                sizes[function.first] = (*u.registers.rbegin() + 1);
+            }
+        }
+        return sizes;
+    }
+
+    unsigned frames(invocables_t& functions, invocables_t& blocks, const map<string, unsigned>& sizes) {
+        /** Resize frames created for calls to local functions to the sizes the functions require.
+         *
+         *  Only frames with literal operands directly followed (in the same basic block) by a call are resized.
+         *  Returns number of shrunk frames.
+         */
+        unsigned shrunk = 0;
+        for (auto* invocables : { &functions, &blocks }) {
+            for (auto& body : invocables->bodies) {
+                vector<string>& lines = body.second;
+                long frame = -1;
+                for (unsigned i = 0; i < lines.size(); ++i) {
+                    string instr = mnemonic(lines[i]);
+                    if (instr == "frame") {
+                        frame = long(i);
+                    } else if ((instr == "call" or instr == "tailcall" or instr == "spawn" or instr == "coroutine") and frame >= 0) {
+                        vector<string> ops = operands(lines[i]);
+                        string callee = (ops.size() == 1 ? ops[0] : ops.size() == 2 ? ops[1] : "");
+                        vector<string> frame_ops = operands(lines[unsigned(frame)]);
+                        string args = (frame_ops.size() > 0 ? frame_ops[0] : "0");
+                        string regs = (frame_ops.size() > 1 ? frame_ops[1] : "16");  // default number of local registers
+                        if (sizes.count(callee) and str::isnum(args, false) and str::isnum(regs, false) and sizes.at(callee) != stoul(regs)) {
+                            // frames too small for the callee are grown as well (CPU would grow them anyway)
+                            if (sizes.at(callee) < stoul(regs)) {
+                                ++shrunk;
+                            }
+                            lines[unsigned(frame)] = ("frame " + args + ' ' + to_string(sizes.at(callee)));
+                        }
+                        frame = -1;
+                    } else if (str::startswith(lines[i], ".mark:") or instr == "call" or instr == "tailcall" or instr == "spawn" or instr == "coroutine" or instr == "fcall" or instr == "msg" or instr == "jump" or instr == "branch") {
+                        frame = -1;
+                    }
+                }
+            }
+        }
+        return shrunk;
+    }
+}
@@ -0,0 +1,584 @@
+#include <climits>
+#include <algorithm>
+#include <map>
+#include <set>
+#include <string>
+#include <vector>
+#include <viua/support/string.h>
+#include <viua/cg/assembler/assembler.h>
+#include <viua/front/asm.h>
+using namespace std;
+
+
+/*  Peephole optimizer.
+ *
+ *  Rewrites are applied to expanded bodies of functions and blocks (one instruction per line) before
+ *  bytecode is generated for them.
+ *  Each rule looks at a few adjacent instructions of a single basic block, i.e. it never matches
+ *  instructions separated by a `.mark:` directive, and never matches instructions with `@` operands.
+ *
+ *      copy-free       copy a b; free b                    =>  move a b
+ *      move-move       move a b; move b a                  =>  move a a
+ *      constant-fold   istore a x; istore b y; iadd r a b  =>  istore a x; istore b y; istore r <x+y>
+ *                      (also isub, imul and idiv)
+ *      branch-to-next  branch c next [next]; .mark: next   =>  .mark: next
+ *      jump-to-next    jump next; .mark: next              =>  .mark: next
+ *      jump-to-jump    jump a; ...; .mark: a; jump b       =>  jump b; ...; .mark: a; jump b
+ *                      (also targets of branch instructions)
+ *      tail-call       call r f; move 0 r; end             =>  tailcall f
+ *                      (also copy instead of move; only in functions, and only for functions defined in the module)
+ *
+ *  Rules which assume something about contents of registers (copy-free and constant-fold) are only applied to
+ *  registers that can never hold a reference nor be referenced, i.e. to registers that are only used by
+ *  instructions which create fresh objects, read them, or move them between such registers.
+ *  Contents of registers are unknown in blocks (they run on registers of the function that entered them),
+ *  in closures (which get references to bound registers), in functions exported from libraries (which may be
+ *  used as closures by other modules), and in functions using `ress`, `try`, `enter`, or `@` operands.
+ *
+ *  Functions using numeric jumps have the jumps converted to marks first so that removing instructions
+ *  does not shift their targets.
+ *  Functions using absolute (`.<index>`) or byte (`0x<offset>`) jumps are not optimized.
+ */
+namespace peephole {
+    static const vector<string> RULES = {
+        "copy-free",
+        "move-move",
+        "constant-fold",
+        "branch-to-next",
+        "jump-to-next",
+        "jump-to-jump",
+        "tail-call",
+    };
+
+    // instructions which never create references nor let other instructions reference their operands
+    static const set<string> REFERENCE_FREE = {
+        "nop", "izero", "istore", "iinc", "idec",
+        "iadd", "isub", "imul", "idiv", "ilt", "ilte", "igt", "igte", "ieq",
+        "fstore", "fadd", "fsub", "fmul", "fdiv", "flt", "flte", "fgt", "fgte", "feq",
+        "bstore", "strstore", "itof", "ftoi", "stoi", "stof",
+        "not", "and", "or", "isnull", "print", "echo", "copy", "free", "empty",
+        "frame", "jump", "branch", "end", "halt", "leave",
+        // move and swap carry references between registers, this is handled separately
+        "move", "swap",
+    };
+
+    // instructions creating fresh object in the register given as their first operand
+    static const set<string> PRODUCERS = {
+        "izero", "istore",
+        "iadd", "isub", "imul", "idiv", "ilt", "ilte", "igt", "igte", "ieq",
+        "fstore", "fadd", "fsub", "fmul", "fdiv", "flt", "flte", "fgt", "fgte", "feq",
+        "bstore", "strstore", "itof", "ftoi", "stoi", "stof",
+        "not", "and", "or", "isnull", "vec",
+    };
+
+
+    struct body_t {
+        vector<string> lines;
+        map<string, int> names;
+
+        // line indexes of instructions, and
+        // instruction index each mark points to
+        vector<unsigned> instructions;
+        map<string, unsigned> marks;
+
+        // registers whose contents are known not to be references
+        bool registers_known;
+        set<int> unsafe;
+
+        // functions which may be called in tail position (empty for blocks)
+        set<string> tail_callable;
+    };
+
+
+    static string mnemonic(const string& line) {
+        return str::chunk(line);
+    }
+
+    static vector<string> operands(const string& line) {
+        return str::chunks(str::sub(line, str::chunk(line).size()));
+    }
+
+    static string assemble(const string& instr, const vector<string>& ops) {
+        return (instr + ' ' + str::join(ops, ' '));
+    }
+
+    static int resolve(const string& token, const map<string, int>& names) {
+        /** Return index of register given as an operand, or
+         *  -1 if the operand is dereferenced or is not a register.
+         */
+        if (str::isnum(token, false)) {
+            return stoi(token);
+        }
+        if (names.count(token)) {
+            return names.at(token);
+        }
+        return -1;
+    }
+
+    static vector<int> registers(const string& line, const map<string, int>& names) {
+        /** Return indexes of registers used by an instruction.
+         *
+         *  Operands which are not registers yield -1.
+         */
+        string instr = mnemonic(line);
+        vector<string> ops = operands(line);
+        if (instr == "jump") {
+            ops.clear();
+        } else if (ops.size() and (instr == "branch" or instr == "izero" or instr == "istore" or instr == "fstore" or instr == "bstore" or instr == "strstore" or instr == "vec")) {
+            ops.resize(1);
+        }
+
+        vector<int> regs;
+        for (unsigned k = 0; k < ops.size(); ++k) {
+            regs.push_back(resolve(ops[k], names));
+        }
+        return regs;
+    }
+
+    static bool dereferences(const string& line) {
+        vector<string> ops = operands(line);
+        for (unsigned i = 0; i < ops.size(); ++i) {
+            if (ops[i][0] == '@') { return true; }
+        }
+        return false;
+    }
+
+    static void index(body_t& body) {
+        /** Find instructions and marks of a body.
+         */
+        body.instructions.clear();
+        body.marks.clear();
+        for (unsigned i = 0; i < body.lines.size(); ++i) {
+            const string& line = body.lines[i];
+            if (str::startswith(line, ".mark:")) {
+                body.marks[str::chunk(str::sub(line, 6))] = unsigned(body.instructions.size());
+            } else if (not str::startswith(line, ".")) {
+                body.instructions.push_back(i);
+            }
+        }
+    }
+
+    static bool adjacent(const body_t& body, unsigned first, unsigned last) {
+        /** Return true if instructions in range [first, last] are in the same basic block.
+         */
+        for (unsigned i = body.instructions[first]+1; i < body.instructions[last]; ++i) {
+            if (str::startswith(body.lines[i], ".mark:")) { return false; }
+        }
+        return true;
+    }
+
+    static bool markjumps(body_t& body) {
+        /** Convert numeric jump targets to marks.
+         *
+         *  Returns false if the body uses jumps that cannot be converted.
+         */
+        index(body);
+
+        map<unsigned, string> targets;
+        for (auto mark : body.marks) {
+            // marks with names which look like numeric jumps are not reused
+            if (str::isnum(mark.first) or mark.first[0] == '+' or mark.first[0] == '.' or mark.first.substr(0, 2) == "0x") {
+                continue;
+            }
+            targets.insert(pair<unsigned, string>(mark.second, mark.first));
+        }
+
+        vector<string> rewritten = body.lines;
+        map<unsigned, string> new_marks;
+        for (unsigned n = 0; n < body.instructions.size(); ++n) {
+            const string& line = body.lines[body.instructions[n]];
+            string instr = mnemonic(line);
+            if (instr != "jump" and instr != "branch") {
+                continue;
+            }
+
+            vector<string> ops = operands(line);
+            for (unsigned k = (instr == "jump" ? 0 : 1); k < ops.size(); ++k) {
+                string& target = ops[k];
+                long target_index = 0;
+                if (str::isnum(target, false)) {
+                    target_index = stol(target);
+                } else if (target[0] == '+' and str::isnum(str::sub(target, 1), false)) {
+                    target_index = long(n) + stol(str::sub(target, 1));
+                } else if (target[0] == '-' and str::isnum(str::sub(target, 1), false)) {
+                    target_index = long(n) - stol(str::sub(target, 1));
+                } else if (target[0] == '.' or target.substr(0, 2) == "0x" or body.marks.count(target) == 0) {
+                    return false;
+                } else {
+                    continue;
+                }
+
+                if (target_index < 0 or target_index >= long(body.instructions.size())) {
+                    return false;
+                }
+                unsigned t = unsigned(target_index);
+                if (targets.count(t) == 0) {
+                    targets[t] = ("__peephole_" + to_string(t));
+                    new_marks[t] = targets[t];
+                }
+                target = targets[t];
+            }
+            rewritten[body.instructions[n]] = assemble(instr, ops);
+        }
+
+        body.lines.clear();
+        for (unsigned i = 0, n = 0; i < rewritten.size(); ++i) {
+            if (n < body.instructions.size() and body.instructions[n] == i) {
+                if (new_marks.count(n)) {
+                    body.lines.push_back(".mark: " + new_marks[n]);
+                }
+                ++n;
+            }
+            body.lines.push_back(rewritten[i]);
+        }
+        index(body);
+        return true;
+    }
+
+    static set<int> unsafeRegisters(const body_t& body, const set<unsigned>& ignored) {
+        /** Find registers which may hold references or be referenced by instructions other than the ignored ones.
+         */
+        set<int> unsafe;
+        for (unsigned n = 0; n < body.instructions.size(); ++n) {
+            string instr = mnemonic(body.lines[body.instructions[n]]);
+            if (ignored.count(n) == 0 and REFERENCE_FREE.count(instr) == 0) {
+                for (int reg : registers(body.lines[body.instructions[n]], body.names)) {
+                    if (reg >= 0) { unsafe.insert(reg); }
+                }
+            }
+        }
+
+        bool changed = true;
+        while (changed) {
+            changed = false;
+            for (unsigned n = 0; n < body.instructions.size(); ++n) {
+                const string& line = body.lines[body.instructions[n]];
+                string instr = mnemonic(line);
+                if (ignored.count(n) or (instr != "move" and instr != "swap")) {
+                    continue;
+                }
+                vector<string> ops = operands(line);
+                int a = resolve(ops.at(0), body.names), b = resolve(ops.at(1), body.names);
+                if (unsafe.count(a) != unsafe.count(b)) {
+                    unsafe.insert(a);
+                    unsafe.insert(b);
+                    changed = true;
+                }
+            }
+        }
+        return unsafe;
+    }
+
+    static void findUnsafeRegisters(body_t& body) {
+        /** Find registers which may hold references or be referenced.
+         */
+        for (unsigned n = 0; n < body.instructions.size() and body.registers_known; ++n) {
+            const string& line = body.lines[body.instructions[n]];
+            string instr = mnemonic(line);
+            if (instr == "ress" or instr == "try" or instr == "enter" or dereferences(line)) {
+                body.registers_known = false;
+            }
+        }
+        if (body.registers_known) {
+            body.unsafe = unsafeRegisters(body, {});
+        }
+    }
+
+    static bool safe(const body_t& body, int reg) {
+        return (body.registers_known and reg >= 0 and body.unsafe.count(reg) == 0);
+    }
+
+    static bool defined(const body_t& body, unsigned n, int reg) {
+        /** Return true if register is known to be non-empty before n-th instruction.
+         *
+         *  This is the case when the register was set by an instruction creating fresh object earlier
+         *  in the same basic block, and was only read since then.
+         */
+        if (reg < 0) {
+            return false;
+        }
+        while (n > 0 and adjacent(body, n-1, n)) {
+            const string& line = body.lines[body.instructions[--n]];
+            string instr = mnemonic(line);
+            if (instr == "ress" or instr == "try" or instr == "enter" or dereferences(line)) {
+                return false;
+            }
+
+            vector<int> regs = registers(line, body.names);
+            if (find(regs.begin(), regs.end(), reg) == regs.end()) {
+                continue;
+            }
+            if (PRODUCERS.count(instr) and regs[0] == reg) {
+                return true;
+            }
+            if (PRODUCERS.count(instr) or instr == "print" or instr == "echo" or (instr == "copy" and regs[0] != reg)) {
+                // register is only read
+                continue;
+            }
+            return false;
+        }
+        return false;
+    }
+
+    static long target(const body_t& body, const string& mark) {
+        return (body.marks.count(mark) ? long(body.marks.at(mark)) : -1L);
+    }
+
+
+    static bool copyFree(body_t& body, unsigned n) {
+        if (n+1 >= body.instructions.size() or not adjacent(body, n, n+1)) { return false; }
+        const string& copy = body.lines[body.instructions[n]];
+        const string& free = body.lines[body.instructions[n+1]];
+        if (mnemonic(copy) != "copy" or mnemonic(free) != "free") { return false; }
+
+        vector<string> copy_ops = operands(copy), free_ops = operands(free);
+        if (copy_ops.size() != 2 or free_ops.size() != 1) { return false; }
+        int destination = resolve(copy_ops[0], body.names), source = resolve(copy_ops[1], body.names);
+        if (destination == source or resolve(free_ops[0], body.names) != source) { return false; }
+        if (not (safe(body, destination) and safe(body, source) and defined(body, n, source))) { return false; }
+
+        body.lines[body.instructions[n]] = assemble("move", copy_ops);
+        body.lines.erase(body.lines.begin()+body.instructions[n+1]);
+        return true;
+    }
+
+    static bool moveMove(body_t& body, unsigned n) {
+        /*  The pair leaves second register untouched and empties the first one
+         *  without destroying the object it held, and
+         *  this is exactly what moving a register onto itself does.
+         */
+        if (n+1 >= body.instructions.size() or not adjacent(body, n, n+1)) { return false; }
+        const string& first = body.lines[body.instructions[n]];
+        const string& second = body.lines[body.instructions[n+1]];
+        if (mnemonic(first) != "move" or mnemonic(second) != "move") { return false; }
+
+        vector<string> first_ops = operands(first), second_ops = operands(second);
+        if (first_ops.size() != 2 or second_ops.size() != 2) { return false; }
+        int a = resolve(first_ops[0], body.names), b = resolve(first_ops[1], body.names);
+        if (a < 0 or b < 0 or a == b) { return false; }
+        if (resolve(second_ops[0], body.names) != b or resolve(second_ops[1], body.names) != a) { return false; }
+
+        body.lines[body.instructions[n]] = assemble("move", {first_ops[0], first_ops[0]});
+        body.lines.erase(body.lines.begin()+body.instructions[n+1]);
+        return true;
+    }
+
+    static bool constantFold(body_t& body, unsigned n) {
+        if (n+2 >= body.instructions.size() or not adjacent(body, n, n+2)) { return false; }
+        const string& operation = body.lines[body.instructions[n+2]];
+        string instr = mnemonic(operation);
+        if (instr != "iadd" and instr != "isub" and instr != "imul" and instr != "idiv") { return false; }
+
+        map<int, long long> values;
+        for (unsigned k = n; k < n+2; ++k) {
+            const string& line = body.lines[body.instructions[k]];
+            vector<string> ops = operands(line);
+            if (mnemonic(line) != "istore" or ops.size() != 2 or not str::isnum(ops[1])) { return false; }
+            int reg = resolve(ops[0], body.names);
+            if (not safe(body, reg)) { return false; }
+            values[reg] = stoll(ops[1]);
+        }
+
+        vector<string> ops = operands(operation);
+        if (ops.size() != 3 or resolve(ops[0], body.names) < 0) { return false; }
+        int a = resolve(ops[1], body.names), b = resolve(ops[2], body.names);
+        if (values.count(a) == 0 or values.count(b) == 0) { return false; }
+
+        long long x = values[a], y = values[b], result = 0;
+        if (instr == "iadd") {
+            result = x + y;
+        } else if (instr == "isub") {
+            result = x - y;
+        } else if (instr == "imul") {
+            result = x * y;
+        } else {
+            if (y == 0) { return false; }
+            result = x / y;
+        }
+        if (x < INT_MIN or x > INT_MAX or y < INT_MIN or y > INT_MAX or result < INT_MIN or result > INT_MAX) { return false; }
+
+        body.lines[body.instructions[n+2]] = assemble("istore", {ops[0], to_string(result)});
+        return true;
+    }
+
+    static bool branchToNext(body_t& body, unsigned n) {
+        const string& line = body.lines[body.instructions[n]];
+        if (mnemonic(line) != "branch") { return false; }
+
+        vector<string> ops = operands(line);
+        if (ops.size() < 2 or ops.size() > 3) { return false; }
+        for (unsigned k = 1; k < ops.size(); ++k) {
+            if (target(body, ops[k]) != long(n+1)) { return false; }
+        }
+        if (n+1 >= body.instructions.size() or not defined(body, n, resolve(ops[0], body.names))) { return false; }
+
+        body.lines.erase(body.lines.begin()+body.instructions[n]);
+        return true;
+    }
+
+    static bool jumpToNext(body_t& body, unsigned n) {
+        const string& line = body.lines[body.instructions[n]];
+        if (mnemonic(line) != "jump") { return false; }
+
+        vector<string> ops = operands(line);
+        if (ops.size() != 1 or target(body, ops[0]) != long(n+1) or n+1 >= body.instructions.size()) { return false; }
+
+        body.lines.erase(body.lines.begin()+body.instructions[n]);
+        return true;
+    }
+
+    static bool jumpToJump(body_t& body, unsigned n) {
+        const string& line = body.lines[body.instructions[n]];
+        string instr = mnemonic(line);
+        if (instr != "jump" and instr != "branch") { return false; }
+
+        vector<string> ops = operands(line);
+        bool rewritten = false;
+        for (unsigned k = (instr == "jump" ? 0 : 1); k < ops.size(); ++k) {
+            string mark = ops[k];
+            set<string> visited = {mark};
+            bool loops = false;
+            while (true) {
+                long t = target(body, mark);
+                if (t < 0 or t >= long(body.instructions.size())) { break; }
+                const string& next = body.lines[body.instructions[unsigned(t)]];
+                vector<string> next_ops = operands(next);
+                if (mnemonic(next) != "jump" or next_ops.size() != 1) { break; }
+                if (visited.count(next_ops[0])) {
+                    loops = true;
+                    break;
+                }
+                mark = next_ops[0];
+                visited.insert(mark);
+            }
+            if (loops or mark == ops[k]) {
+                continue;
+            }
+            ops[k] = mark;
+            rewritten = true;
+        }
+
+        if (rewritten) {
+            body.lines[body.instructions[n]] = assemble(instr, ops);
+        }
+        return rewritten;
+    }
+
+
+    static bool tailCall(body_t& body, unsigned n) {
+        /*  Function called right before returning its value can return directly to the caller, and
+         *  run in the frame of the current function.
+         */
+        if (n+2 >= body.instructions.size() or not adjacent(body, n, n+2)) { return false; }
+        const string& call = body.lines[body.instructions[n]];
+        const string& result = body.lines[body.instructions[n+1]];
+        const string& end = body.lines[body.instructions[n+2]];
+        if (mnemonic(call) != "call" or (mnemonic(result) != "move" and mnemonic(result) != "copy") or mnemonic(end) != "end") { return false; }
+
+        vector<string> call_ops = operands(call), result_ops = operands(result);
+        if (call_ops.size() != 2 or result_ops.size() != 2 or body.tail_callable.count(call_ops[1]) == 0) { return false; }
+        int returned = resolve(call_ops[0], body.names);
+        if (returned <= 0 or resolve(result_ops[0], body.names) != 0 or resolve(result_ops[1], body.names) != returned) { return false; }
+        // the call and the move only pass the returned object along, but no other instruction may make
+        // the registers hold or share references (placing returned object in them would modify referenced objects);
+        // move does not look at previous contents of its destination, and copy does
+        if (not body.registers_known) { return false; }
+        set<int> unsafe = unsafeRegisters(body, { n, n+1 });
+        if (unsafe.count(returned) or (mnemonic(result) == "copy" and unsafe.count(0))) { return false; }
+
+        body.lines[body.instructions[n]] = ("tailcall " + call_ops[1]);
+        body.lines.erase(body.lines.begin()+body.instructions[n+2]);
+        body.lines.erase(body.lines.begin()+body.instructions[n+1]);
+        return true;
+    }
+
+
+    const vector<string>& rules() {
+        return RULES;
+    }
+
+    static vector<string> optimize(const vector<string>& lines, bool registers_known, const set<string>& tail_callable, map<string, unsigned>& rewrites) {
+        /** Optimize body of a function or block.
+         *
+         *  Rules are applied until none of them matches.
+         *  Number of rewrites made by each rule is added to rewrites map.
+         */
+        body_t body;
+        body.lines = lines;
+        body.names = assembler::ce::getnames(lines);
+        body.registers_known = registers_known;
+        body.tail_callable = tail_callable;
+
+        if (not markjumps(body)) {
+            return lines;
+        }
+        findUnsafeRegisters(body);
+
+        typedef bool (*rule_t)(body_t&, unsigned);
+        const vector<rule_t> rule_functions = { copyFree, moveMove, constantFold, branchToNext, jumpToNext, jumpToJump, tailCall };
+
+        // rules are tried only at instructions which may begin a sequence they rewrite
+        static const multimap<string, unsigned> triggers = {
+            { "copy", 0 },
+            { "move", 1 },
+            { "istore", 2 },
+            { "branch", 3 },
+            { "jump", 4 },
+            { "jump", 5 },
+            { "branch", 5 },
+            { "call", 6 },
+        };
+
+        bool changed = true;
+        while (changed) {
+            changed = false;
+            for (unsigned n = 0; n < body.instructions.size(); ++n) {
+                auto candidates = triggers.equal_range(mnemonic(body.lines[body.instructions[n]]));
+                for (auto r = candidates.first; r != candidates.second; ++r) {
+                    if (rule_functions[r->second](body, n)) {
+                        ++rewrites[RULES[r->second]];
+                        index(body);
+                        changed = true;
+                        break;
+                    }
+                }
+            }
+        }
+
+        return body.lines;
+    }
+
+    map<string, unsigned> optimize(invocables_t& functions, invocables_t& blocks, bool as_lib) {
+        /** Optimize all functions and blocks of a module.
+         *
+         *  Returns number of rewrites made by each rule.
+         */
+        set<string> closures;
+        for (auto function : functions.bodies) {
+            for (const string& line : function.second) {
+                if (mnemonic(line) == "closure") {
+                    vector<string> ops = operands(line);
+                    if (ops.size() == 2) { closures.insert(ops[1]); }
+                }
+            }
+        }
+
+        map<string, unsigned> rewrites;
+        for (const string& rule : RULES) {
+            rewrites[rule] = 0;
+        }
+        set<string> tail_callable;
+        for (auto function : functions.bodies) {
+            tail_callable.insert(function.first);
+        }
+
+        for (auto& function : functions.bodies) {
+            bool registers_known = (not as_lib and closures.count(function.first) == 0);
+            function.second = optimize(function.second, registers_known, tail_callable, rewrites);
+        }
+        for (auto& block : blocks.bodies) {
+            block.second = optimize(block.second, false, set<string>(), rewrites);
+        }
+        return rewrites;
+    }
+}
@@ -0,0 +1,377 @@
+#include <algorithm>
+#include <map>
+#include <set>
+#include <string>
+#include <tuple>
+#include <vector>
+#include <viua/bytecode/opcodes.h>
+#include <viua/bytecode/maps.h>
+#include <viua/support/string.h>
+#include <viua/cg/disassembler/disassembler.h>
+#include <viua/program.h>
+#include <viua/front/asm.h>
+using namespace std;
+
+
+/*  Unreachable code elimination.
+ *
+ *  Functions and blocks (local, and from statically linked modules) are reachable if they are
+ *  referenced by reachable code, starting with the main function, code outside of functions (i.e. the
+ *  entry function), and names given with `--keep` option.
+ *  Code is referenced by `call`, `function`, `closure`, `attach`, `catch` and `enter` instructions, and
+ *  by the preceding function or block if it does not end with a terminating instruction.
+ *  Bodies of functions and blocks from linked modules are disassembled to find their references.
+ *
+ *  Unreachable functions and blocks are removed, and bytecode of linked modules is compacted (with
+ *  their jump tables adjusted).
+ *  If local code uses absolute jumps, or a linked module cannot be compacted (e.g. it contains absolute
+ *  jumps which are not listed in its jump table, or bytecode which does not belong to any function)
+ *  nothing is removed as it is not possible to tell what code is referenced.
+ */
+namespace reachability {
+    typedef tuple<uint32_t, uint32_t, string> extent_t;     // (begin, end, name)
+
+    struct module_t {
+        vector<extent_t> extents;
+        map<string, set<string>> references;
+    };
+
+
+    static void references(const string& line, set<string>& refs) {
+        /** Add functions and blocks referenced by an instruction to refs.
+         */
+        string instr = str::chunk(line);
+        if (instr != "call" and instr != "tailcall" and instr != "spawn" and instr != "coroutine" and instr != "function" and instr != "closure" and instr != "attach" and instr != "enter" and instr != "catch") {
+            return;
+        }
+        vector<string> ops = str::chunks(str::sub(line, instr.size()));
+        if (ops.size() == 0) {
+            return;
+        }
+        if (instr == "call") {
+            refs.insert(ops.size() == 1 ? ops[0] : ops[1]);
+        } else if (instr == "coroutine" and ops.size() > 1) {
+            refs.insert(ops[1]);
+        } else if (instr == "tailcall" or instr == "spawn") {
+            refs.insert(ops[0]);
+        } else if ((instr == "function" or instr == "closure" or instr == "attach") and ops.size() > 1) {
+            refs.insert(ops[1]);
+        } else if (instr == "enter" or instr == "catch") {
+            refs.insert(ops.back());
+        }
+    }
+
+    static bool absolute(const string& line) {
+        /** Return true if an instruction jumps to absolute instruction index or byte offset.
+         *
+         *  Such jumps may lead to any function or block so nothing can be removed when they are used.
+         */
+        string instr = str::chunk(line);
+        if (instr != "jump" and instr != "branch") {
+            return false;
+        }
+        vector<string> ops = str::chunks(str::sub(line, instr.size()));
+        for (unsigned i = (instr == "jump" ? 0 : 1); i < ops.size(); ++i) {
+            if (ops[i][0] == '.' or str::startswith(ops[i], "0x")) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    static bool terminating(const string& instr) {
+        return (instr == "end" or instr == "tailcall" or instr == "halt" or instr == "jump" or instr == "branch" or instr == "leave" or instr == "throw");
+    }
+
+    static long find(const vector<extent_t>& extents, uint32_t address) {
+        /** Return index of extent containing given address, or -1.
+         */
+        for (unsigned i = 0; i < extents.size(); ++i) {
+            if (get<0>(extents[i]) <= address and address < get<1>(extents[i])) {
+                return long(i);
+            }
+        }
+        return -1;
+    }
+
+    static bool decode(const linkedmodule_t& module, module_t& decoded) {
+        /** Split bytecode of a linked module into functions and blocks, and find their references.
+         *
+         *  Returns false if the module cannot be compacted.
+         */
+        vector<pair<uint32_t, string>> entries;
+        for (auto fn : module.function_addresses) { entries.push_back(pair<uint32_t, string>(fn.second, fn.first)); }
+        for (auto bl : module.block_addresses) { entries.push_back(pair<uint32_t, string>(bl.second, bl.first)); }
+        sort(entries.begin(), entries.end());
+
+        if (entries.size() == 0 or entries[0].first != 0) {
+            return false;
+        }
+        for (unsigned i = 0; i < entries.size(); ++i) {
+            uint32_t end = ((i+1) < entries.size() ? entries[i+1].first : module.size);
+            if (entries[i].first >= end) {
+                return false;
+            }
+            decoded.extents.push_back(extent_t(entries[i].first, end, entries[i].second));
+        }
+
+        set<unsigned> jumps(module.jumps.begin(), module.jumps.end());
+        for (const extent_t& e : decoded.extents) {
+            set<string>& refs = decoded.references[get<2>(e)];
+            uint32_t addr = get<0>(e);
+            OPCODE last = NOP;
+            while (addr < get<1>(e)) {
+                string line;
+                unsigned size = 0;
+                try {
+                    tie(line, size) = disassembler::instruction(module.bytecode+addr);
+                } catch (const string& ex) {
+                    return false;
+                }
+                if (size == 0 or (get<1>(e) - addr) < size) {
+                    return false;
+                }
+
+                // jumps which are not in jump table (absolute, or to byte offsets) cannot be adjusted
+                OPCODE op = OPCODE(module.bytecode[addr]);
+                if (op == JUMP and not jumps.count(addr + sizeof(byte))) {
+                    return false;
+                }
+                if (op == BRANCH) {
+                    unsigned truth = unsigned(addr + sizeof(byte) + sizeof(bool) + sizeof(int));
+                    if (not (jumps.count(truth) and jumps.count(truth + sizeof(int)))) {
+                        return false;
+                    }
+                }
+
+                references(line, refs);
+                addr += size;
+                last = op;
+            }
+
+            // code falling through to the next function or block keeps it alive
+            if (not terminating(OP_NAMES.at(last)) and (&e != &decoded.extents.back())) {
+                refs.insert(get<2>(*(&e+1)));
+            }
+        }
+
+        // code jumping to another function or block keeps it alive
+        for (unsigned jmp : module.jumps) {
+            long from = find(decoded.extents, jmp);
+            long to = find(decoded.extents, *reinterpret_cast<uint32_t*>(module.bytecode+jmp));
+            if (from < 0 or to < 0) {
+                return false;
+            }
+            if (from != to) {
+                decoded.references[get<2>(decoded.extents[unsigned(from)])].insert(get<2>(decoded.extents[unsigned(to)]));
+            }
+        }
+
+        return true;
+    }
+
+    static void compact(linkedmodule_t& module, const module_t& decoded, const set<string>& reachable) {
+        /** Remove unreachable functions and blocks from bytecode of a linked module.
+         */
+        vector<uint32_t> removed_before;
+        vector<bool> kept;
+        uint32_t removed = 0;
+        for (const extent_t& e : decoded.extents) {
+            removed_before.push_back(removed);
+            kept.push_back(reachable.count(get<2>(e)) > 0);
+            if (not kept.back()) {
+                removed += (get<1>(e) - get<0>(e));
+            }
+        }
+
+        uint32_t size = (module.size - removed);
+        byte* bytecode = new byte[size];
+        for (unsigned i = 0; i < decoded.extents.size(); ++i) {
+            if (kept[i]) {
+                const extent_t& e = decoded.extents[i];
+                copy(module.bytecode+get<0>(e), module.bytecode+get<1>(e), bytecode+get<0>(e)-removed_before[i]);
+            }
+        }
+
+        vector<unsigned> jumps;
+        for (unsigned jmp : module.jumps) {
+            unsigned from = unsigned(find(decoded.extents, jmp));
+            if (not kept[from]) {
+                continue;
+            }
+            uint32_t target = *reinterpret_cast<uint32_t*>(module.bytecode+jmp);
+            unsigned to = unsigned(find(decoded.extents, target));
+
+            jmp -= removed_before[from];
+            *reinterpret_cast<uint32_t*>(bytecode+jmp) = (target - removed_before[to]);
+            jumps.push_back(jmp);
+        }
+
+        vector<string> functions;
+        map<string, uint32_t> function_addresses, function_registers, block_addresses;
+        for (unsigned i = 0; i < decoded.extents.size(); ++i) {
+            const string& name = get<2>(decoded.extents[i]);
+            if (not kept[i]) {
+                continue;
+            }
+            if (module.function_addresses.count(name)) {
+                function_addresses[name] = (get<0>(decoded.extents[i]) - removed_before[i]);
+                if (module.function_registers.count(name)) {
+                    function_registers[name] = module.function_registers.at(name);
+                }
+            } else {
+                block_addresses[name] = (get<0>(decoded.extents[i]) - removed_before[i]);
+            }
+        }
+        for (const string& name : module.functions) {
+            if (function_addresses.count(name)) {
+                functions.push_back(name);
+            }
+        }
+
+        delete[] module.bytecode;
+        module.bytecode = bytecode;
+        module.size = size;
+        module.jumps = jumps;
+        module.functions = functions;
+        module.function_addresses = function_addresses;
+        module.function_registers = function_registers;
+        module.block_addresses = block_addresses;
+    }
+
+    static uint64_t count(const invocables_t& invocables) {
+        uint64_t bytes = 0;
+        for (const string& name : invocables.names) {
+            bytes += Program::countBytes(invocables.bodies.at(name));
+        }
+        return bytes;
+    }
+
+    static uint64_t count(const vector<linkedmodule_t>& modules) {
+        uint64_t bytes = 0;
+        for (const linkedmodule_t& module : modules) {
+            bytes += module.size;
+        }
+        return bytes;
+    }
+
+    static uint64_t eliminate(invocables_t& invocables, const set<string>& reachable, vector<string>& removed) {
+        /** Remove unreachable functions or blocks.
+         *
+         *  Returns size of bytecode of the removed code.
+         */
+        uint64_t bytes = 0;
+        vector<string> names;
+        for (const string& name : invocables.names) {
+            if (reachable.count(name)) {
+                names.push_back(name);
+            } else {
+                bytes += Program::countBytes(invocables.bodies.at(name));
+                invocables.bodies.erase(name);
+                removed.push_back(name);
+            }
+        }
+        invocables.names = names;
+        return bytes;
+    }
+
+
+    report_t eliminate(invocables_t& functions, invocables_t& blocks, const vector<string>& ilines, const string& main_function, const vector<string>& keep, vector<linkedmodule_t>& modules) {
+        /** Remove functions and blocks which are not reachable from the main function.
+         *
+         *  Returns names of removed functions and blocks, and
+         *  sizes of bytecode before and after the removal.
+         */
+        report_t report;
+        report.bytes_before = (count(functions) + count(blocks) + count(modules));
+        report.bytes_after = report.bytes_before;
+
+        for (const invocables_t* invocables : { &functions, &blocks }) {
+            for (const auto& body : invocables->bodies) {
+                for (const string& line : body.second) {
+                    if (absolute(line)) {
+                        return report;
+                    }
+                }
+            }
+        }
+        for (const string& line : ilines) {
+            if (absolute(line)) {
+                return report;
+            }
+        }
+
+        vector<module_t> decoded(modules.size());
+        for (unsigned i = 0; i < modules.size(); ++i) {
+            if (not decode(modules[i], decoded[i])) {
+                return report;
+            }
+        }
+
+        set<string> roots(keep.begin(), keep.end());
+        roots.insert(main_function);
+        for (const string& line : ilines) {
+            references(line, roots);
+        }
+
+        // code falling through to the next function or block keeps it alive
+        // (blocks are placed before functions in bytecode)
+        vector<string> layout = blocks.names;
+        layout.insert(layout.end(), functions.names.begin(), functions.names.end());
+        map<string, string> fallthrough;
+        for (unsigned i = 0; (i+1) < layout.size(); ++i) {
+            const vector<string>& body = (blocks.bodies.count(layout[i]) ? blocks : functions).bodies.at(layout[i]);
+            auto last = find_if(body.rbegin(), body.rend(), [](const string& line) { return not str::startswith(line, "."); });
+            if (last == body.rend() or not terminating(str::chunk(*last))) {
+                fallthrough[layout[i]] = layout[i+1];
+            }
+        }
+
+        set<string> reachable;
+        vector<string> pending(roots.begin(), roots.end());
+        while (pending.size()) {
+            string name = pending.back();
+            pending.pop_back();
+            if (reachable.count(name)) {
+                continue;
+            }
+            reachable.insert(name);
+
+            set<string> refs;
+            if (fallthrough.count(name)) {
+                refs.insert(fallthrough.at(name));
+            }
+            for (const invocables_t* invocables : { &functions, &blocks }) {
+                auto body = invocables->bodies.find(name);
+                if (body != invocables->bodies.end()) {
+                    for (const string& line : body->second) {
+                        references(line, refs);
+                    }
+                }
+            }
+            for (const module_t& module : decoded) {
+                auto module_refs = module.references.find(name);
+                if (module_refs != module.references.end()) {
+                    refs.insert(module_refs->second.begin(), module_refs->second.end());
+                }
+            }
+            pending.insert(pending.end(), refs.begin(), refs.end());
+        }
+
+        report.bytes_after -= eliminate(functions, reachable, report.functions);
+        report.bytes_after -= eliminate(blocks, reachable, report.blocks);
+        for (unsigned i = 0; i < modules.size(); ++i) {
+            for (const string& name : modules[i].functions) {
+                if (not reachable.count(name)) { report.functions.push_back(name); }
+            }
+            for (auto bl : modules[i].block_addresses) {
+                if (not reachable.count(bl.first)) { report.blocks.push_back(bl.first); }
+            }
+            report.bytes_after -= modules[i].size;
+            compact(modules[i], decoded[i], reachable);
+            report.bytes_after += modules[i].size;
+        }
+
+        return report;
+    }
+}
@@ -0,0 +1,173 @@
+#include <map>
+#include <set>
+#include <string>
+#include <vector>
+#include <viua/front/asm.h>
+#include <viua/front/ir.h>
+using namespace std;
+
+
+/*  Static type inference.
+ *
+ *  Infers types of objects held in registers of functions in SSA form (see src/front/asm/ir.cpp) and
+ *  replaces integer arithmetic and comparisons whose both operands are proven to hold Integers with
+ *  their typed variants, e.g. `iadd` with `tiadd`, which the CPU runs without casts.
+ *
+ *  Inference is flow-sensitive: each version of a register has its own type, and versions merged by phi nodes
+ *  have a type only if all merged versions have the same one.
+ *  Registers that may hold references (see ir::build()) never have a known type.
+ */
+namespace typeinference {
+    // instructions that have typed variants
+    static const set<string> SPECIALIZABLE = {
+        "iadd", "isub", "imul", "idiv", "ilt", "ilte", "igt", "igte", "ieq",
+    };
+
+    // types of objects created by instructions in their first operand
+    static const map<string, string> PRODUCED = {
+        { "izero", "Integer" }, { "istore", "Integer" }, { "argc", "Integer" }, { "vlen", "Integer" },
+        { "iadd", "Integer" }, { "isub", "Integer" }, { "imul", "Integer" }, { "idiv", "Integer" },
+        { "tiadd", "Integer" }, { "tisub", "Integer" }, { "timul", "Integer" }, { "tidiv", "Integer" },
+        { "ftoi", "Integer" }, { "stoi", "Integer" },
+        { "fstore", "Float" }, { "fadd", "Float" }, { "fsub", "Float" }, { "fmul", "Float" }, { "fdiv", "Float" },
+        { "itof", "Float" }, { "stof", "Float" },
+        { "ilt", "Boolean" }, { "ilte", "Boolean" }, { "igt", "Boolean" }, { "igte", "Boolean" }, { "ieq", "Boolean" },
+        { "tilt", "Boolean" }, { "tilte", "Boolean" }, { "tigt", "Boolean" }, { "tigte", "Boolean" }, { "tieq", "Boolean" },
+        { "flt", "Boolean" }, { "flte", "Boolean" }, { "fgt", "Boolean" }, { "fgte", "Boolean" }, { "feq", "Boolean" },
+        { "not", "Boolean" }, { "and", "Boolean" }, { "or", "Boolean" }, { "isnull", "Boolean" },
+        { "bstore", "Byte" }, { "strstore", "String" }, { "vec", "Vector" },
+    };
+
+    // type of values that have not been reached yet
+    static const string UNKNOWN = "";
+    // type of values that may hold objects of different types (or no object at all)
+    static const string ANY = "?";
+
+    static string meet(const string& a, const string& b) {
+        if (a == UNKNOWN) { return b; }
+        if (b == UNKNOWN) { return a; }
+        return (a == b ? a : ANY);
+    }
+
+    static string typeOf(const map<ir::value_t, string>& types, const ir::access_t& access) {
+        auto found = types.find(ir::value_t(access.reg, access.version));
+        return (found == types.end() ? UNKNOWN : found->second);
+    }
+
+    static string defined(const map<ir::value_t, string>& types, const ir::instruction_t& instruction, const ir::access_t& def) {
+        /** Return type of the object an instruction puts in a register.
+         */
+        const string& instr = instruction.mnemonic;
+        if (instr == "copy") {
+            return typeOf(types, instruction.uses.at(0));
+        }
+        if (instr == "move") {
+            // destination receives the object of the source, and the source is left empty
+            return (def.operand == 0 ? typeOf(types, instruction.uses.at(0)) : ANY);
+        }
+        if (instr == "swap") {
+            return typeOf(types, instruction.uses.at(def.operand == 0 ? 1 : 0));
+        }
+        if (instr == "iinc" or instr == "idec") {
+            // objects are modified in place so their type does not change
+            return typeOf(types, instruction.uses.at(0));
+        }
+        if (def.operand == 0 and PRODUCED.count(instr)) {
+            return PRODUCED.at(instr);
+        }
+        return ANY;
+    }
+
+    static map<ir::value_t, string> infer(const ir::function_t& function) {
+        /** Infer types of all values of a function.
+         */
+        map<ir::value_t, string> types;
+        bool changed = true;
+        while (changed) {
+            changed = false;
+            for (const ir::block_t& block : function.blocks) {
+                if (not block.reachable) {
+                    continue;
+                }
+                for (const ir::phi_t& phi : block.phis) {
+                    string type = UNKNOWN;
+                    for (unsigned version : phi.operands) {
+                        // initial version of a register is empty
+                        type = meet(type, (version == 0 ? ANY : typeOf(types, ir::access_t{ -1, phi.reg, version })));
+                    }
+                    if (function.untracked.count(phi.reg)) {
+                        type = ANY;
+                    }
+                    ir::value_t value(phi.reg, phi.version);
+                    if (types.count(value) == 0 or types.at(value) != type) {
+                        types[value] = type;
+                        changed = true;
+                    }
+                }
+                for (const ir::instruction_t& instruction : block.instructions) {
+                    for (const ir::access_t& def : instruction.defs) {
+                        string type = (function.untracked.count(def.reg) ? ANY : defined(types, instruction, def));
+                        ir::value_t value(def.reg, def.version);
+                        if (types.count(value) == 0 or types.at(value) != type) {
+                            types[value] = type;
+                            changed = true;
+                        }
+                    }
+                }
+            }
+        }
+        return types;
+    }
+
+    static unsigned specialize(ir::function_t& function) {
+        map<ir::value_t, string> types = infer(function);
+
+        unsigned specialized = 0;
+        for (ir::block_t& block : function.blocks) {
+            for (ir::instruction_t& instruction : block.instructions) {
+                if (SPECIALIZABLE.count(instruction.mnemonic) == 0 or instruction.uses.size() != 2) {
+                    continue;
+                }
+                bool integers = true;
+                for (const ir::access_t& use : instruction.uses) {
+                    integers = (integers and use.version != 0 and typeOf(types, use) == "Integer");
+                }
+                if (integers) {
+                    instruction.mnemonic = ("t" + instruction.mnemonic);
+                    ++specialized;
+                }
+            }
+        }
+        return specialized;
+    }
+
+    unsigned specialize(invocables_t& functions, bool as_lib) {
+        /** Replace instructions operating on proven Integers with their typed variants.
+         *
+         *  Returns number of specialized instructions.
+         */
+        unsigned specialized = 0;
+        if (as_lib) {
+            return specialized;
+        }
+
+        set<string> closures = ir::closures(functions);
+        for (auto& each : functions.bodies) {
+            if (closures.count(each.first)) {
+                continue;
+            }
+            ir::function_t function;
+            if (not ir::build(each.second, function)) {
+                continue;
+            }
+            ir::ssa(function);
+
+            unsigned count = specialize(function);
+            if (count) {
+                each.second = ir::lower(function);
+                specialized += count;
+            }
+        }
+        return specialized;
+    }
+}
@@ -9,7 +9,6 @@
 #include <viua/support/env.h>
 #include <viua/types/exception.h>
 #include <viua/types/string.h>
-#include <viua/loader.h>
 #include <viua/cpu/cpu.h>
 #include <viua/program.h>
 #include <viua/printutils.h>
@@ -24,6 +23,14 @@ bool SHOW_HELP = false;
 bool SHOW_VERSION = false;
 bool VERBOSE = false;
 
+bool VERIFY = false;
+
+// file to which execution profile is written (empty if profiling is disabled)
+string PROFILE = "";
+
+// number of worker threads running processes
+unsigned THREADS = 1;
+
 
 bool usage(const char* program, bool SHOW_HELP, bool SHOW_VERSION, bool VERBOSE) {
     if (SHOW_HELP or (SHOW_VERSION and VERBOSE)) {
@@ -39,6 +46,10 @@ bool usage(const char* program, bool SHOW_HELP, bool SHOW_VERSION, bool VERBOSE)
         cout << "    " << "-V, --version            - show version\n"
              << "    " << "-h, --help               - display this message\n"
              << "    " << "-v, --verbose            - show verbose output\n"
+             << "    " << "    --verify             - verify bytecode and exit without running it\n"
+             << "    " << "    --profile <file>     - write execution profile (executed instructions of each function and block)\n"
+             << "    " << "                           to <file>; it can be given to 'viua-asm --profile-use' to lay out hot code together\n"
+             << "    " << "    --threads <n>        - run processes on <n> worker threads (default: 1)\n"
              ;
     }
 
@@ -60,6 +71,25 @@ int main(int argc, char* argv[]) {
         } else if (option == "--verbose" or option == "-v") {
             VERBOSE = true;
             continue;
+        } else if (option == "--verify") {
+            VERIFY = true;
+            continue;
+        } else if (option == "--profile") {
+            if (i < argc-1) {
+                PROFILE = string(argv[++i]);
+            } else {
+                cout << "error: option '" << argv[i] << "' requires an argument: filename" << endl;
+                return 1;
+            }
+            continue;
+        } else if (option == "--threads") {
+            if (i < argc-1 and str::isnum(argv[i+1], false) and stoul(argv[i+1]) > 0) {
+                THREADS = unsigned(stoul(argv[++i]));
+            } else {
+                cout << "error: option '" << argv[i] << "' requires an argument: positive number of threads" << endl;
+                return 1;
+            }
+            continue;
         }
         args.push_back(argv[i]);
     }
@@ -83,18 +113,8 @@ int main(int argc, char* argv[]) {
         return 1;
     }
 
-    Loader loader(filename);
-    loader.executable();
-
-    uint16_t bytes = loader.getBytecodeSize();
-    byte* bytecode = loader.getBytecode();
-
     CPU cpu;
-
-    map<string, uint16_t> function_address_mapping = loader.getFunctionAddresses();
-    uint16_t starting_instruction = function_address_mapping["__entry"];
-    for (auto p : function_address_mapping) { cpu.mapfunction(p.first, p.second); }
-    for (auto p : loader.getBlockAddresses()) { cpu.mapblock(p.first, p.second); }
+    cpu.load(ModuleImage::executable(filename));
 
     vector<string> cmdline_args;
     for (int i = 1; i < argc; ++i) {
@@ -103,7 +123,17 @@ int main(int argc, char* argv[]) {
 
     cpu.commandline_arguments = cmdline_args;
 
-    cpu.load(bytecode).bytes(bytes).eoffset(starting_instruction);
+    if (VERIFY) {
+        string report = cpu.verify();
+        if (report.size()) {
+            cout << "error: verification failed: " << report << endl;
+            return 1;
+        }
+        if (VERBOSE) {
+            cout << "message: bytecode verified: " << filename << endl;
+        }
+        return 0;
+    }
 
     try {
         // try preloading dynamic libraries specified by environment
@@ -127,7 +157,26 @@ int main(int argc, char* argv[]) {
     cpu.registerForeignMethod("String::stringify", static_cast<ForeignMethodMemberPointer>(&String::stringify));
     cpu.registerForeignMethod("String::represent", static_cast<ForeignMethodMemberPointer>(&String::represent));
 
-    cpu.run();
+    if (PROFILE.size()) {
+        cpu.enableProfiling();
+    }
+
+    cpu.threads(THREADS).run();
+
+    for (const auto& failure : cpu.failures()) {
+        cout << "process " << get<0>(failure) << ": uncaught object: " << get<1>(failure) << " = " << get<2>(failure) << endl;
+    }
+
+    if (PROFILE.size()) {
+        // one line per function or block: <function|block> <name> <entries> <executed instructions>
+        ofstream profile_out(PROFILE);
+        for (const ProfileEntry& entry : cpu.profile()) {
+            profile_out << (entry.is_block ? "block" : "function") << ' ' << entry.name << ' ' << entry.entries << ' ' << entry.instructions << '\n';
+        }
+        if (not profile_out) {
+            cout << "error: could not write profile: " << PROFILE << endl;
+        }
+    }
 
     int ret_code = 0;
     string return_exception = "", return_message = "";
@@ -2,6 +2,7 @@
 #include <cstdint>
 #include <cstring>
 #include <iostream>
+#include <fstream>
 #include <sstream>
 #include <vector>
 #include <tuple>
@@ -125,18 +126,18 @@ int main(int argc, char* argv[]) {
         return 1;
     }
 
-    uint16_t bytes = loader.getBytecodeSize();
+    uint32_t bytes = loader.getBytecodeSize();
     byte* bytecode = loader.getBytecode();
 
-    map<string, uint16_t> function_address_mapping = loader.getFunctionAddresses();
+    map<string, uint32_t> function_address_mapping = loader.getFunctionAddresses();
     vector<string> functions = loader.getFunctions();
     map<string, unsigned> function_sizes = loader.getFunctionSizes();
 
-    map<string, uint16_t> block_address_mapping = loader.getBlockAddresses();
+    map<string, uint32_t> block_address_mapping = loader.getBlockAddresses();
     vector<string> blocks = loader.getBlocks();
     map<string, unsigned> block_sizes;
 
-    map<string, uint16_t> element_address_mapping;
+    map<string, uint32_t> element_address_mapping;
     vector<string> elements;
     map<string, unsigned> element_sizes;
     map<string, string> element_types;
@@ -298,6 +298,15 @@ tuple<bool, string> if_watchpoint_local_register_write(CPU& cpu, const State& st
                opcode == IGT or
                opcode == IGTE or
                opcode == IEQ or
+               opcode == TIADD or
+               opcode == TISUB or
+               opcode == TIMUL or
+               opcode == TIDIV or
+               opcode == TILT or
+               opcode == TILTE or
+               opcode == TIGT or
+               opcode == TIGTE or
+               opcode == TIEQ or
                opcode == FADD or
                opcode == FSUB or
                opcode == FMUL or
@@ -410,6 +419,15 @@ tuple<bool, string> if_watchpoint_global_register_write(CPU& cpu, const State& s
                opcode == IGT or
                opcode == IGTE or
                opcode == IEQ or
+               opcode == TIADD or
+               opcode == TISUB or
+               opcode == TIMUL or
+               opcode == TIDIV or
+               opcode == TILT or
+               opcode == TILTE or
+               opcode == TIGT or
+               opcode == TIGTE or
+               opcode == TIEQ or
                opcode == FADD or
                opcode == FSUB or
                opcode == FMUL or
@@ -1043,7 +1061,7 @@ int main(int argc, char* argv[]) {
     Loader loader(filename);
     loader.executable();
 
-    uint16_t bytes = loader.getBytecodeSize();
+    uint32_t bytes = loader.getBytecodeSize();
     byte* bytecode = loader.getBytecode();
 
     cout << "bytecode size: " << bytes << endl;
@@ -1051,10 +1069,11 @@ int main(int argc, char* argv[]) {
     CPU cpu;
     cpu.debug = true;
 
-    map<string, uint16_t> function_address_mapping = loader.getFunctionAddresses();
-    uint16_t starting_instruction = function_address_mapping["__entry"];
+    map<string, uint32_t> function_address_mapping = loader.getFunctionAddresses();
+    uint32_t starting_instruction = function_address_mapping["__entry"];
     for (auto p : function_address_mapping) { cpu.mapfunction(p.first, p.second); }
     for (auto p : loader.getBlockAddresses()) { cpu.mapblock(p.first, p.second); }
+    for (auto p : loader.getFunctionRegisters()) { cpu.mapregisters(p.first, p.second); }
 
     vector<string> cmdline_args;
     for (int i = 1; i < argc; ++i) {
@@ -1,36 +1,35 @@
 #include <cstdint>
 #include <iostream>
 #include <fstream>
+#include <sstream>
 #include <tuple>
 #include <string>
 #include <vector>
 #include <map>
 #include <viua/bytecode/bytetypedef.h>
+#include <viua/support/lz.h>
 #include <viua/loader.h>
 using namespace std;
 
 
 
-IdToAddressMapping Loader::loadmap(char* bytedump, const uint16_t& bytedump_size) {
-    vector<string> order;
-    map<string, uint16_t> mapping;
-
+void Loader::loadmap(char* bytedump, const uint32_t& bytedump_size, vector<string>& order, map<string, uint32_t>& mapping) {
+    /** Load map of names to addresses directly into given containers.
+     */
     char *lib_function_ids_map = bytedump;
 
     long unsigned i = 0;
     string lib_fn_name;
-    uint16_t lib_fn_address;
+    uint32_t lib_fn_address;
     while (i < bytedump_size) {
         lib_fn_name = string(lib_function_ids_map);
         i += lib_fn_name.size() + 1;  // one for null character
-        lib_fn_address = *((uint16_t*)(bytedump+i));
-        i += sizeof(uint16_t);
+        lib_fn_address = *((uint32_t*)(bytedump+i));
+        i += sizeof(uint32_t);
         lib_function_ids_map = bytedump+i;
         mapping[lib_fn_name] = lib_fn_address;
         order.push_back(lib_fn_name);
     }
-
-    return IdToAddressMapping(order, mapping);
 }
 void Loader::calculateFunctionSizes() {
     string name;
@@ -55,7 +54,7 @@ void Loader::calculateFunctionSizes() {
     }
 }
 
-void Loader::loadJumpTable(ifstream& in) {
+void Loader::loadJumpTable(istream& in) {
     // load jump table
     unsigned lib_total_jumps;
     in.read((char*)&lib_total_jumps, sizeof(unsigned));
@@ -66,59 +65,83 @@ void Loader::loadJumpTable(ifstream& in) {
         jumps.push_back(lib_jmp);
     }
 }
-void Loader::loadFunctionsMap(ifstream& in) {
-    uint16_t lib_function_ids_section_size = 0;
-    in.read((char*)&lib_function_ids_section_size, sizeof(uint16_t));
+void Loader::loadFunctionsMap(istream& in) {
+    uint32_t lib_function_ids_section_size = 0;
+    in.read((char*)&lib_function_ids_section_size, sizeof(uint32_t));
 
     char *lib_buffer_function_ids = new char[lib_function_ids_section_size];
     in.read(lib_buffer_function_ids, lib_function_ids_section_size);
 
-    vector<string> order;
-    map<string, uint16_t> mapping;
-
-    tie(order, mapping) = loadmap(lib_buffer_function_ids, lib_function_ids_section_size);
-
-    for (string p : order) {
-        functions.push_back(p);
-        function_addresses[p] = mapping[p];
-    }
+    loadmap(lib_buffer_function_ids, lib_function_ids_section_size, functions, function_addresses);
     delete[] lib_buffer_function_ids;
 }
-void Loader::loadBlocksMap(ifstream& in) {
-    uint16_t lib_block_ids_section_size = 0;
-    in.read((char*)&lib_block_ids_section_size, sizeof(uint16_t));
+void Loader::loadBlocksMap(istream& in) {
+    uint32_t lib_block_ids_section_size = 0;
+    in.read((char*)&lib_block_ids_section_size, sizeof(uint32_t));
 
     char *lib_buffer_block_ids = new char[lib_block_ids_section_size];
     in.read(lib_buffer_block_ids, lib_block_ids_section_size);
 
-    vector<string> order;
-    map<string, uint16_t> mapping;
-
-    tie(order, mapping) = loadmap(lib_buffer_block_ids, lib_block_ids_section_size);
-
-    for (string p : order) {
-        blocks.push_back(p);
-        block_addresses[p] = mapping[p];
-    }
+    loadmap(lib_buffer_block_ids, lib_block_ids_section_size, blocks, block_addresses);
     delete[] lib_buffer_block_ids;
 }
-void Loader::loadBytecode(ifstream& in) {
-    in.read((char*)&size, 16);
+void Loader::loadRegistersMap(istream& in) {
+    /** Load sizes of local register sets required by functions.
+     *
+     *  Functions whose requirements could not be established by
+     *  the assembler are not listed.
+     */
+    uint32_t registers_section_size = 0;
+    in.read((char*)&registers_section_size, sizeof(uint32_t));
+
+    char *buffer_registers = new char[registers_section_size];
+    in.read(buffer_registers, registers_section_size);
+
+    vector<string> order;
+    loadmap(buffer_registers, registers_section_size, order, function_registers);
+    delete[] buffer_registers;
+}
+void Loader::loadBytecode(istream& in) {
+    // size field is 16 bytes wide but only its beginning holds the size
+    uint64_t size_field[2] = {0, 0};
+    in.read((char*)size_field, 16);
+    size = uint32_t(size_field[0]);
     bytecode = new byte[size];
     in.read(bytecode, size);
 }
 
-Loader& Loader::load() {
+string Loader::read(const string& error) {
+    /** Read contents of the module.
+     *
+     *  Compressed modules are transparently decompressed.
+     */
     ifstream in(path, ios::in | ios::binary);
     if (!in) {
-        throw ("failed to open file: " + path);
+        throw (error + path);
+    }
+
+    ostringstream contents;
+    contents << in.rdbuf();
+    if (not support::lz::iscompressed(contents.str())) {
+        return contents.str();
     }
 
+    try {
+        return support::lz::decompress(contents.str());
+    } catch (const char* e) {
+        throw (string(e) + ": " + path);
+    }
+}
+
+Loader& Loader::load() {
+    istringstream in(read("failed to open file: "));
+
     // jump table must be loaded if loading a library
     loadJumpTable(in);
 
     loadBlocksMap(in);
     loadFunctionsMap(in);
+    loadRegistersMap(in);
     loadBytecode(in);
     calculateFunctionSizes();
 
@@ -126,20 +149,18 @@ Loader& Loader::load() {
 }
 
 Loader& Loader::executable() {
-    ifstream in(path, ios::in | ios::binary);
-    if (!in) {
-        throw ("fatal: failed to open file: " + path);
-    }
+    istringstream in(read("fatal: failed to open file: "));
 
     loadBlocksMap(in);
     loadFunctionsMap(in);
+    loadRegistersMap(in);
     loadBytecode(in);
     calculateFunctionSizes();
 
     return (*this);
 }
 
-uint16_t Loader::getBytecodeSize() {
+uint32_t Loader::getBytecodeSize() {
     return size;
 }
 byte* Loader::getBytecode() {
@@ -150,23 +171,27 @@ byte* Loader::getBytecode() {
     return copy;
 }
 
-vector<unsigned> Loader::getJumps() {
+const vector<unsigned>& Loader::getJumps() {
     return jumps;
 }
 
-map<string, uint16_t> Loader::getFunctionAddresses() {
+const map<string, uint32_t>& Loader::getFunctionAddresses() {
     return function_addresses;
 }
-map<string, unsigned> Loader::getFunctionSizes() {
+const map<string, unsigned>& Loader::getFunctionSizes() {
     return function_sizes;
 }
-vector<string> Loader::getFunctions() {
+const vector<string>& Loader::getFunctions() {
     return functions;
 }
 
-map<string, uint16_t> Loader::getBlockAddresses() {
+const map<string, uint32_t>& Loader::getFunctionRegisters() {
+    return function_registers;
+}
+
+const map<string, uint32_t>& Loader::getBlockAddresses() {
     return block_addresses;
 }
-vector<string> Loader::getBlocks() {
+const vector<string>& Loader::getBlocks() {
     return blocks;
 }
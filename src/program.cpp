@@ -1,6 +1,7 @@
 #include <cstdint>
 #include <iostream>
 #include <sstream>
+#include <unordered_map>
 #include <viua/support/string.h>
 #include <viua/bytecode/opcodes.h>
 #include <viua/bytecode/maps.h>
@@ -73,6 +74,15 @@ int Program::instructionCount() {
             case IGT:
             case IGTE:
             case IEQ:
+            case TIADD:
+            case TISUB:
+            case TIMUL:
+            case TIDIV:
+            case TILT:
+            case TILTE:
+            case TIGT:
+            case TIGTE:
+            case TIEQ:
             case BRANCH:
                 i += 3 * sizeof(int);
                 break;
@@ -92,33 +102,71 @@ int Program::instructionCount() {
 }
 
 
-OPCODE instructionToOpcode(const string& s) {
-    OPCODE op = NOP;
-    bool found = false;
+static map<string, InstructionSchema> buildSchemas() {
+    /** Build schemas of all instructions.
+     *
+     *  Only instructions with operands encoded as null-terminated strings
+     *  need anything more than what is found in OP_NAMES and OP_SIZES.
+     */
+    const map<OPCODE, string> strings = {
+        { STRSTORE,     "rq" },
+        { CALL,         "on" },
+        { MSG,          "on" },
+        { CLOSURE,      "rn" },
+        { FUNCTION,     "rn" },
+        { CLASS,        "rn" },
+        { PROTOTYPE,    "rn" },
+        { DERIVE,       "rn" },
+        { NEW,          "rn" },
+        { ATTACH,       "rnn" },
+        { CATCH,        "qn" },
+        { ENTER,        "n" },
+        { TAILCALL,     "n" },
+        { SPAWN,        "n" },
+        { COROUTINE,    "rn" },
+        { IMPORT,       "q" },
+        { LINK,         "n" },
+    };
+
+    map<string, InstructionSchema> schemas;
     for (auto it : OP_NAMES) {
-        if (it.second == s) {
-            found = true;
-            op = it.first;
-            break;
-        }
+        InstructionSchema& s = schemas[it.second];
+        s.opcode = it.first;
+        s.size = OP_SIZES.at(it.second);
+        s.strings = (strings.count(it.first) ? strings.at(it.first) : "");
     }
-    if (not found) {
-        throw std::out_of_range("invalid instruction name: " + s);
+    return schemas;
+}
+
+const InstructionSchema& Program::schema(const string& mnemonic) {
+    /** Return schema of an instruction.
+     *
+     *  Throws std::out_of_range if mnemonic is not a valid instruction name.
+     */
+    static const unordered_map<string, InstructionSchema> schemas = [] {
+        map<string, InstructionSchema> ordered = buildSchemas();
+        return unordered_map<string, InstructionSchema>(ordered.begin(), ordered.end());
+    }();
+    auto found = schemas.find(mnemonic);
+    if (found == schemas.end()) {
+        throw std::out_of_range("invalid instruction name: " + mnemonic);
     }
-    return op;
+    return found->second;
 }
 
-uint16_t Program::countBytes(const vector<string>& lines) {
+uint32_t Program::countBytes(const vector<string>& lines) {
     /** Counts bytecode size required for a program.
      *
      *  Knowing how many instructions are in a program, and
      *  size of each instruction, required bytecode size can
      *  be calculated by a simple for loop adding sizes of
      *  instructions it encounters.
+     *  Sizes of operands encoded as null-terminated strings are calculated according to
+     *  the schema of the instruction.
      *
      *  Passed lines must be sanitized, i.e. the comments and blanks must be removed.
      */
-    uint16_t bytes = 0;
+    uint32_t bytes = 0;
     long unsigned inc = 0;
     string instr, line;
 
@@ -132,68 +180,25 @@ uint16_t Program::countBytes(const vector<string>& lines) {
             continue;
         }
 
-        instr = "";
-        inc = 0;
-
         instr = str::chunk(line);
         try {
-            OPCODE op = instructionToOpcode(instr);
-            inc = OP_SIZES.at(instr);
-            if (op == ENTER) {
-                // clear first chunk
-                line = str::lstrip(str::sub(line, instr.size()));
-                // get second chunk (function or block name)
-                inc += str::chunk(line).size() + 1;
-            } else if ((op == CALL) or (op == MSG)) {
-                // clear first chunk (opcode mnemonic)
-                line = str::lstrip(str::sub(line, instr.size()));
-                // get second chunk (optional register index)
-                string first_op = str::chunk(line);
-                line = str::lstrip(str::sub(line, first_op.size()));
-                // get third chunk (function name if register index was given, empty otherwise)
-                string second_op = str::chunk(line);
-                inc += (second_op.size() ? second_op : first_op).size() + 1;
-            } else if ((op == CLOSURE) or (op == FUNCTION) or (op == CLASS) or (op == PROTOTYPE) or (op == DERIVE) or (op == NEW)) {
-                // clear first chunk (opcode mnemonic)
-                line = str::lstrip(str::sub(line, instr.size()));
-                // clear second chunk (register index)
-                line = str::lstrip(str::sub(line, str::chunk(line).size()));
-                // get third chunk (name)
-                inc += str::chunk(line).size() + 1;
-            } else if (op == ATTACH) {
-                // clear first chunk (opcode mnemonic)
-                line = str::lstrip(str::sub(line, instr.size()));
-                // clear second chunk (register index)
-                line = str::lstrip(str::sub(line, str::chunk(line).size()));
-                // get third chunk (function name)
-                inc += str::chunk(line).size() + 1;
-                line = str::lstrip(str::sub(line, str::chunk(line).size()));
-                // get fourth chunk (method name)
-                inc += str::chunk(line).size() + 1;
-            } else if (op == IMPORT) {
-                // clear first chunk
-                line = str::lstrip(str::sub(line, instr.size()));
-                // get second chunk (which is a string)
-                inc += (str::extract(line).size() - 2 + 1); // +1: null-terminator, -2: quotes around module name
-            } else if (op == LINK) {
-                // clear first chunk
-                line = str::lstrip(str::sub(line, instr.size()));
-                // get second chunk (which is a module name)
-                inc += (str::chunk(line).size() + 1); // +1: null-terminator
-            } else if (op == CATCH) {
-                // clear first chunk (the opcode)
-                line = str::lstrip(str::sub(line, instr.size()));
-                // get second chunk (the type as a string)
-                inc += (str::extract(line).size() - 2 + 1); // +1: null-terminator, -2: quotes
-                line = str::lstrip(str::sub(line, str::extract(line).size()));
-                // get third chunk (which is a block name)
-                inc += str::chunk(line).size() + 1;
-            } else if (op == STRSTORE) {
-                // clear first chunk
-                line = str::lstrip(str::sub(line, instr.size()));
-                line = str::lstrip(str::sub(line, str::chunk(line).size()));
-                // get third chunk (which is a string)
-                inc += (str::extract(line).size() - 2 + 1); // +1: null-terminator
+            const InstructionSchema& s = schema(instr);
+            inc = s.size;
+
+            // clear first chunk (opcode mnemonic)
+            line = str::lstrip(str::sub(line, instr.size()));
+            for (char kind : s.strings) {
+                string operand = (kind == 'q' ? str::extract(line) : str::chunk(line));
+                line = str::lstrip(str::sub(line, operand.size()));
+                if (kind == 'n') {
+                    inc += operand.size() + 1;  // +1: null-terminator
+                } else if (kind == 'q') {
+                    inc += (operand.size() - 2 + 1); // +1: null-terminator, -2: quotes
+                } else if (kind == 'o' and line.size() == 0) {
+                    // optional register was not given so the operand is a name
+                    inc += operand.size() + 1;
+                    break;
+                }
             }
         } catch (const std::out_of_range &e) {
             throw ("unrecognised instruction: `" + instr + '`');
@@ -249,7 +254,7 @@ long Program::getInstructionBytecodeOffset(int instr, int count) {
         }
 
         OPCODE opcode = OPCODE(program[offset]);
-        if ((opcode == IMPORT) or (opcode == ENTER) or (opcode == LINK)) {
+        if ((opcode == IMPORT) or (opcode == ENTER) or (opcode == LINK) or (opcode == TAILCALL) or (opcode == SPAWN)) {
             string s(program+offset+1);
             if (scream) {
                 cout << '+' << s.size() << " (function/module name at byte " << offset+1 << ": `" << s << "`)";
@@ -257,7 +262,7 @@ long Program::getInstructionBytecodeOffset(int instr, int count) {
             inc += s.size()+1;
         }
         if ((opcode == CALL) or (opcode == CLOSURE) or (opcode == FUNCTION) or
-            (opcode == CLASS) or (opcode == PROTOTYPE) or (opcode == DERIVE) or (opcode == NEW) or (opcode == MSG)) {
+            (opcode == CLASS) or (opcode == PROTOTYPE) or (opcode == DERIVE) or (opcode == NEW) or (opcode == MSG) or (opcode == COROUTINE)) {
             string s(program+offset+sizeof(bool)+sizeof(int)+1);
             if (scream) {
                 cout << '+' << s.size() << " (function/module/class name at byte " << offset+1 << ": `" << s << "`)";
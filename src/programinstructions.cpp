@@ -161,6 +161,123 @@ Program& Program::ieq(int_op rega, int_op regb, int_op regr) {
     return (*this);
 }
 
+Program& Program::tiadd(int_op rega, int_op regb, int_op regr) {
+    /*  Inserts tiadd instruction to bytecode.
+     *
+     *  :params:
+     *
+     *  rega    - register index of first operand
+     *  regb    - register index of second operand
+     *  regr    - register index in which to store the result
+     */
+    addr_ptr = cg::bytecode::tiadd(addr_ptr, rega, regb, regr);
+    return (*this);
+}
+
+Program& Program::tisub(int_op rega, int_op regb, int_op regr) {
+    /*  Inserts tisub instruction to bytecode.
+     *
+     *  :params:
+     *
+     *  rega    - register index of first operand
+     *  regb    - register index of second operand
+     *  regr    - register index in which to store the result
+     */
+    addr_ptr = cg::bytecode::tisub(addr_ptr, rega, regb, regr);
+    return (*this);
+}
+
+Program& Program::timul(int_op rega, int_op regb, int_op regr) {
+    /*  Inserts timul instruction to bytecode.
+     *
+     *  :params:
+     *
+     *  rega    - register index of first operand
+     *  regb    - register index of second operand
+     *  regr    - register index in which to store the result
+     */
+    addr_ptr = cg::bytecode::timul(addr_ptr, rega, regb, regr);
+    return (*this);
+}
+
+Program& Program::tidiv(int_op rega, int_op regb, int_op regr) {
+    /*  Inserts tidiv instruction to bytecode.
+     *
+     *  :params:
+     *
+     *  rega    - register index of first operand
+     *  regb    - register index of second operand
+     *  regr    - register index in which to store the result
+     */
+    addr_ptr = cg::bytecode::tidiv(addr_ptr, rega, regb, regr);
+    return (*this);
+}
+
+Program& Program::tilt(int_op rega, int_op regb, int_op regr) {
+    /*  Inserts tilt instruction to bytecode.
+     *
+     *  :params:
+     *
+     *  rega    - register index of first operand
+     *  regb    - register index of second operand
+     *  regr    - register index in which to store the result
+     */
+    addr_ptr = cg::bytecode::tilt(addr_ptr, rega, regb, regr);
+    return (*this);
+}
+
+Program& Program::tilte(int_op rega, int_op regb, int_op regr) {
+    /*  Inserts tilte instruction to bytecode.
+     *
+     *  :params:
+     *
+     *  rega    - register index of first operand
+     *  regb    - register index of second operand
+     *  regr    - register index in which to store the result
+     */
+    addr_ptr = cg::bytecode::tilte(addr_ptr, rega, regb, regr);
+    return (*this);
+}
+
+Program& Program::tigt(int_op rega, int_op regb, int_op regr) {
+    /*  Inserts tigt instruction to bytecode.
+     *
+     *  :params:
+     *
+     *  rega    - register index of first operand
+     *  regb    - register index of second operand
+     *  regr    - register index in which to store the result
+     */
+    addr_ptr = cg::bytecode::tigt(addr_ptr, rega, regb, regr);
+    return (*this);
+}
+
+Program& Program::tigte(int_op rega, int_op regb, int_op regr) {
+    /*  Inserts tigte instruction to bytecode.
+     *
+     *  :params:
+     *
+     *  rega    - register index of first operand
+     *  regb    - register index of second operand
+     *  regr    - register index in which to store the result
+     */
+    addr_ptr = cg::bytecode::tigte(addr_ptr, rega, regb, regr);
+    return (*this);
+}
+
+Program& Program::tieq(int_op rega, int_op regb, int_op regr) {
+    /*  Inserts tieq instruction to bytecode.
+     *
+     *  :params:
+     *
+     *  rega    - register index of first operand
+     *  regb    - register index of second operand
+     *  regr    - register index in which to store the result
+     */
+    addr_ptr = cg::bytecode::tieq(addr_ptr, rega, regb, regr);
+    return (*this);
+}
+
 Program& Program::fstore(int_op regno, float f) {
     /*  Inserts fstore instruction to bytecode.
      *
@@ -615,6 +732,50 @@ Program& Program::call(int_op reg, const string& fn_name) {
     return (*this);
 }
 
+Program& Program::tailcall(const string& fn_name) {
+    /*  Inserts tailcall instruction.
+     *  Byte offset is calculated automatically.
+     */
+    addr_ptr = cg::bytecode::tailcall(addr_ptr, fn_name);
+    return (*this);
+}
+
+Program& Program::spawn(const string& fn_name) {
+    /*  Inserts spawn instruction.
+     *  Byte offset is calculated automatically.
+     */
+    addr_ptr = cg::bytecode::spawn(addr_ptr, fn_name);
+    return (*this);
+}
+
+Program& Program::coroutine(int_op reg, const string& fn_name) {
+    /*  Inserts coroutine instruction.
+     */
+    addr_ptr = cg::bytecode::coroutine(addr_ptr, reg, fn_name);
+    return (*this);
+}
+
+Program& Program::resume(int_op ret, int_op crt) {
+    /*  Inserts resume instruction.
+     */
+    addr_ptr = cg::bytecode::resume(addr_ptr, ret, crt);
+    return (*this);
+}
+
+Program& Program::yield(int_op regno) {
+    /*  Inserts yield instruction.
+     */
+    addr_ptr = cg::bytecode::yield(addr_ptr, regno);
+    return (*this);
+}
+
+Program& Program::wait(int_op ret, int_op future) {
+    /*  Inserts wait instruction.
+     */
+    addr_ptr = cg::bytecode::wait(addr_ptr, ret, future);
+    return (*this);
+}
+
 Program& Program::jump(int addr, enum JUMPTYPE is_absolute) {
     /*  Inserts jump instruction. Parameter is instruction index.
      *  Byte offset is calculated automatically.
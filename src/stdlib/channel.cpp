@@ -0,0 +1,106 @@
+#include <viua/types/type.h>
+#include <viua/types/integer.h>
+#include <viua/types/boolean.h>
+#include <viua/types/vector.h>
+#include <viua/types/reference.h>
+#include <viua/types/channel.h>
+#include <viua/types/exception.h>
+#include <viua/cpu/frame.h>
+#include <viua/cpu/registerset.h>
+#include <viua/include/module.h>
+using namespace std;
+
+
+static Type* parameter(Frame* frame, unsigned index) {
+    /** Return object passed as a parameter (by value or by reference).
+     */
+    Type* object = frame->args->at(index);
+    Reference* rf = dynamic_cast<Reference*>(object);
+    return (rf ? rf->pointsTo() : object);
+}
+
+static Channel* channelParameter(Frame* frame) {
+    Channel* channel = dynamic_cast<Channel*>(parameter(frame, 0));
+    if (channel == nullptr) {
+        throw new Exception("expected Channel as first parameter");
+    }
+    return channel;
+}
+
+
+void channel_make(Frame* frame, RegisterSet*, RegisterSet*) {
+    /** Create a channel.
+     *
+     *  Requires one parameter: capacity of the channel (rounded up to a power of two).
+     */
+    Integer* capacity = dynamic_cast<Integer*>(parameter(frame, 0));
+    if (capacity == nullptr or capacity->value() < 1) {
+        throw new Exception("expected positive Integer as capacity of a channel");
+    }
+    frame->regset->set(0, new Channel(unsigned(capacity->value())));
+}
+
+void channel_send(Frame* frame, RegisterSet*, RegisterSet*) {
+    /** Send a copy of a value over a channel.
+     *
+     *  Calling process waits while the channel is full.
+     */
+    Channel* channel = channelParameter(frame);
+    Type* value = parameter(frame, 1)->copy();
+    if (not channel->trySend(value)) {
+        delete value;
+        throw WouldBlock();
+    }
+}
+
+void channel_try_send(Frame* frame, RegisterSet*, RegisterSet*) {
+    /** Send a copy of a value over a channel if it is not full.
+     *
+     *  Returns true if the value was sent.
+     */
+    Channel* channel = channelParameter(frame);
+    Type* value = parameter(frame, 1)->copy();
+    bool sent = channel->trySend(value);
+    if (not sent) {
+        delete value;
+    }
+    frame->regset->set(0, new Boolean(sent));
+}
+
+void channel_receive(Frame* frame, RegisterSet*, RegisterSet*) {
+    /** Receive a value from a channel.
+     *
+     *  Calling process waits while the channel is empty.
+     */
+    Type* value = channelParameter(frame)->tryReceive();
+    if (value == nullptr) {
+        throw WouldBlock();
+    }
+    frame->regset->set(0, value);
+}
+
+void channel_try_receive(Frame* frame, RegisterSet*, RegisterSet*) {
+    /** Receive a value from a channel if it is not empty.
+     *
+     *  Returns a vector with the received value, or an empty vector.
+     */
+    Vector* received = new Vector();
+    Type* value = channelParameter(frame)->tryReceive();
+    if (value) {
+        received->push(value);
+    }
+    frame->regset->set(0, received);
+}
+
+const ExternalFunctionSpec functions[] = {
+    { "std::channel::make", &channel_make, false },
+    { "std::channel::send", &channel_send, false },
+    { "std::channel::try_send", &channel_try_send, false },
+    { "std::channel::receive", &channel_receive, false },
+    { "std::channel::try_receive", &channel_try_receive, false },
+    { NULL, NULL, false },
+};
+
+extern "C" const ExternalFunctionSpec* exports() {
+    return functions;
+}
@@ -1,4 +1,9 @@
+#include <poll.h>
+#include <unistd.h>
+#include <cerrno>
 #include <iostream>
+#include <mutex>
+#include <string>
 #include <viua/types/type.h>
 #include <viua/types/string.h>
 #include <viua/types/vector.h>
@@ -9,15 +14,44 @@
 using namespace std;
 
 
+/*  Bytes read from standard input that were not yet returned as lines.
+ *  Standard input is read directly (not through std::cin) so it is never read in a blocking way.
+ */
+static mutex stdin_lock;
+static string stdin_buffer;
+static bool stdin_closed = false;
+
 void io_getline(Frame* frame, RegisterSet*, RegisterSet*) {
-    string line;
-    getline(cin, line);
+    /** Read a line from standard input.
+     *
+     *  Calling process is suspended until a whole line is available so other processes keep running while
+     *  it waits.
+     *  Returns remaining characters (or empty string) at the end of input.
+     */
+    lock_guard<mutex> lck(stdin_lock);
+    string::size_type newline = string::npos;
+    while ((newline = stdin_buffer.find('\n')) == string::npos and not stdin_closed) {
+        pollfd input = { 0, POLLIN, 0 };
+        if (poll(&input, 1, 0) == 0) {
+            throw WouldBlock(0, WouldBlock::READABLE);
+        }
+        char chunk[4096];
+        ssize_t n = read(0, chunk, sizeof(chunk));
+        if (n > 0) {
+            stdin_buffer.append(chunk, static_cast<string::size_type>(n));
+        } else if (n == 0 or (errno != EINTR and errno != EAGAIN)) {
+            stdin_closed = true;
+        }
+    }
+
+    string line = stdin_buffer.substr(0, newline);
+    stdin_buffer.erase(0, (newline == string::npos ? string::npos : newline+1));
     frame->regset->set(0, new String(line));
 }
 
 const ExternalFunctionSpec functions[] = {
-    { "std::io::getline", &io_getline },
-    { NULL, NULL },
+    { "std::io::getline", &io_getline, false },
+    { NULL, NULL, false },
 };
 
 extern "C" const ExternalFunctionSpec* exports() {
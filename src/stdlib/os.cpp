@@ -19,8 +19,8 @@ void os_system(Frame* frame, RegisterSet*, RegisterSet*) {
 
 
 const ExternalFunctionSpec functions[] = {
-    { "os::system", &os_system },
-    { NULL, NULL },
+    { "os::system", &os_system, true },
+    { NULL, NULL, false },
 };
 
 extern "C" const ExternalFunctionSpec* exports() {
@@ -78,11 +78,11 @@ void random_randint(Frame* frame, RegisterSet*, RegisterSet*) {
 }
 
 const ExternalFunctionSpec functions[] = {
-    { "std::random::device::random", &random_drandom },
-    { "std::random::device::urandom", &random_durandom },
-    { "std::random::random", &random_random },
-    { "std::random::randint", &random_randint },
-    { NULL, NULL },
+    { "std::random::device::random", &random_drandom, true },
+    { "std::random::device::urandom", &random_durandom, false },
+    { "std::random::random", &random_random, false },
+    { "std::random::randint", &random_randint, false },
+    { NULL, NULL, false },
 };
 
 extern "C" const ExternalFunctionSpec* exports() {
@@ -34,10 +34,10 @@ void string_stringify(Frame* frame, RegisterSet*, RegisterSet*) {
 
 
 const ExternalFunctionSpec functions[] = {
-    { "string::string", &string_string },
-    { "string::repr", &string_repr },
-    { "string::stringify", &string_stringify },
-    { NULL, NULL },
+    { "string::string", &string_string, false },
+    { "string::repr", &string_repr, false },
+    { "string::stringify", &string_stringify, false },
+    { NULL, NULL, false },
 };
 
 extern "C" const ExternalFunctionSpec* exports() {
@@ -50,10 +50,10 @@ void bases(Frame* frame, RegisterSet*, RegisterSet*) {
 
 
 const ExternalFunctionSpec functions[] = {
-    { "typesystem::typeof", &typeof },
-    { "typesystem::inheritanceChain", &inheritanceChain },
-    { "typesystem::bases", &bases },
-    { NULL, NULL },
+    { "typesystem::typeof", &typeof, false },
+    { "typesystem::inheritanceChain", &inheritanceChain, false },
+    { "typesystem::bases", &bases, false },
+    { NULL, NULL, false },
 };
 
 extern "C" const ExternalFunctionSpec* exports() {
@@ -0,0 +1,202 @@
+#include <cstdint>
+#include <cstring>
+#include <vector>
+#include <viua/support/lz.h>
+using namespace std;
+
+
+/*  Compressed data begins with a magic number followed by size of decompressed data
+ *  (64 bit, little endian) and a stream of LZ4-style sequences.
+ *
+ *  Each sequence is:
+ *
+ *      - a token byte: high nibble is the number of literals, low nibble is match length minus 4
+ *        (nibble value 15 means that the length is continued in following bytes, each adding up to 255),
+ *      - literal bytes,
+ *      - 16 bit offset of the match (counted back from current position in decompressed data),
+ *      - continuation of match length.
+ *
+ *  The last sequence has only literals.
+ */
+static const string MAGIC = string("\x7fVIUALZ\x01", 8);
+
+static const unsigned MIN_MATCH = 4;
+static const unsigned LAST_LITERALS = 5;
+static const unsigned MATCH_FIND_LIMIT = 12;
+static const unsigned MAX_OFFSET = 65535;
+static const unsigned HASH_BITS = 16;
+
+
+static uint32_t read32(const char* ptr) {
+    uint32_t value;
+    memcpy(&value, ptr, sizeof(uint32_t));
+    return value;
+}
+
+static unsigned hashsequence(uint32_t sequence) {
+    return ((sequence * 2654435761U) >> (32 - HASH_BITS));
+}
+
+static void writelength(string& out, unsigned long length) {
+    while (length >= 255) {
+        out.push_back(char(255));
+        length -= 255;
+    }
+    out.push_back(char(length));
+}
+
+static void writesequence(string& out, const char* literals, unsigned long literal_length, unsigned long offset, unsigned long match_length) {
+    unsigned long match_nibble = (match_length ? match_length-MIN_MATCH : 0);
+    out.push_back(char(((literal_length < 15 ? literal_length : 15) << 4) | (match_nibble < 15 ? match_nibble : 15)));
+    if (literal_length >= 15) {
+        writelength(out, literal_length-15);
+    }
+    out.append(literals, literal_length);
+
+    if (match_length) {
+        out.push_back(char(offset & 0xff));
+        out.push_back(char(offset >> 8));
+        if (match_nibble >= 15) {
+            writelength(out, match_nibble-15);
+        }
+    }
+}
+
+static unsigned long readlength(const string& in, unsigned long& i) {
+    unsigned long length = 0;
+    unsigned char next = 255;
+    while (next == 255) {
+        if (i >= in.size()) {
+            throw "corrupted compressed data: truncated length";
+        }
+        next = static_cast<unsigned char>(in[i++]);
+        length += next;
+    }
+    return length;
+}
+
+
+namespace support {
+    namespace lz {
+        bool iscompressed(const string& data) {
+            return (data.size() >= (MAGIC.size() + sizeof(uint64_t)) and data.compare(0, MAGIC.size(), MAGIC) == 0);
+        }
+
+        string compress(const string& data) {
+            /** Compress data.
+             *
+             *  Matches are found with a single-entry hash table of 4-byte sequences, which
+             *  trades compression ratio for speed (in the same way LZ4 does).
+             */
+            string out = MAGIC;
+            uint64_t size = data.size();
+            out.append(reinterpret_cast<const char*>(&size), sizeof(uint64_t));
+
+            const char* src = data.c_str();
+            unsigned long n = data.size();
+            vector<unsigned long> table(1u << HASH_BITS, 0);   // position+1 of last sequence with given hash, 0 if none
+
+            unsigned long anchor = 0;
+            unsigned long i = 0;
+            unsigned long limit = (n > MATCH_FIND_LIMIT ? n-MATCH_FIND_LIMIT : 0);
+            while (i < limit) {
+                uint32_t sequence = read32(src+i);
+                unsigned h = hashsequence(sequence);
+                unsigned long candidate = table[h];
+                table[h] = i+1;
+
+                if (candidate == 0 or (i-(candidate-1)) > MAX_OFFSET or read32(src+candidate-1) != sequence) {
+                    ++i;
+                    continue;
+                }
+
+                unsigned long match = candidate-1;
+                unsigned long length = MIN_MATCH;
+                while ((i+length) < (n-LAST_LITERALS) and src[match+length] == src[i+length]) {
+                    ++length;
+                }
+
+                writesequence(out, src+anchor, i-anchor, i-match, length);
+                i += length;
+                anchor = i;
+            }
+            writesequence(out, src+anchor, n-anchor, 0, 0);
+
+            return out;
+        }
+
+        string decompress(const string& in) {
+            /** Decompress data produced by compress().
+             *
+             *  Throws if the data is corrupted.
+             */
+            if (not iscompressed(in)) {
+                throw "not compressed data";
+            }
+
+            uint64_t size = 0;
+            memcpy(&size, in.c_str()+MAGIC.size(), sizeof(uint64_t));
+            if ((size / 255) > in.size()) {
+                // no sequence expands to more than 255 times its size
+                throw "corrupted compressed data: invalid size";
+            }
+
+            string out(size, '\0');
+            unsigned long o = 0;
+            unsigned long i = MAGIC.size() + sizeof(uint64_t);
+            while (i < in.size()) {
+                unsigned token = static_cast<unsigned char>(in[i++]);
+
+                unsigned long literal_length = (token >> 4);
+                if (literal_length == 15) {
+                    literal_length += readlength(in, i);
+                }
+                if (literal_length > (in.size()-i) or literal_length > (size-o)) {
+                    throw "corrupted compressed data: literals out of bounds";
+                }
+                in.copy(&out[o], literal_length, i);
+                i += literal_length;
+                o += literal_length;
+
+                if (i == in.size()) {
+                    break;
+                }
+
+                if ((in.size()-i) < 2) {
+                    throw "corrupted compressed data: truncated offset";
+                }
+                unsigned long offset = (static_cast<unsigned char>(in[i]) | (static_cast<unsigned long>(static_cast<unsigned char>(in[i+1])) << 8));
+                i += 2;
+                if (offset == 0 or offset > o) {
+                    throw "corrupted compressed data: match offset out of bounds";
+                }
+
+                unsigned long match_length = (token & 15);
+                if (match_length == 15) {
+                    match_length += readlength(in, i);
+                }
+                match_length += MIN_MATCH;
+                if (match_length > (size-o)) {
+                    throw "corrupted compressed data: match out of bounds";
+                }
+
+                // matches may overlap the bytes they produce so they are copied byte by byte
+                // unless the offset is long enough
+                if (offset >= match_length) {
+                    memcpy(&out[o], &out[o-offset], match_length);
+                } else {
+                    for (unsigned long k = 0; k < match_length; ++k) {
+                        out[o+k] = out[o-offset+k];
+                    }
+                }
+                o += match_length;
+            }
+
+            if (o != size) {
+                throw "corrupted compressed data: size mismatch";
+            }
+
+            return out;
+        }
+    }
+}
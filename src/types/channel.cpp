@@ -0,0 +1,69 @@
+#include <sstream>
+#include <thread>
+#include <viua/types/channel.h>
+using namespace std;
+
+
+// number of failed attempts after which blocking calls yield the thread between attempts
+static const unsigned CHANNEL_SPIN_LIMIT = 64;
+
+
+Channel::Queue::~Queue() {
+    Type* value = nullptr;
+    while (values.pop(value)) {
+        delete value;
+    }
+}
+
+
+Channel::Channel(unsigned requested_capacity): queue(make_shared<Queue>(requested_capacity)) {
+}
+
+string Channel::str() const {
+    ostringstream oss;
+    oss << "<Channel of capacity " << capacity() << ">";
+    return oss.str();
+}
+
+unsigned Channel::capacity() const {
+    return unsigned(queue->values.capacity());
+}
+
+bool Channel::trySend(Type* value) {
+    /** Put value in the channel if there is room for it.
+     *
+     *  Channel becomes owner of the value only if true is returned.
+     */
+    return queue->values.push(value);
+}
+
+Type* Channel::tryReceive() {
+    /** Take value from the channel.
+     *
+     *  Returns null pointer if the channel is empty.
+     */
+    Type* value = nullptr;
+    return (queue->values.pop(value) ? value : nullptr);
+}
+
+void Channel::send(Type* value) {
+    /** Put value in the channel, waiting for room if it is full.
+     */
+    for (unsigned attempt = 0; not trySend(value); ++attempt) {
+        if (attempt >= CHANNEL_SPIN_LIMIT) {
+            this_thread::yield();
+        }
+    }
+}
+
+Type* Channel::receive() {
+    /** Take value from the channel, waiting for one if it is empty.
+     */
+    Type* value = nullptr;
+    for (unsigned attempt = 0; (value = tryReceive()) == nullptr; ++attempt) {
+        if (attempt >= CHANNEL_SPIN_LIMIT) {
+            this_thread::yield();
+        }
+    }
+    return value;
+}
@@ -0,0 +1,25 @@
+#include <sstream>
+#include <viua/types/coroutine.h>
+using namespace std;
+
+
+Coroutine::State::~State() {
+    // frames of a coroutine that was never run to its end
+    for (Frame* frame : frames) {
+        delete frame;
+    }
+    for (TryFrame* tframe : tryframes) {
+        delete tframe;
+    }
+}
+
+
+string Coroutine::str() const {
+    ostringstream oss;
+    oss << "Coroutine: " << state->function_name;
+    return oss.str();
+}
+
+string Coroutine::repr() const {
+    return str();
+}
@@ -0,0 +1,20 @@
+#include <sstream>
+#include <viua/types/future.h>
+using namespace std;
+
+
+Future::State::~State() {
+    delete value;
+    delete thrown;
+}
+
+
+string Future::str() const {
+    ostringstream oss;
+    oss << "Future: " << state->function_name << (state->resolved.load() ? " (resolved)" : "");
+    return oss.str();
+}
+
+string Future::repr() const {
+    return str();
+}
@@ -52,7 +52,7 @@ Reference::~Reference() {
     /* cout << ((*counter)-1) << endl; */
     if ((--(*counter)) == 0) {
         //cout << '0' << endl;
-        cout << hex;
+        /* cout << hex; */
         /* cout << "destruction of: 0x" << long(*pointer) << endl; */
         /* cout << "\\___located at: 0x" << long(pointer) << endl; */
         /* cout << "\\_performed by: 0x" << long(this) << endl; */
@@ -0,0 +1,48 @@
+.function: sum
+    arg 1 0
+    arg 2 1
+    iadd 0 1 2
+    end
+.end
+
+.function: twice
+    arg 1 0
+    frame 2 16
+    param 0 1
+    param 1 1
+    tailcall sum
+.end
+
+.function: count_down
+    arg 1 0
+    izero 3
+    ieq 2 1 3
+    branch 2 0xaf 0x87
+    frame 1 16
+    idec 1
+    param 0 1
+    tailcall count_down
+    strstore 0 "done"
+    end
+.end
+
+.function: main
+    frame 1 16
+    istore 1 21
+    param 0 1
+    call 2 twice
+    print 2
+    istore 3 4
+    frame 1 16
+    paref 0 3
+    call 4 twice
+    print 4
+    print 3
+    frame 1 16
+    istore 5 100000
+    param 0 5
+    call 6 count_down
+    print 6
+    izero 0
+    end
+.end
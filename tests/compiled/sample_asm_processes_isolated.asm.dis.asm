@@ -0,0 +1,41 @@
+.function: increment
+    iinc 2
+    print 2
+    end
+.end
+
+.function: run_twice
+    arg 1 0
+    arg 2 1
+    frame 0 0
+    fcall 0 1
+    frame 0 0
+    fcall 0 1
+    frame 2 16
+    param 0 2
+    istore 3 0
+    param 1 3
+    call 0 std::channel::send
+    end
+.end
+
+.function: main
+    import "channel"
+    frame 1 16
+    istore 1 1
+    param 0 1
+    call 1 std::channel::make
+    istore 2 40
+    clbind 2
+    closure 3 increment
+    frame 2 16
+    param 0 3
+    param 1 1
+    spawn run_twice
+    frame 1 16
+    param 0 1
+    call 4 std::channel::receive
+    print 2
+    izero 0
+    end
+.end
@@ -0,0 +1,14 @@
+.function: greet
+    strstore 1 "Hello World!"
+    print 1
+    end
+.end
+
+.function: main
+    strstore 1 "Hello World!"
+    print 1
+    frame 0 16
+    call 0 greet
+    izero 0
+    end
+.end
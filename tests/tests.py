@@ -15,8 +15,11 @@ Returning correct may mean raising an exception in some cases.
 import functools
 import json
 import os
+import shutil
 import subprocess
 import sys
+import tempfile
+import time
 import re
 import unittest
 
@@ -76,16 +79,26 @@ def disassemble(path, out=None):
         raise ViuaDisassemblerError('{0}: {1}'.format(' '.join(asmargs), output.strip()))
     return (output, error, exit_code)
 
-def run(path, expected_exit_code=0):
+def run(path, expected_exit_code=0, opts=()):
     """Run given file with Viua CPU and return its output.
     """
-    p = subprocess.Popen(('./build/bin/vm/cpu', path), stdout=subprocess.PIPE, stderr=subprocess.PIPE)
+    p = subprocess.Popen(('./build/bin/vm/cpu',) + opts + (path,), stdout=subprocess.PIPE, stderr=subprocess.PIPE)
     output, error = p.communicate()
     exit_code = p.wait()
     if exit_code not in (expected_exit_code if type(expected_exit_code) in [list, tuple] else (expected_exit_code,)):
         raise ViuaCPUError('{0} [{1}]: {2}'.format(path, exit_code, output.decode('utf-8').strip()))
     return (exit_code, output.decode('utf-8'))
 
+def verify(path, expected_exit_code=0):
+    """Verify given file with Viua CPU (without running it) and return the report.
+    """
+    p = subprocess.Popen(('./build/bin/vm/cpu', '--verify', path), stdout=subprocess.PIPE, stderr=subprocess.PIPE)
+    output, error = p.communicate()
+    exit_code = p.wait()
+    if exit_code != expected_exit_code:
+        raise ViuaCPUError('{0} [{1}]: {2}'.format(path, exit_code, output.decode('utf-8').strip()))
+    return (exit_code, output.decode('utf-8'))
+
 MEMORY_LEAK_CHECKS_SKIPPED = 0
 MEMORY_LEAK_CHECKS_RUN = 0
 MEMORY_LEAK_CHECKS_ENABLE = 1
@@ -371,6 +384,9 @@ class StringInstructionsEscapeSequencesTests(unittest.TestCase):
     def testNewline(self):
         runTest(self, 'newline.asm', 'Hello\nWorld!', 0)
 
+    def testLiteralDecodedInLoop(self):
+        runTestSplitlines(self, 'in_loop.asm', ['Hello\tWorld!', 'Hello\tWorld!', 'Hello\tWorld!'])
+
     def testTab(self):
         runTest(self, 'tab.asm', 'Hello\tWorld!', 0)
 
@@ -539,6 +555,9 @@ class FunctionTests(unittest.TestCase):
     def testNeverendingFunction0(self):
         runTestThrowsException(self, 'neverending0.asm', 'uncaught object: Exception = Exception: "stack size (8192) exceeded with call to \'one/0\'"')
 
+    def testTailCalls(self):
+        runTest(self, 'tail_calls.asm', '100000', 0, lambda o: o.strip())
+
 
 class HigherOrderFunctionTests(unittest.TestCase):
     """Tests for higher-order function support.
@@ -617,6 +636,57 @@ class StaticLinkingTests(unittest.TestCase):
         self.assertEqual(['42', ':-)'], output.strip().splitlines())
         self.assertEqual(0, excode)
 
+    def testLinkingSeveralModules(self):
+        compiled_lib_paths = ()
+        for lib_name in ('print_N.asm', 'shakenlib.asm',):
+            compiled_lib_path = os.path.join(COMPILED_SAMPLES_PATH, (lib_name + '.wlib'))
+            assemble(os.path.join(self.PATH, lib_name), compiled_lib_path, opts=('--lib',))
+            compiled_lib_paths += (compiled_lib_path,)
+        bin_name = 'shaken.asm'
+        assembly_bin_path = os.path.join(self.PATH, bin_name)
+        compiled_bin_path = os.path.join(COMPILED_SAMPLES_PATH, (bin_name + '.bin'))
+        assemble(assembly_bin_path, compiled_bin_path, links=compiled_lib_paths)
+        excode, output = run(compiled_bin_path)
+        self.assertEqual(['3', '2', '1', 'done'], output.strip().splitlines())
+
+    def testFunctionLinkedTwiceIsDetected(self):
+        lib_name = 'shakenlib.asm'
+        assembly_lib_path = os.path.join(self.PATH, lib_name)
+        compiled_lib_paths = (os.path.join(COMPILED_SAMPLES_PATH, (lib_name + '.wlib')), os.path.join(COMPILED_SAMPLES_PATH, (lib_name + '.copy.wlib')),)
+        for compiled_lib_path in compiled_lib_paths:
+            assemble(assembly_lib_path, compiled_lib_path, opts=('--lib',))
+        bin_name = 'shaken.asm'
+        assembly_bin_path = os.path.join(self.PATH, bin_name)
+        compiled_bin_path = os.path.join(COMPILED_SAMPLES_PATH, (bin_name + '.bin'))
+        output, error, exit_code = assemble(assembly_bin_path, compiled_bin_path, links=compiled_lib_paths, okcodes=(1,))
+        self.assertEqual("fatal: function 'shakenlib::unused_first' is defined in both '{0}' and '{1}'".format(*compiled_lib_paths), output.strip())
+
+
+class UnreachableCodeEliminationTests(unittest.TestCase):
+    """Tests for removal of unreachable functions (enabled by -O1).
+    """
+    PATH = './sample/asm/linking/static'
+
+    def compile(self, opts=()):
+        lib_name = 'shakenlib.asm'
+        compiled_lib_path = os.path.join(COMPILED_SAMPLES_PATH, (lib_name + '.wlib'))
+        assemble(os.path.join(self.PATH, lib_name), compiled_lib_path, opts=('--lib',))
+        compiled_bin_path = os.path.join(COMPILED_SAMPLES_PATH, 'shaken.asm.O1.bin')
+        output, error, exit_code = assemble(os.path.join(self.PATH, 'shaken.asm'), compiled_bin_path, links=(compiled_lib_path,), opts=(('--no-cache', '-O1', '--verbose',) + opts))
+        return (compiled_bin_path, output)
+
+    def testUnreachableFunctionsAreRemoved(self):
+        compiled_bin_path, output = self.compile()
+        self.assertIn('message: unreachable code elimination: removed 3 function(s) and 0 block(s)', output)
+        self.assertEqual(['3', '2', '1', 'done'], run(compiled_bin_path)[1].strip().splitlines())
+        functions = [line for line in disassemble(compiled_bin_path)[0].splitlines() if line.startswith('.function:')]
+        self.assertEqual(['.function: main', '.function: shakenlib::countdown', '.function: shakenlib::done'], functions)
+
+    def testKeptFunctionsAreNotRemoved(self):
+        compiled_bin_path, output = self.compile(opts=('--keep', 'dead',))
+        self.assertIn('message: unreachable code elimination: removed 0 function(s) and 0 block(s)', output)
+        self.assertEqual(['3', '2', '1', 'done'], run(compiled_bin_path)[1].strip().splitlines())
+
 
 class JumpingTests(unittest.TestCase):
     """
@@ -659,6 +729,12 @@ class CatchingMachineThrownExceptionTests(unittest.TestCase):
     def testCatcherState(self):
         runTestSplitlines(self, 'restore_catcher_state.asm', ['42','100','42','100'])
 
+    def testCatchingObjectsThrownByCallsFromMain(self):
+        runTestSplitlines(self, 'thrown_by_call_from_main.asm', ['42', 'main', '(get) read from null register: 1', 'main'])
+
+    def testCatchingObjectsThrownByCallsFromMain(self):
+        runTestSplitlines(self, 'thrown_by_call_from_main.asm', ['42', 'main', '(get) read from null register: 1', 'main'])
+
 
 class PrototypeSystemTests(unittest.TestCase):
     """Tests for prototype system inside the machine.
@@ -715,6 +791,400 @@ class AssemblerErrorTests(unittest.TestCase):
         self.assertEqual("error: using 'halt' instead of 'end' as last instruction in main function leads to memory leaks", output.strip())
 
 
+class BytecodeVerifierTests(unittest.TestCase):
+    """Tests for load-time bytecode verification.
+    """
+    PATH = './sample/asm'
+
+    def testCorrectBytecodeIsVerified(self):
+        name = 'functions/local_registers.asm'
+        compiled_path = os.path.join(COMPILED_SAMPLES_PATH, 'verifier_local_registers.asm.bin')
+        assemble(os.path.join(self.PATH, name), compiled_path)
+        excode, output = verify(compiled_path)
+        self.assertEqual('', output.strip())
+
+    def testFrameTooSmallForFunction(self):
+        name = 'errors/frame_too_small.asm'
+        compiled_path = os.path.join(COMPILED_SAMPLES_PATH, 'verifier_frame_too_small.asm.bin')
+        assemble(os.path.join(self.PATH, name), compiled_path)
+        excode, output = verify(compiled_path, expected_exit_code=1)
+        self.assertEqual("error: verification failed: function 'store_in_4' accesses register 4 but is called at byte 23 with frame of 2 local registers", output.strip())
+
+    def testUnverifiedBytecodeIsRunWithChecks(self):
+        name = 'functions/neverending.asm'
+        compiled_path = os.path.join(COMPILED_SAMPLES_PATH, 'verifier_neverending.asm.bin')
+        assemble(os.path.join(self.PATH, name), compiled_path)
+        excode, output = verify(compiled_path, expected_exit_code=1)
+        self.assertEqual("error: verification failed: function 'one' does not end with a terminating instruction", output.strip())
+        excode, output = run(compiled_path)
+        self.assertEqual(['42', '48'], output.strip().splitlines())
+
+
+class AssemblerCacheTests(unittest.TestCase):
+    """Tests for compilation cache of the assembler.
+    """
+    PATH = './sample/asm/functions/closures'
+
+    def setUp(self):
+        self.cache_directory = tempfile.mkdtemp()
+        os.environ['VIUACACHE'] = self.cache_directory
+
+    def tearDown(self):
+        del os.environ['VIUACACHE']
+        shutil.rmtree(self.cache_directory)
+
+    def assembleTwice(self, name, opts=()):
+        assembly_path = os.path.join(self.PATH, name)
+        compiled_path = os.path.join(COMPILED_SAMPLES_PATH, '{0}_{1}.bin'.format(self.PATH[2:].replace('/', '_'), name))
+        cached_path = '{0}.cached.bin'.format(compiled_path)
+        assemble(assembly_path, compiled_path, opts=opts)
+        output, error, exit_code = assemble(assembly_path, cached_path, opts=(opts + ('--verbose',)))
+        with open(compiled_path, 'rb') as ifstream:
+            compiled = ifstream.read()
+        with open(cached_path, 'rb') as ifstream:
+            cached = ifstream.read()
+        self.assertEqual(compiled, cached)
+        return (output, cached_path)
+
+    def testCachedModuleIsReused(self):
+        output, cached_path = self.assembleTwice('simple.asm')
+        self.assertIn('message: using cached bytecode:', output)
+        excode, output = run(cached_path)
+        self.assertEqual('42', output.strip())
+
+    def testCachedFunctionsAreReused(self):
+        self.assembleTwice('simple.asm', opts=('--cache-functions',))
+        source_path = os.path.join(COMPILED_SAMPLES_PATH, 'cache_edited_simple.asm')
+        with open(os.path.join(self.PATH, 'simple.asm')) as ifstream:
+            source = ifstream.read()
+        with open(source_path, 'w') as ofstream:
+            ofstream.write(source + '\n; edited\n')
+        output, error, exit_code = assemble(source_path, '{0}.bin'.format(source_path), opts=('--verbose', '--cache-functions',))
+        self.assertNotIn('message: using cached bytecode:', output)
+        self.assertIn('[asm] message: using cached bytecode for function "main"', output)
+        excode, output = run('{0}.bin'.format(source_path))
+        self.assertEqual('42', output.strip())
+
+
+class AssemblerLargeModulesTests(unittest.TestCase):
+    """Tests for modules which do not fit in 64KiB of bytecode.
+    """
+    FUNCTIONS = 200
+
+    def writeLargeModule(self, source_path):
+        with open(source_path, 'w') as ofstream:
+            for i in range(self.FUNCTIONS):
+                ofstream.write('.function: f{0}\n'.format(i))
+                for k in range(30):
+                    ofstream.write('iadd 2 (arg 1 0) (istore 3 {0})\n'.format(k))
+                    ofstream.write('strstore 4 "f{0}"\n'.format(i))
+                ofstream.write('branch (ilt 5 1 2) +1 +1\nmove 0 2\nend\n.end\n\n')
+            ofstream.write('.function: main\n')
+            for i in range(self.FUNCTIONS):
+                ofstream.write('frame ^[(param 0 (istore 1 {0}))]\ncall 1 f{0}\n'.format(i))
+            ofstream.write('print 1\nizero 0\nend\n.end\n')
+
+    def testAssemblingModuleLargerThan64KiB(self):
+        source_path = os.path.join(COMPILED_SAMPLES_PATH, 'large_module.asm')
+        compiled_path = '{0}.bin'.format(source_path)
+        self.writeLargeModule(source_path)
+        assemble(source_path, compiled_path)
+        self.assertTrue(os.path.getsize(compiled_path) > 65536)
+        excode, output = run(compiled_path)
+        self.assertEqual(str((self.FUNCTIONS - 1) + 29), output.strip())
+
+    def testParallelCodeGenerationIsByteIdentical(self):
+        source_path = os.path.join(COMPILED_SAMPLES_PATH, 'large_module_parallel.asm')
+        compiled_path = '{0}.bin'.format(source_path)
+        parallel_path = '{0}.parallel.bin'.format(source_path)
+        self.writeLargeModule(source_path)
+        assemble(source_path, compiled_path)
+        assemble(source_path, parallel_path, opts=('-j', '4',))
+        with open(compiled_path, 'rb') as ifstream:
+            compiled = ifstream.read()
+        with open(parallel_path, 'rb') as ifstream:
+            parallel = ifstream.read()
+        self.assertEqual(compiled, parallel)
+        excode, output = run(parallel_path)
+        self.assertEqual(str((self.FUNCTIONS - 1) + 29), output.strip())
+
+
+class CompressedModulesTests(unittest.TestCase):
+    """Tests for modules compressed by the assembler.
+    """
+    PATH = './sample/asm/linking/static'
+
+    def testCompressedExecutable(self):
+        assembly_path = os.path.join('./sample/asm/functions/closures', 'simple.asm')
+        compiled_path = os.path.join(COMPILED_SAMPLES_PATH, 'compressed_simple.asm.bin')
+        output, error, exit_code = assemble(assembly_path, compiled_path, opts=('--compress', '--verbose',))
+        self.assertIn('message: compressed', output)
+        with open(compiled_path, 'rb') as ifstream:
+            self.assertEqual(b'\x7fVIUALZ\x01', ifstream.read(8))
+        excode, output = run(compiled_path)
+        self.assertEqual('42', output.strip())
+        self.assertEqual(0, excode)
+
+    def testLinkingCompressedLibrary(self):
+        lib_name = 'jumplib.asm'
+        assembly_lib_path = os.path.join(self.PATH, lib_name)
+        compiled_lib_path = os.path.join(COMPILED_SAMPLES_PATH, ('compressed_' + lib_name + '.wlib'))
+        assemble(assembly_lib_path, compiled_lib_path, opts=('--lib', '--compress',))
+        bin_name = 'jumplink.asm'
+        assembly_bin_path = os.path.join(self.PATH, bin_name)
+        compiled_bin_path = os.path.join(COMPILED_SAMPLES_PATH, ('compressed_' + bin_name + '.bin'))
+        assemble(assembly_bin_path, compiled_bin_path, links=(compiled_lib_path,), opts=('--compress',))
+        excode, output = run(compiled_bin_path)
+        self.assertEqual(['42', ':-)'], output.strip().splitlines())
+        self.assertEqual(0, excode)
+
+
+class PeepholeOptimizerTests(unittest.TestCase):
+    """Tests for peephole optimizer of the assembler (enabled by -O1).
+    """
+    PATH = './sample/asm/optimizations'
+
+    def testEveryRuleIsApplied(self):
+        assembly_path = os.path.join(self.PATH, 'peephole.asm')
+        compiled_path = os.path.join(COMPILED_SAMPLES_PATH, 'peephole.asm.bin')
+        optimized_path = os.path.join(COMPILED_SAMPLES_PATH, 'peephole.asm.O1.bin')
+        assemble(assembly_path, compiled_path, opts=('--no-cache',))
+        output, error, exit_code = assemble(assembly_path, optimized_path, opts=('--no-cache', '-O1', '--verbose',))
+        rewrites = {
+            'copy-free': 1,
+            'move-move': 1,
+            'constant-fold': 1,
+            'branch-to-next': 1,
+            'jump-to-next': 3,
+            'jump-to-jump': 2,
+        }
+        for rule, count in rewrites.items():
+            self.assertIn('message: peephole rule {0}: {1} rewrite(s)'.format(rule, count), output)
+        self.assertTrue(os.path.getsize(optimized_path) < os.path.getsize(compiled_path))
+        self.assertEqual(run(compiled_path), run(optimized_path))
+        self.assertEqual('42', run(optimized_path)[1].strip())
+
+    def testRelativeJumpsAreKeptCorrect(self):
+        for name in ('relative_jumps.asm', 'relative_branch.asm',):
+            assembly_path = os.path.join('./sample/asm/absolute_jumping', name)
+            compiled_path = os.path.join(COMPILED_SAMPLES_PATH, (name + '.O1.bin'))
+            assemble(assembly_path, compiled_path, opts=('-O1',))
+            excode, output = run(compiled_path)
+            self.assertEqual('Hello World', output.strip())
+
+
+class RegisterLivenessTests(unittest.TestCase):
+    """Tests for register renumbering and frame shrinking (enabled by -O1).
+    """
+    PATH = './sample/asm/optimizations'
+
+    def testSparseRegistersAreRenumbered(self):
+        assembly_path = os.path.join(self.PATH, 'registers.asm')
+        compiled_path = os.path.join(COMPILED_SAMPLES_PATH, 'registers.asm.bin')
+        optimized_path = os.path.join(COMPILED_SAMPLES_PATH, 'registers.asm.O1.bin')
+        assemble(assembly_path, compiled_path, opts=('--no-cache',))
+        output, error, exit_code = assemble(assembly_path, optimized_path, opts=('--no-cache', '-O1', '--verbose',))
+        self.assertIn('message: registers renumbered in 1 function(s)', output)
+        self.assertIn('message: frames shrunk: 1', output)
+        self.assertEqual(run(compiled_path), run(optimized_path))
+        self.assertEqual('42', run(optimized_path)[1].strip())
+
+        disassembly = disassemble(optimized_path)[0].splitlines()
+        self.assertIn('    iadd 3 1 2', disassembly)
+        self.assertIn('    frame 2 4', disassembly)
+
+
+class TailCallTests(unittest.TestCase):
+    """Tests for replacing calls in tail position with tail calls (enabled by -O1).
+    """
+    PATH = './sample/asm/optimizations'
+
+    def testRecursionInTailPositionRunsInConstantStackSpace(self):
+        assembly_path = os.path.join(self.PATH, 'tail_calls.asm')
+        compiled_path = os.path.join(COMPILED_SAMPLES_PATH, 'tail_calls.asm.bin')
+        optimized_path = os.path.join(COMPILED_SAMPLES_PATH, 'tail_calls.asm.O1.bin')
+        assemble(assembly_path, compiled_path, opts=('--no-cache',))
+        output, error, exit_code = assemble(assembly_path, optimized_path, opts=('--no-cache', '-O1', '--verbose',))
+        self.assertIn('message: peephole rule tail-call: 1 rewrite(s)', output)
+        self.assertIn('    tailcall count_down', disassemble(optimized_path)[0].splitlines())
+        self.assertEqual('100000', run(optimized_path)[1].strip())
+        self.assertEqual(1, run(compiled_path, 1)[0])
+
+
+class ProcessTests(unittest.TestCase):
+    """Tests for processes started with spawn instruction.
+    """
+    PATH = './sample/asm/processes'
+
+    def testSpawningProcesses(self):
+        runTest(self, 'spawn.asm', ['0', '2001000', '4501500', '500500', '8002000'], output_processing_function=lambda o: sorted(o.strip().splitlines()))
+
+    def testProcessesRunOnManyThreads(self):
+        assembly_path = os.path.join(self.PATH, 'spawn.asm')
+        compiled_path = os.path.join(COMPILED_SAMPLES_PATH, 'processes_spawn_threads.bin')
+        assemble(assembly_path, compiled_path)
+        for threads in ('1', '2', '4',):
+            self.assertEqual(['0', '2001000', '4501500', '500500', '8002000'], sorted(run(compiled_path, opts=('--threads', threads,))[1].strip().splitlines()))
+
+    def testUncaughtExceptionStopsOnlyItsProcess(self):
+        runTest(self, 'uncaught.asm', ['main finished', 'process fail: uncaught object: String = "failed"'], output_processing_function=lambda o: o.strip().splitlines())
+
+
+class CoroutineTests(unittest.TestCase):
+    """Tests for coroutines started with coroutine instruction.
+    """
+    PATH = './sample/asm/coroutines'
+
+    def testGeneratorYieldsValuesOneByOne(self):
+        runTest(self, 'generator.asm', ['1', '2', '3', '4', '5', '15'], output_processing_function=lambda o: o.strip().splitlines())
+
+    def testYieldingFromFunctionsCalledByCoroutine(self):
+        runTest(self, 'nested.asm', ['10', '11', '20', '21', 'done'], output_processing_function=lambda o: o.strip().splitlines())
+
+    def testExceptionThrownByCoroutineFinishesIt(self):
+        runTest(self, 'exception.asm', ['1', '42', 'true'], output_processing_function=lambda o: o.strip().splitlines())
+
+
+class EmbeddingTests(unittest.TestCase):
+    """Tests for hosts embedding CPUs: running several programs on one thread with CPU::runFor(), and
+    one program on many CPUs sharing its modules.
+    """
+    PATH = './sample/asm/embedding'
+
+    def runHost(self, host, parameter, *names):
+        compiled_paths = []
+        for name in names:
+            compiled_path = os.path.join(COMPILED_SAMPLES_PATH, '{0}_{1}.bin'.format(self.PATH[2:].replace('/', '_'), name))
+            assemble(os.path.join(self.PATH, name), compiled_path)
+            compiled_paths.append(compiled_path)
+        p = subprocess.Popen((host, str(parameter)) + tuple(compiled_paths), stdout=subprocess.PIPE, stderr=subprocess.PIPE)
+        output, error = p.communicate()
+        self.assertEqual(0, p.wait())
+        output = output.decode('utf-8')
+        for name, compiled_path in zip(names, compiled_paths):
+            output = output.replace(compiled_path, name)
+        return output.strip().splitlines()
+
+    def testCheapProgramIsNotDelayedByExpensiveOne(self):
+        self.assertEqual(['cheap', 'cheap.asm: 0', '200010000', '800020000', 'expensive.asm: 0'], self.runHost('./build/test/roundrobin', 512, 'expensive.asm', 'cheap.asm'))
+
+    def testProgramRunsToCompletionWithinLargeBudget(self):
+        self.assertEqual(['200010000', '800020000', 'expensive.asm: 0', 'cheap', 'cheap.asm: 0'], self.runHost('./build/test/roundrobin', 1000000, 'expensive.asm', 'cheap.asm'))
+
+    def testManyCPUsRunConcurrentlyOnSharedModules(self):
+        self.assertEqual(['64: 500500 500500 String'], self.runHost('./build/test/multivm', 64, 'shared.asm'))
+
+
+class ProfileGuidedLayoutTests(unittest.TestCase):
+    """Tests for laying out functions and blocks according to execution profile.
+    """
+    PATH = './sample/asm/optimizations'
+
+    def testExecutedCodeIsPackedTogether(self):
+        assembly_path = os.path.join(self.PATH, 'layout.asm')
+        compiled_path = os.path.join(COMPILED_SAMPLES_PATH, 'layout.asm.bin')
+        profile_path = os.path.join(COMPILED_SAMPLES_PATH, 'layout.asm.profile')
+        optimized_path = os.path.join(COMPILED_SAMPLES_PATH, 'layout.asm.profiled.bin')
+        assemble(assembly_path, compiled_path, opts=('--no-cache',))
+        p = subprocess.Popen(('./build/bin/vm/cpu', '--profile', profile_path, compiled_path), stdout=subprocess.PIPE, stderr=subprocess.PIPE)
+        output, error = p.communicate()
+        self.assertEqual(0, p.wait())
+        self.assertEqual('102', output.decode('utf-8').strip())
+        with open(profile_path) as ifstream:
+            profile = ifstream.read().splitlines()
+        self.assertIn('function step 34 272', profile)
+        self.assertIn('block handle_integer 0 0', profile)
+
+        output, error, exit_code = assemble(assembly_path, optimized_path, opts=('--no-cache', '--verbose', '--profile-use', profile_path,))
+        self.assertIn('message: profile-guided layout: 2 hot function(s) and 1 hot block(s)', output)
+        invocables = [line for line in disassemble(optimized_path)[0].splitlines() if line.startswith('.function:') or line.startswith('.block:')]
+        self.assertEqual(['.block: handle_integer', '.block: add_step', '.function: step', '.function: main', '.function: report_error'], invocables)
+        self.assertEqual(run(compiled_path), run(optimized_path))
+
+
+class InlinerTests(unittest.TestCase):
+    """Tests for inlining of calls to small functions (enabled by -O2).
+    """
+    PATH = './sample/asm/optimizations'
+
+    def testSmallFunctionsAreInlined(self):
+        assembly_path = os.path.join(self.PATH, 'inline.asm')
+        compiled_path = os.path.join(COMPILED_SAMPLES_PATH, 'inline.asm.bin')
+        optimized_path = os.path.join(COMPILED_SAMPLES_PATH, 'inline.asm.O2.bin')
+        assemble(assembly_path, compiled_path, opts=('--no-cache',))
+        output, error, exit_code = assemble(assembly_path, optimized_path, opts=('--no-cache', '-O2', '--verbose',))
+        self.assertIn('message: inlined 4 call(s)', output)
+        self.assertEqual(run(compiled_path), run(optimized_path))
+        self.assertEqual(['25', '29'], run(optimized_path)[1].strip().splitlines())
+
+        disassembly = disassemble(optimized_path)[0].splitlines()
+        self.assertEqual(['.function: sum_of_squares', '.function: log', '.function: main'], [line for line in disassembly if line.startswith('.function:')])
+        self.assertIn('    call 0 log', disassembly)
+
+    def testInlineLimit(self):
+        assembly_path = os.path.join(self.PATH, 'inline.asm')
+        optimized_path = os.path.join(COMPILED_SAMPLES_PATH, 'inline.asm.O2.limited.bin')
+        output, error, exit_code = assemble(assembly_path, optimized_path, opts=('--no-cache', '-O2', '--inline-limit', '2', '--verbose',))
+        self.assertIn('message: inlined 2 call(s)', output)
+        self.assertEqual(['25', '29'], run(optimized_path)[1].strip().splitlines())
+
+
+class SSAOptimizationTests(unittest.TestCase):
+    """Tests for constant propagation, copy propagation and dead code elimination (enabled by -O2).
+    """
+    PATH = './sample/asm/optimizations'
+
+    def testConstantsCopiesAndDeadCode(self):
+        assembly_path = os.path.join(self.PATH, 'ssa.asm')
+        compiled_path = os.path.join(COMPILED_SAMPLES_PATH, 'ssa.asm.bin')
+        optimized_path = os.path.join(COMPILED_SAMPLES_PATH, 'ssa.asm.O2.bin')
+        assemble(assembly_path, compiled_path, opts=('--no-cache',))
+        output, error, exit_code = assemble(assembly_path, optimized_path, opts=('--no-cache', '-O2', '--verbose',))
+        self.assertIn('message: constant propagation: folded 2 instruction(s)', output)
+        self.assertIn('message: copy propagation: replaced 1 operand(s)', output)
+        self.assertIn('message: dead code elimination: removed 10 instruction(s)', output)
+        self.assertEqual(run(compiled_path), run(optimized_path))
+        self.assertEqual(['42', 'big', '0', '1', '2'], run(optimized_path)[1].strip().splitlines())
+
+        disassembly = disassemble(optimized_path)[0].splitlines()
+        self.assertIn('    istore 3 42', disassembly)
+        self.assertNotIn('imul', ' '.join(disassembly))
+        self.assertNotIn('"small"', ' '.join(disassembly))
+        self.assertNotIn('"unused"', ' '.join(disassembly))
+
+    def testFunctionsUsingRegisterReferencesAreNotChanged(self):
+        assembly_path = './sample/asm/registerref.asm'
+        optimized_path = os.path.join(COMPILED_SAMPLES_PATH, 'registerref.asm.O2.bin')
+        output, error, exit_code = assemble(assembly_path, optimized_path, opts=('--no-cache', '-O2', '--verbose',))
+        self.assertIn('message: dead code elimination: removed 0 instruction(s)', output)
+        self.assertEqual(['16', '1', '1', '16'], run(optimized_path)[1].strip().splitlines())
+
+
+class TypeInferenceTests(unittest.TestCase):
+    """Tests for specialization of instructions operating on registers of inferred types (enabled by -O2).
+    """
+    PATH = './sample/asm/optimizations'
+
+    def testInstructionsOnProvenIntegersAreSpecialized(self):
+        assembly_path = os.path.join(self.PATH, 'types.asm')
+        compiled_path = os.path.join(COMPILED_SAMPLES_PATH, 'types.asm.bin')
+        optimized_path = os.path.join(COMPILED_SAMPLES_PATH, 'types.asm.O2.bin')
+        assemble(assembly_path, compiled_path, opts=('--no-cache',))
+        output, error, exit_code = assemble(assembly_path, optimized_path, opts=('--no-cache', '-O2', '--verbose',))
+        self.assertIn('message: type inference: specialized 2 instruction(s)', output)
+        self.assertEqual(run(compiled_path), run(optimized_path))
+        self.assertEqual(['10', '4', '16'], run(optimized_path)[1].strip().splitlines())
+
+        disassembly = disassemble(optimized_path)[0].splitlines()
+        self.assertIn('    tiadd 2 2 3', disassembly)
+        self.assertIn('    ilt 4 3 1', disassembly)
+        self.assertIn('    iadd 4 3 1', disassembly)
+        self.assertIn('    timul 8 7 1', disassembly)
+
+    def testTypedInstructionsCanBeAssembled(self):
+        runTest(self, 'typed.asm', '42')
+
+
 class ExternalModulesTests(unittest.TestCase):
     """Tests for C/C++ module importing, and calling external functions.
     """
@@ -745,6 +1215,69 @@ class StandardRuntimeLibraryModuleString(unittest.TestCase):
     def testRepresentFunction(self):
         runTestCustomAssertsNoDisassemblyRerun(self, 'represent.asm', partiallyAppliedSameLines(2))
 
+class StandardRuntimeLibraryModuleChannel(unittest.TestCase):
+    PATH = './sample/standard_library/channel'
+
+    def testSendingAndReceivingValues(self):
+        runTestSplitlinesNoDisassemblyRerun(self, 'send_receive.asm', ['<Channel of capacity 2>', 'true', '42', 'false', 'Hello World!', '[42]', '[]'])
+
+    def testPassingValuesBetweenProcesses(self):
+        assembly_path = os.path.join(self.PATH, 'processes.asm')
+        compiled_path = os.path.join(COMPILED_SAMPLES_PATH, 'standard_library_channel_processes.bin')
+        assemble(assembly_path, compiled_path)
+        for threads in ('1', '4',):
+            self.assertEqual('5050', run(compiled_path, opts=('--threads', threads,))[1].strip())
+
+class StandardRuntimeLibraryModuleFunctional(unittest.TestCase):
+    PATH = './sample/standard_library/functional'
+
+    def testParallelMapFilterAndReduce(self):
+        assembly_path = os.path.join(self.PATH, 'parallel.asm')
+        compiled_path = os.path.join(COMPILED_SAMPLES_PATH, 'standard_library_functional_parallel.bin')
+        assemble(assembly_path, compiled_path)
+        for threads in ('1', '4',):
+            self.assertEqual(['1000', '1', '1000000', '500', '333833500', '1501500'], run(compiled_path, opts=('--threads', threads,))[1].strip().splitlines())
+
+    def testExceptionClosestToBeginningIsRethrown(self):
+        assembly_path = os.path.join(self.PATH, 'exception.asm')
+        compiled_path = os.path.join(COMPILED_SAMPLES_PATH, 'standard_library_functional_exception.bin')
+        assemble(assembly_path, compiled_path)
+        for threads in ('1', '4',):
+            self.assertEqual('100', run(compiled_path, opts=('--threads', threads,))[1].strip())
+
+class StandardRuntimeLibraryModuleIO(unittest.TestCase):
+    PATH = './sample/standard_library/io'
+
+    def testWaitingForInputDoesNotBlockOtherProcesses(self):
+        assembly_path = os.path.join(self.PATH, 'getline.asm')
+        compiled_path = os.path.join(COMPILED_SAMPLES_PATH, 'standard_library_io_getline.bin')
+        assemble(assembly_path, compiled_path)
+        p = subprocess.Popen(('./build/bin/vm/cpu', compiled_path), stdin=subprocess.PIPE, stdout=subprocess.PIPE, stderr=subprocess.PIPE)
+        time.sleep(0.3)
+        output, error = p.communicate(b'Hello World!\n')
+        self.assertEqual(0, p.wait())
+        self.assertEqual(['counted', 'Hello World!'], output.decode('utf-8').strip().splitlines())
+
+class StandardRuntimeLibraryModuleOS(unittest.TestCase):
+    """Tests for blocking foreign functions which run in background and return futures.
+    """
+    PATH = './sample/standard_library/os'
+
+    def testBlockingCallsOverlap(self):
+        assembly_path = os.path.join(self.PATH, 'overlapped.asm')
+        compiled_path = os.path.join(COMPILED_SAMPLES_PATH, 'standard_library_os_overlapped.bin')
+        assemble(assembly_path, compiled_path)
+        started = time.time()
+        self.assertEqual(['started', '0', '0', '0', '0', 'Future: os::system (resolved)'], run(compiled_path)[1].strip().splitlines())
+        # four commands sleeping for 0.5s each would take 2s if they were run one after another
+        self.assertLess(time.time() - started, 1.5)
+
+    def testWaitTakesReturnedValue(self):
+        runTestNoDisassemblyRerun(self, 'status.asm', '768')
+
+    def testObjectThrownByBlockingCallIsThrownByWait(self):
+        runTestNoDisassemblyRerun(self, 'exception.asm', 'expected command to launch (string) as parameter 0')
+
 
 if __name__ == '__main__':
     if not unittest.main(exit=False).result.wasSuccessful():